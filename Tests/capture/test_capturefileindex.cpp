@@ -0,0 +1,112 @@
+/*  KStars tests
+    Copyright (C) 2021 KStars Team
+
+    This application is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+ */
+
+#include "test_capturefileindex.h"
+
+#include "ekos/capture/capturefileindex.h"
+
+#include <QFile>
+#include <QFileInfo>
+
+TestCaptureFileIndex::TestCaptureFileIndex() : QObject()
+{
+}
+
+TestCaptureFileIndex::~TestCaptureFileIndex()
+{
+}
+
+void TestCaptureFileIndex::touch(const QString &fileName)
+{
+    QFile file(m_Dir.filePath(fileName));
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.close();
+}
+
+void TestCaptureFileIndex::testCount()
+{
+    QVERIFY(m_Dir.isValid());
+    touch("M42_Light_H_Alpha_001.fits");
+    touch("M42_Light_H_Alpha_002.fits");
+    touch("M42_Light_OIII_001.fits");
+    touch("M31_Light_L_001.fits.fz");
+
+    auto index = Ekos::CaptureFileIndex::Instance();
+    QCOMPARE(index->count(m_Dir.path(), "M42_Light_H_Alpha"), 2);
+    QCOMPARE(index->count(m_Dir.path(), "M42_Light_"), 3);
+    QCOMPARE(index->count(m_Dir.path(), "M31_Light_L"), 1);
+    // Counting is case sensitive
+    QCOMPARE(index->count(m_Dir.path(), "m42_Light"), 0);
+    QCOMPARE(index->count(m_Dir.path(), "M33"), 0);
+    QCOMPARE(index->count(m_Dir.path(), ""), 4);
+    QCOMPARE(index->count(m_Dir.filePath("missing"), "M42"), 0);
+}
+
+void TestCaptureFileIndex::testLastSequenceID()
+{
+    auto index = Ekos::CaptureFileIndex::Instance();
+    QCOMPARE(index->lastSequenceID(m_Dir.path(), "M42_Light_H_Alpha"), 2);
+    // Sequence numbers ignore case and the .fits part of compressed files
+    QCOMPARE(index->lastSequenceID(m_Dir.path(), "m31_light_l"), 1);
+    QCOMPARE(index->lastSequenceID(m_Dir.path(), "M33"), -1);
+}
+
+void TestCaptureFileIndex::testExternalChanges()
+{
+    auto index = Ekos::CaptureFileIndex::Instance();
+
+    touch("M42_Light_H_Alpha_010.fits");
+    QCOMPARE(index->count(m_Dir.path(), "M42_Light_H_Alpha"), 3);
+    QCOMPARE(index->lastSequenceID(m_Dir.path(), "M42_Light_H_Alpha"), 10);
+
+    QVERIFY(QFile::remove(m_Dir.filePath("M42_Light_H_Alpha_001.fits")));
+    QCOMPARE(index->count(m_Dir.path(), "M42_Light_H_Alpha"), 2);
+
+    // Once the directory is stable, its listing is reused until it changes again
+    index->setSettleTime(-1);
+    QCOMPARE(index->count(m_Dir.path(), "M42_Light_H_Alpha"), 2);
+    QCOMPARE(index->count(m_Dir.path(), "M42_Light_H_Alpha"), 2);
+    QVERIFY(QFile::remove(m_Dir.filePath("M42_Light_H_Alpha_010.fits")));
+    QCOMPARE(index->count(m_Dir.path(), "M42_Light_H_Alpha"), 1);
+    QCOMPARE(index->lastSequenceID(m_Dir.path(), "M42_Light_H_Alpha"), 2);
+}
+
+void TestCaptureFileIndex::testAdd()
+{
+    auto index = Ekos::CaptureFileIndex::Instance();
+    index->setSettleTime(-1);
+    QCOMPARE(index->count(m_Dir.path(), "M42_Light_H_Alpha"), 1);
+
+    // A file reported by KStars is inserted into the listing without reading the directory again,
+    // which this file that does not exist on disk makes visible
+    const QString added = m_Dir.filePath("M42_Light_H_Alpha_020.fits");
+    index->add(added, QFileInfo(m_Dir.path()).lastModified());
+    QCOMPARE(index->count(m_Dir.path(), "M42_Light_H_Alpha"), 2);
+    QCOMPARE(index->lastSequenceID(m_Dir.path(), "M42_Light_H_Alpha"), 20);
+
+    // Writing the same file again does not count it twice
+    index->add(added, QFileInfo(m_Dir.path()).lastModified());
+    QCOMPARE(index->count(m_Dir.path(), "M42_Light_H_Alpha"), 2);
+
+    // If the directory changed in the meantime, the listing is read again
+    index->add(added, QDateTime());
+    QCOMPARE(index->count(m_Dir.path(), "M42_Light_H_Alpha"), 1);
+    QCOMPARE(index->lastSequenceID(m_Dir.path(), "M42_Light_H_Alpha"), 2);
+
+    // If the directory was modified within the settle time, the listing is read again on the next query
+    index->add(added, QFileInfo(m_Dir.path()).lastModified());
+    QCOMPARE(index->count(m_Dir.path(), "M42_Light_H_Alpha"), 2);
+    index->setSettleTime(24 * 3600 * 1000);
+    index->add(added, QFileInfo(m_Dir.path()).lastModified());
+    QCOMPARE(index->count(m_Dir.path(), "M42_Light_H_Alpha"), 1);
+
+    index->setSettleTime(2000);
+}
+
+QTEST_GUILESS_MAIN(TestCaptureFileIndex)
@@ -0,0 +1,42 @@
+/*  KStars tests
+    Copyright (C) 2021 KStars Team
+
+    This application is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+ */
+
+#ifndef TEST_CAPTUREFILEINDEX_H
+#define TEST_CAPTUREFILEINDEX_H
+
+#include <QtTest/QtTest>
+#include <QDebug>
+#include <QTemporaryDir>
+
+/**
+ * @class TestCaptureFileIndex
+ * @short Tests the counting of captured files in a storage directory
+ */
+
+class TestCaptureFileIndex : public QObject
+{
+        Q_OBJECT
+
+    public:
+        TestCaptureFileIndex();
+        ~TestCaptureFileIndex() override;
+
+    private:
+        void touch(const QString &fileName);
+
+        QTemporaryDir m_Dir;
+
+    private slots:
+        void testCount();
+        void testLastSequenceID();
+        void testExternalChanges();
+        void testAdd();
+};
+
+#endif // TEST_CAPTUREFILEINDEX_H
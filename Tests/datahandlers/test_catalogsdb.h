@@ -101,6 +101,60 @@ class TestCatalogsDB_DBManager : public QObject
         QCOMPARE(obj.name(), objs.front().name());
     }
 
+    void find_by_name_prefix()
+    {
+        const Catalog cat{ m_manager.find_suitable_catalog_id(),
+                           "test",
+                           1,
+                           "tester",
+                           "test catalog",
+                           "testing catalog",
+                           true,
+                           false,
+                           100 };
+
+        QVERIFY(m_manager.register_catalog(cat).first);
+
+        const auto make_object = [](const QString &name, const QString &long_name) {
+            return CatalogObject{ {},        SkyObject::STAR, dms{ 1 }, dms{ 11 }, -1,
+                                  name,      long_name,       "",       10,        11,
+                                  111,       0 };
+        };
+
+        QVERIFY(m_manager
+                    .add_objects(cat.id, { make_object("Qqtest Alpha", "Kappa Cloud"),
+                                           make_object("xqqtestx", "") })
+                    .first);
+
+        const auto names = [&](const QString &query) {
+            QStringList found;
+            for (const auto &obj : m_manager.find_objects_by_name(query, 10))
+                found << obj.name();
+
+            return found;
+        };
+
+        // prefix of the name
+        QCOMPARE(names("qqtest"), QStringList{ "Qqtest Alpha" });
+
+        // prefix of a word of the name and of the long name
+        QVERIFY(names("alph").contains("Qqtest Alpha"));
+        QVERIFY(names("kappa cl").contains("Qqtest Alpha"));
+
+        // substring matches follow the prefix matches
+        QCOMPARE(names("qqtest"), (QStringList{ "Qqtest Alpha", "xqqtestx" }));
+        QCOMPARE(names("qqtestx"), QStringList{ "xqqtestx" });
+        QCOMPARE(m_manager.find_objects_by_name("qqtest", 1).size(), 1);
+
+        // the name index follows added and removed objects
+        const auto added = make_object("Qqtest Beta", "");
+        QVERIFY(m_manager.add_object(cat.id, added).first);
+        QVERIFY(names("beta").contains("Qqtest Beta"));
+
+        QVERIFY(m_manager.remove_object(cat.id, added.getObjectId()).first);
+        QVERIFY(!names("beta").contains("Qqtest Beta"));
+    }
+
     void get_by_id()
     {
         const auto &obj     = some_object();
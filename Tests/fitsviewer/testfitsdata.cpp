@@ -11,6 +11,11 @@
 #include <QtTest>
 #include <memory>
 #include "testfitsdata.h"
+#include "config-kstars.h"
+#ifdef HAVE_STELLARSOLVER
+#include "ekos/auxiliary/stellarsolverprofile.h"
+#include <stellarsolver.h>
+#endif
 
 Q_DECLARE_METATYPE(FITSMode);
 
@@ -138,6 +143,135 @@ void TestFitsData::testBahtinovFocusHFR()
 #endif
 }
 
+void TestFitsData::testWCSInterpolation_data()
+{
+#if QT_VERSION < 0x050900
+    QSKIP("Skipping fixture-based test on old QT version.");
+#else
+    QTest::addColumn<QString>("NAME");
+    QTest::addColumn<double>("RA");
+    QTest::addColumn<double>("DEC");
+    QTest::addColumn<double>("PIXSCALE");
+    QTest::addColumn<bool>("EAST_TO_THE_RIGHT");
+
+    QTest::newRow("M47-NARROW") << "m47_sim_stars.fits" << 114.15 << -14.48 << 1.5 << true;
+    QTest::newRow("M47-WIDE") << "m47_sim_stars.fits" << 114.15 << -14.48 << 60.0 << true;
+    QTest::newRow("M47-WIDE-MIRRORED") << "m47_sim_stars.fits" << 114.15 << -14.48 << 60.0 << false;
+    QTest::newRow("RA-WRAP") << "m47_sim_stars.fits" << 0.01 << 10.0 << 10.0 << true;
+    QTest::newRow("POLE") << "m47_sim_stars.fits" << 37.95 << 89.95 << 5.0 << true;
+#endif
+}
+
+void TestFitsData::testWCSInterpolation()
+{
+#if QT_VERSION < 0x050900
+    QSKIP("Skipping fixture-based test on old QT version.");
+#else
+    QFETCH(QString, NAME);
+    QFETCH(double, RA);
+    QFETCH(double, DEC);
+    QFETCH(double, PIXSCALE);
+    QFETCH(bool, EAST_TO_THE_RIGHT);
+
+    if(!QFile::exists(NAME))
+        QSKIP("Skipping WCS test because of missing fixture");
+
+    std::unique_ptr<FITSData> d(new FITSData(FITS_NORMAL));
+    QVERIFY(d != nullptr);
+
+    QFuture<bool> worker = d->loadFromFile(NAME);
+    QTRY_VERIFY_WITH_TIMEOUT(worker.isFinished(), 10000);
+    QVERIFY(worker.result());
+
+    QVERIFY(d->injectWCS(30, RA, DEC, PIXSCALE, EAST_TO_THE_RIGHT));
+    if (!d->loadWCS())
+        QSKIP("Skipping WCS test because WCS is not supported");
+
+    // Interpolated coordinates must stay within 0.1 pixel of the exact ones, plus the rounding of
+    // the float coordinates, which is below 0.03 pixel for these scales
+    double maxError = 0;
+    for (double y = 0; y < d->height(); y += 7.3)
+    {
+        for (double x = 0; x < d->width(); x += 7.3)
+        {
+            SkyPoint exact;
+            QVERIFY(d->pixelToWCS(QPointF(x, y), exact));
+
+            FITSImage::wcs_point coord;
+            QVERIFY(d->getWCSCoord(x, y, coord));
+
+            SkyPoint a(exact.ra0(), exact.dec0());
+            SkyPoint b(coord.ra / 15.0, coord.dec);
+            maxError = std::max(maxError, a.angularDistanceTo(&b).Degrees() * 3600 / PIXSCALE);
+        }
+    }
+
+    QVERIFY2(maxError < 0.13, qPrintable(QString("Largest WCS interpolation error is %1 pixel").arg(maxError)));
+#endif
+}
+
+void TestFitsData::testStatisticsROI_data()
+{
+#if QT_VERSION < 0x050900
+    QSKIP("Skipping fixture-based test on old QT version.");
+#else
+    QTest::addColumn<QString>("NAME");
+    QTest::addColumn<FITSMode>("MODE");
+
+    QTest::newRow("NGC4535-1-FOCUS") << "ngc4535-autofocus1.fits" << FITS_FOCUS;
+    QTest::newRow("NGC4535-1-GUIDE") << "ngc4535-autofocus1.fits" << FITS_GUIDE;
+#endif
+}
+
+void TestFitsData::testStatisticsROI()
+{
+#if QT_VERSION < 0x050900
+    QSKIP("Skipping fixture-based test on old QT version.");
+#else
+    QFETCH(QString, NAME);
+    QFETCH(FITSMode, MODE);
+
+    if(!QFile::exists(NAME))
+        QSKIP("Skipping load test because of missing fixture");
+
+    std::unique_ptr<FITSData> full(new FITSData(MODE));
+    QFuture<bool> worker = full->loadFromFile(NAME);
+    QTRY_VERIFY_WITH_TIMEOUT(worker.isFinished(), 10000);
+    QVERIFY(worker.result());
+    QVERIFY(!full->hasROIStatistics());
+
+    std::unique_ptr<FITSData> d(new FITSData(MODE));
+    d->setStatisticsROI(QRect(100, 100, 64, 64));
+    worker = d->loadFromFile(NAME);
+    QTRY_VERIFY_WITH_TIMEOUT(worker.isFinished(), 10000);
+    QVERIFY(worker.result());
+
+    // Only the region is evaluated when loading
+    QVERIFY(d->hasROIStatistics());
+    FITSImage::Statistic const &stats = d->getStatistics();
+    QVERIFY(stats.min[0] >= full->getMin());
+    QVERIFY(stats.max[0] <= full->getMax());
+    QVERIFY(stats.min[0] <= stats.median[0] && stats.median[0] <= stats.max[0]);
+    QVERIFY(stats.min[0] <= stats.mean[0] && stats.mean[0] <= stats.max[0]);
+    const FITSImage::Statistic roiStats = stats;
+
+    // The full frame is evaluated as soon as it is read
+    QCOMPARE(d->getMin(), full->getMin());
+    QCOMPARE(d->getMax(), full->getMax());
+    QCOMPARE(d->getMean(), full->getMean());
+    QCOMPARE(d->getMedian(), full->getMedian());
+    QCOMPARE(d->getStdDev(), full->getStdDev());
+
+    // The statistics of the detectors are still those of the region
+    QVERIFY(d->hasROIStatistics());
+    QCOMPARE(d->getStatistics().min[0], roiStats.min[0]);
+    QCOMPARE(d->getStatistics().max[0], roiStats.max[0]);
+    QCOMPARE(d->getStatistics().mean[0], roiStats.mean[0]);
+    QCOMPARE(d->getStatistics().median[0], roiStats.median[0]);
+    QCOMPARE(d->getStatistics().stddev[0], roiStats.stddev[0]);
+#endif
+}
+
 void TestFitsData::initGenericDataFixture()
 {
 #if QT_VERSION < 0x050900
@@ -410,4 +544,108 @@ void TestFitsData::testSEPAlgorithmBenchmark()
 #endif
 }
 
+void TestFitsData::testSEPGuideBenchmark_data()
+{
+#if QT_VERSION < 0x050900
+    QSKIP("Skipping fixture-based test on old QT version.");
+#else
+    initGenericDataFixture();
+#endif
+}
+
+void TestFitsData::testSEPGuideBenchmark()
+{
+#if QT_VERSION < 0x050900
+    QSKIP("Skipping fixture-based test on old QT version.");
+#else
+    QFETCH(QString, NAME);
+    QFETCH(QRect, TRACKING_BOX);
+
+    if(!QFile::exists(NAME))
+        QSKIP("Skipping load test because of missing fixture");
+
+    std::unique_ptr<FITSData> d(new FITSData(FITS_GUIDE));
+    QVERIFY(d != nullptr);
+
+    QFuture<bool> worker = d->loadFromFile(NAME);
+    QTRY_VERIFY_WITH_TIMEOUT(worker.isFinished(), 10000);
+    QVERIFY(worker.result());
+
+    // Same settings as the internal guider uses for each guide frame
+    QVariantMap settings;
+    settings["optionsProfileIndex"] = 0;
+#ifdef HAVE_STELLARSOLVER
+    settings["optionsProfileGroup"] = static_cast<int>(Ekos::GuideProfiles);
+#endif
+    d->setSourceExtractorSettings(settings);
+
+    QVERIFY(d->findStars(ALGORITHM_SEP, TRACKING_BOX).result());
+    auto centers = d->getStarCenters();
+    QCOMPARE(centers.count(), 1);
+    QVERIFY(abs(centers[0]->x - TRACKING_BOX.center().x()) <= 5);
+    QVERIFY(abs(centers[0]->y - TRACKING_BOX.center().y()) <= 5);
+
+    // The extraction of a guide tracking box should take well under 10ms
+    QBENCHMARK { d->findStars(ALGORITHM_SEP, TRACKING_BOX).waitForFinished(); }
+#endif
+}
+
+void TestFitsData::testSEPGuideMatchesStellarSolver_data()
+{
+#if QT_VERSION < 0x050900
+    QSKIP("Skipping fixture-based test on old QT version.");
+#else
+    initGenericDataFixture();
+#endif
+}
+
+void TestFitsData::testSEPGuideMatchesStellarSolver()
+{
+#if QT_VERSION < 0x050900 || !defined(HAVE_STELLARSOLVER)
+    QSKIP("Skipping StellarSolver comparison test.");
+#else
+    QFETCH(QString, NAME);
+    QFETCH(QRect, TRACKING_BOX);
+
+    if(!QFile::exists(NAME))
+        QSKIP("Skipping load test because of missing fixture");
+
+    std::unique_ptr<FITSData> d(new FITSData(FITS_GUIDE));
+    QVERIFY(d != nullptr);
+
+    QFuture<bool> worker = d->loadFromFile(NAME);
+    QTRY_VERIFY_WITH_TIMEOUT(worker.isFinished(), 10000);
+    QVERIFY(worker.result());
+
+    QVariantMap settings;
+    settings["optionsProfileIndex"] = 0;
+    settings["optionsProfileGroup"] = static_cast<int>(Ekos::GuideProfiles);
+    d->setSourceExtractorSettings(settings);
+
+    QVERIFY(d->findStars(ALGORITHM_SEP, TRACKING_BOX).result());
+    auto centers = d->getStarCenters();
+
+    // Extract the same tracking box with StellarSolver and the same guide profile
+    StellarSolver solver(d->getStatistics(), d->getImageBuffer());
+    solver.setParameters(Ekos::getDefaultGuideOptionsProfiles().at(0));
+    QSignalSpy finished(&solver, &StellarSolver::finished);
+    solver.extract(true, TRACKING_BOX);
+    if (finished.isEmpty())
+        QVERIFY(finished.wait(10000));
+    QList<FITSImage::Star> stars = solver.getStarList();
+
+    QCOMPARE(centers.count(), stars.count());
+    for (auto const &star : stars)
+    {
+        auto const closest = std::min_element(centers.cbegin(), centers.cend(), [&star](Edge const * e1, Edge const * e2)
+        {
+            return std::hypot(e1->x - star.x, e1->y - star.y) < std::hypot(e2->x - star.x, e2->y - star.y);
+        });
+        QVERIFY(closest != centers.cend());
+        QVERIFY(std::abs((*closest)->x - star.x) < 0.01);
+        QVERIFY(std::abs((*closest)->y - star.y) < 0.01);
+    }
+#endif
+}
+
 QTEST_GUILESS_MAIN(TestFitsData)
@@ -45,11 +45,23 @@ class TestFitsData : public QObject
         void testSEPAlgorithmBenchmark_data();
         void testSEPAlgorithmBenchmark();
 
+        void testSEPGuideBenchmark_data();
+        void testSEPGuideBenchmark();
+
+        void testSEPGuideMatchesStellarSolver_data();
+        void testSEPGuideMatchesStellarSolver();
+
         void testComputeHFR_data();
         void testComputeHFR();
 
         void testBahtinovFocusHFR_data();
         void testBahtinovFocusHFR();
+
+        void testWCSInterpolation_data();
+        void testWCSInterpolation();
+
+        void testStatisticsROI_data();
+        void testStatisticsROI();
 };
 
 #endif // TESTFITSDATA_H
@@ -0,0 +1,510 @@
+/*  Guide star centroid test.
+
+    This application is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+ */
+
+#include "ekos/guide/internalguide/gmath.h"
+
+#include <QtTest>
+
+#include <QObject>
+
+#include <fitsio.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+// Compares the "Fast" (CENTROID_THRESHOLD) and "Smart" (SMART_THRESHOLD) star finders of cgmath
+// with the straightforward implementations they replaced, on synthetic frames and on a fixture frame,
+// and benchmarks both.
+
+class TestGuideCentroid : public QObject
+{
+        Q_OBJECT
+
+    public:
+        /** @short Constructor */
+        TestGuideCentroid();
+
+        /** @short Destructor */
+        ~TestGuideCentroid() override = default;
+
+    private slots:
+        void syntheticTest();
+        void fixtureTest();
+        void benchmarkCentroid_data();
+        void benchmarkCentroid();
+};
+
+#include "testguidecentroid.moc"
+
+TestGuideCentroid::TestGuideCentroid() : QObject()
+{
+}
+
+namespace
+{
+
+typedef struct
+{
+    int x, y;
+} point_t;
+
+// The "Fast" star finder as it was, evaluating the whole 9x9 kernel at each position of the tracking box.
+template <typename T>
+Vector baselineCentroidThreshold(T const *pdata, int video_width, const QRect &trackingBox)
+{
+    static const double P0 = 0.906, P1 = 0.584, P2 = 0.365, P3 = 0.117, P4 = 0.049, P5 = -0.05, P6 = -0.064, P7 = -0.074,
+                        P8 = -0.094;
+
+    T const *psrc = pdata + trackingBox.y() * video_width + trackingBox.x();
+    int width  = trackingBox.width();
+    int height = trackingBox.width();
+    float i0, i1, i2, i3, i4, i5, i6, i7, i8;
+    int ix = 0, iy = 0;
+    int xM4;
+    T const *p;
+    double average, fit, bestFit = 0;
+    for (int x = 0; x < width; x++)
+    {
+        for (int y = 0; y < height; y++)
+        {
+            i0 = i1 = i2 = i3 = i4 = i5 = i6 = i7 = i8 = 0;
+            xM4                                           = x - 4;
+            p                                             = psrc + (y - 4) * video_width + xM4;
+            i8 += *p++;
+            i8 += *p++;
+            i8 += *p++;
+            i8 += *p++;
+            i8 += *p++;
+            i8 += *p++;
+            i8 += *p++;
+            i8 += *p++;
+            i8 += *p++;
+            p = psrc + (y - 3) * video_width + xM4;
+            i8 += *p++;
+            i8 += *p++;
+            i8 += *p++;
+            i7 += *p++;
+            i6 += *p++;
+            i7 += *p++;
+            i8 += *p++;
+            i8 += *p++;
+            i8 += *p++;
+            p = psrc + (y - 2) * video_width + xM4;
+            i8 += *p++;
+            i8 += *p++;
+            i5 += *p++;
+            i4 += *p++;
+            i3 += *p++;
+            i4 += *p++;
+            i5 += *p++;
+            i8 += *p++;
+            i8 += *p++;
+            p = psrc + (y - 1) * video_width + xM4;
+            i8 += *p++;
+            i7 += *p++;
+            i4 += *p++;
+            i2 += *p++;
+            i1 += *p++;
+            i2 += *p++;
+            i4 += *p++;
+            i8 += *p++;
+            i8 += *p++;
+            p = psrc + (y + 0) * video_width + xM4;
+            i8 += *p++;
+            i6 += *p++;
+            i3 += *p++;
+            i1 += *p++;
+            i0 += *p++;
+            i1 += *p++;
+            i3 += *p++;
+            i6 += *p++;
+            i8 += *p++;
+            p = psrc + (y + 1) * video_width + xM4;
+            i8 += *p++;
+            i7 += *p++;
+            i4 += *p++;
+            i2 += *p++;
+            i1 += *p++;
+            i2 += *p++;
+            i4 += *p++;
+            i8 += *p++;
+            i8 += *p++;
+            p = psrc + (y + 2) * video_width + xM4;
+            i8 += *p++;
+            i8 += *p++;
+            i5 += *p++;
+            i4 += *p++;
+            i3 += *p++;
+            i4 += *p++;
+            i5 += *p++;
+            i8 += *p++;
+            i8 += *p++;
+            p = psrc + (y + 3) * video_width + xM4;
+            i8 += *p++;
+            i8 += *p++;
+            i8 += *p++;
+            i7 += *p++;
+            i6 += *p++;
+            i7 += *p++;
+            i8 += *p++;
+            i8 += *p++;
+            i8 += *p++;
+            p = psrc + (y + 4) * video_width + xM4;
+            i8 += *p++;
+            i8 += *p++;
+            i8 += *p++;
+            i8 += *p++;
+            i8 += *p++;
+            i8 += *p++;
+            i8 += *p++;
+            i8 += *p++;
+            i8 += *p++;
+            average = (i0 + i1 + i2 + i3 + i4 + i5 + i6 + i7 + i8) / 85.0;
+            fit     = P0 * (i0 - average) + P1 * (i1 - 4 * average) + P2 * (i2 - 4 * average) +
+                      P3 * (i3 - 4 * average) + P4 * (i4 - 8 * average) + P5 * (i5 - 4 * average) +
+                      P6 * (i6 - 4 * average) + P7 * (i7 - 8 * average) + P8 * (i8 - 48 * average);
+            if (bestFit < fit)
+            {
+                bestFit = fit;
+                ix      = x;
+                iy      = y;
+            }
+        }
+    }
+
+    if (bestFit > 50)
+    {
+        double sumX  = 0;
+        double sumY  = 0;
+        double total = 0;
+        for (int y = iy - 4; y <= iy + 4; y++)
+        {
+            p = psrc + y * width + ix - 4;
+            for (int x = ix - 4; x <= ix + 4; x++)
+            {
+                double w = *p++;
+                sumX += x * w;
+                sumY += y * w;
+                total += w;
+            }
+        }
+        if (total > 0)
+            return (Vector(trackingBox.x(), trackingBox.y(), 0) + Vector(sumX / total, sumY / total, 0));
+    }
+
+    return Vector(-1, -1, -1);
+}
+
+// The "Smart" star finder as it was.
+template <typename T>
+Vector baselineSmartThreshold(T const *pdata, int video_width, int video_height, const QRect &trackingBox)
+{
+    int i, j;
+    double resx = 0, resy = 0, mass = 0, threshold = 0, pval;
+    T const *pptr;
+    T const *psrc    = pdata + trackingBox.y() * video_width + trackingBox.x();
+    T const *porigin = psrc;
+
+    point_t bbox_lt = { trackingBox.x() - SMART_FRAME_WIDTH, trackingBox.y() - SMART_FRAME_WIDTH };
+    point_t bbox_rb = { trackingBox.x() + trackingBox.width() + SMART_FRAME_WIDTH,
+                        trackingBox.y() + trackingBox.width() + SMART_FRAME_WIDTH
+                      };
+    int offset = 0;
+
+    // clip frame
+    if (bbox_lt.x < 0)
+        bbox_lt.x = 0;
+    if (bbox_lt.y < 0)
+        bbox_lt.y = 0;
+    if (bbox_rb.x > video_width)
+        bbox_rb.x = video_width;
+    if (bbox_rb.y > video_height)
+        bbox_rb.y = video_height;
+
+    // calc top bar
+    int box_wd  = bbox_rb.x - bbox_lt.x;
+    int box_ht  = trackingBox.y() - bbox_lt.y;
+    int pix_cnt = 0;
+    if (box_wd > 0 && box_ht > 0)
+    {
+        pix_cnt += box_wd * box_ht;
+        for (j = bbox_lt.y; j < trackingBox.y(); ++j)
+        {
+            offset = j * video_width;
+            for (i = bbox_lt.x; i < bbox_rb.x; ++i)
+            {
+                pptr = pdata + offset + i;
+                threshold += *pptr;
+            }
+        }
+    }
+    // calc left bar
+    box_wd = trackingBox.x() - bbox_lt.x;
+    box_ht = trackingBox.width();
+    if (box_wd > 0 && box_ht > 0)
+    {
+        pix_cnt += box_wd * box_ht;
+        for (j = trackingBox.y(); j < trackingBox.y() + box_ht; ++j)
+        {
+            offset = j * video_width;
+            for (i = bbox_lt.x; i < trackingBox.x(); ++i)
+            {
+                pptr = pdata + offset + i;
+                threshold += *pptr;
+            }
+        }
+    }
+    // calc right bar
+    box_wd = bbox_rb.x - trackingBox.x() - trackingBox.width();
+    box_ht = trackingBox.width();
+    if (box_wd > 0 && box_ht > 0)
+    {
+        pix_cnt += box_wd * box_ht;
+        for (j = trackingBox.y(); j < trackingBox.y() + box_ht; ++j)
+        {
+            offset = j * video_width;
+            for (i = trackingBox.x() + trackingBox.width(); i < bbox_rb.x; ++i)
+            {
+                pptr = pdata + offset + i;
+                threshold += *pptr;
+            }
+        }
+    }
+    // calc bottom bar
+    box_wd = bbox_rb.x - bbox_lt.x;
+    box_ht = bbox_rb.y - trackingBox.y() - trackingBox.width();
+    if (box_wd > 0 && box_ht > 0)
+    {
+        pix_cnt += box_wd * box_ht;
+        for (j = trackingBox.y() + trackingBox.width(); j < bbox_rb.y; ++j)
+        {
+            offset = j * video_width;
+            for (i = bbox_lt.x; i < bbox_rb.x; ++i)
+            {
+                pptr = pdata + offset + i;
+                threshold += *pptr;
+            }
+        }
+    }
+    // find maximum
+    double max_val = 0;
+    for (j = 0; j < trackingBox.width(); ++j)
+    {
+        for (i = 0; i < trackingBox.width(); ++i)
+        {
+            pptr = psrc + i;
+            if (*pptr > max_val)
+                max_val = *pptr;
+        }
+        psrc += video_width;
+    }
+    if (pix_cnt != 0)
+        threshold /= (double)pix_cnt;
+
+    // cut by 10% higher then average threshold
+    if (max_val > threshold)
+        threshold += (max_val - threshold) * SMART_CUT_FACTOR;
+
+    psrc = porigin;
+    for (j = 0; j < trackingBox.width(); ++j)
+    {
+        for (i = 0; i < trackingBox.width(); ++i)
+        {
+            pval = psrc[i] - threshold;
+            pval = pval < 0 ? 0 : pval;
+
+            resx += (double)i * pval;
+            resy += (double)j * pval;
+
+            mass += pval;
+        }
+        psrc += video_width;
+    }
+
+    if (mass == 0)
+        mass = 1;
+
+    resx /= mass;
+    resy /= mass;
+
+    return Vector(trackingBox.x(), trackingBox.y(), 0) + Vector(resx, resy, 0);
+}
+
+struct Frame
+{
+    int width { 0 };
+    int height { 0 };
+};
+
+// A frame of gaussian stars on a noisy background.
+template <typename T>
+std::vector<T> syntheticFrame(int width, int height, unsigned seed, double peak, double background, double noise)
+{
+    std::mt19937 generator(seed);
+    std::normal_distribution<double> noiseDistribution(0, noise);
+    std::uniform_real_distribution<double> uniform(0, 1);
+
+    struct Star
+    {
+        double x, y, peak;
+    };
+    std::vector<Star> stars;
+    for (int i = 0; i < 30; i++)
+        stars.push_back({ uniform(generator) * width, uniform(generator) * height, uniform(generator) * peak });
+
+    std::vector<T> image(width * height);
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            double value = background + noiseDistribution(generator);
+            for (const auto &star : stars)
+            {
+                const double d2 = (x - star.x) * (x - star.x) + (y - star.y) * (y - star.y);
+                if (d2 < 100)
+                    value += star.peak * std::exp(-d2 / 4.0);
+            }
+            value = std::max(0.0, std::min(value, double(std::numeric_limits<T>::max())));
+            image[y * width + x] = static_cast<T>(std::is_integral<T>::value ? std::round(value) : value);
+        }
+    }
+    return image;
+}
+
+// Reads the first plane of a 16-bit FITS fixture.
+bool readFixture(const QString &filename, std::vector<uint16_t> *image, Frame *frame)
+{
+    fitsfile *fptr = nullptr;
+    int status = 0;
+    if (fits_open_diskfile(&fptr, filename.toLocal8Bit().constData(), READONLY, &status))
+        return false;
+
+    long naxes[2] = { 0, 0 };
+    int naxis = 0;
+    if (fits_get_img_dim(fptr, &naxis, &status) || naxis != 2 || fits_get_img_size(fptr, 2, naxes, &status))
+    {
+        fits_close_file(fptr, &status);
+        return false;
+    }
+
+    image->resize(naxes[0] * naxes[1]);
+    int anynull = 0;
+    uint16_t nullValue = 0;
+    fits_read_img(fptr, TUSHORT, 1, image->size(), &nullValue, image->data(), &anynull, &status);
+    fits_close_file(fptr, &status);
+
+    frame->width  = naxes[0];
+    frame->height = naxes[1];
+    return status == 0;
+}
+
+// Compares both star finders with their baseline on tracking boxes spread over the frame.
+// The kernel reads 4 pixels around the box, and the Smart background frame is clipped to the image.
+template <typename T>
+void compareFinders(const std::vector<T> &image, const Frame &frame, int stepX, int stepY)
+{
+    int boxes = 0;
+    for (int size : { 16, 32, 64, 128 })
+    {
+        for (int x = 4; x + size + 4 <= frame.width; x += stepX)
+        {
+            for (int y = 4; y + size + 4 <= frame.height; y += stepY)
+            {
+                const QRect box(x, y, size, size);
+                const Vector fast     = cgmath::findCentroidThreshold(image.data(), frame.width, box);
+                const Vector expected = baselineCentroidThreshold(image.data(), frame.width, box);
+                QVERIFY2(fast.x == expected.x && fast.y == expected.y && fast.z == expected.z,
+                         qPrintable(QString("Fast centroid of box (%1, %2, %3): (%4, %5) instead of (%6, %7)")
+                                    .arg(x).arg(y).arg(size).arg(fast.x, 0, 'g', 17).arg(fast.y, 0, 'g', 17)
+                                    .arg(expected.x, 0, 'g', 17).arg(expected.y, 0, 'g', 17)));
+
+                const Vector smart         = cgmath::findSmartThreshold(image.data(), frame.width, frame.height, box);
+                const Vector expectedSmart = baselineSmartThreshold(image.data(), frame.width, frame.height, box);
+                QVERIFY2(smart.x == expectedSmart.x && smart.y == expectedSmart.y && smart.z == expectedSmart.z,
+                         qPrintable(QString("Smart centroid of box (%1, %2, %3): (%4, %5) instead of (%6, %7)")
+                                    .arg(x).arg(y).arg(size).arg(smart.x, 0, 'g', 17).arg(smart.y, 0, 'g', 17)
+                                    .arg(expectedSmart.x, 0, 'g', 17).arg(expectedSmart.y, 0, 'g', 17)));
+                boxes++;
+            }
+        }
+    }
+    QVERIFY(boxes > 0);
+}
+
+}  // namespace
+
+void TestGuideCentroid::syntheticTest()
+{
+    const Frame frame { 400, 300 };
+    for (unsigned seed = 1; seed <= 5; seed++)
+    {
+        compareFinders(syntheticFrame<uint16_t>(frame.width, frame.height, seed, 30000, 1000, 50), frame, 37, 41);
+        compareFinders(syntheticFrame<uint16_t>(frame.width, frame.height, seed, 300, 1000, 50), frame, 37, 41);
+        compareFinders(syntheticFrame<uint8_t>(frame.width, frame.height, seed, 200, 20, 5), frame, 37, 41);
+        compareFinders(syntheticFrame<float>(frame.width, frame.height, seed, 30000, 1000, 50), frame, 37, 41);
+    }
+}
+
+void TestGuideCentroid::fixtureTest()
+{
+    std::vector<uint16_t> image;
+    Frame frame;
+    QVERIFY(readFixture("m47_sim_stars.fits", &image, &frame));
+    compareFinders(image, frame, 61, 67);
+}
+
+void TestGuideCentroid::benchmarkCentroid_data()
+{
+    QTest::addColumn<bool>("smart");
+    QTest::addColumn<bool>("baseline");
+    QTest::addColumn<int>("size");
+
+    for (int size : { 32, 64, 128 })
+    {
+        QTest::newRow(qPrintable(QString("Fast baseline %1").arg(size))) << false << true << size;
+        QTest::newRow(qPrintable(QString("Fast %1").arg(size))) << false << false << size;
+        QTest::newRow(qPrintable(QString("Smart baseline %1").arg(size))) << true << true << size;
+        QTest::newRow(qPrintable(QString("Smart %1").arg(size))) << true << false << size;
+    }
+}
+
+void TestGuideCentroid::benchmarkCentroid()
+{
+    QFETCH(bool, smart);
+    QFETCH(bool, baseline);
+    QFETCH(int, size);
+
+    std::vector<uint16_t> image;
+    Frame frame;
+    QVERIFY(readFixture("m47_sim_stars.fits", &image, &frame));
+    const QRect box((frame.width - size) / 2, (frame.height - size) / 2, size, size);
+
+    Vector result;
+    if (smart && baseline)
+    {
+        QBENCHMARK { result = baselineSmartThreshold(image.data(), frame.width, frame.height, box); }
+    }
+    else if (smart)
+    {
+        QBENCHMARK { result = cgmath::findSmartThreshold(image.data(), frame.width, frame.height, box); }
+    }
+    else if (baseline)
+    {
+        QBENCHMARK { result = baselineCentroidThreshold(image.data(), frame.width, box); }
+    }
+    else
+    {
+        QBENCHMARK { result = cgmath::findCentroidThreshold(image.data(), frame.width, box); }
+    }
+    QVERIFY(result.x >= -1);
+}
+
+QTEST_GUILESS_MAIN(TestGuideCentroid)
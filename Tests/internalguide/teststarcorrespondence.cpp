@@ -27,6 +27,8 @@ class TestStarCorrespondence : public QObject
 
     private slots:
         void basicTest();
+        void benchmarkFind_data();
+        void benchmarkFind();
 };
 
 #include "teststarcorrespondence.moc"
@@ -197,11 +199,111 @@ void runAdaptationTest()
     QVERIFY(fabs(c.reference(1).y - y1) < .0001);
 }
 
+// With two copies of the reference stars in view, the guide star is looked for
+// where it was last found, and elsewhere only when it isn't there.
+void runTrackingTest()
+{
+    QList<Edge> references;
+    references.append(makeEdge(600, 100));
+    references.append(makeEdge(620, 130));
+    references.append(makeEdge(650, 90));
+    references.append(makeEdge(590, 160));
+    references.append(makeEdge(640, 170));
+    StarCorrespondence c(references, 0);
+    c.setImageSize(1000, 400);
+    QVector<int> output;
+
+    // A copy of the references 400 pixels to the left, and the references moved by 2,1.
+    // Both match exactly, but the left copy is far from the guide star.
+    QList<Edge> stars;
+    for (const auto &ref : references)
+        stars.append(makeEdge(ref.x - 400, ref.y));
+    for (const auto &ref : references)
+        stars.append(makeEdge(ref.x + 2, ref.y + 1));
+    Vector position = c.find(stars, 5.0, &output, false);
+    QVERIFY2(position.x == 602 && position.y == 101, "near copy");
+    for (int i = 0; i < stars.size(); ++i)
+        QVERIFY2(output[i] == (i < 5 ? -1 : i - 5), "near copy");
+
+    // The stars drift by a few more pixels.
+    for (int i = 5; i < stars.size(); ++i)
+    {
+        stars[i].x += 8;
+        stars[i].y += 6;
+    }
+    position = c.find(stars, 5.0, &output, false);
+    QVERIFY2(position.x == 610 && position.y == 107, "drift");
+
+    // Without the near copy, the far one is found.
+    stars = stars.mid(0, 5);
+    position = c.find(stars, 5.0, &output, false);
+    QVERIFY2(position.x == 200 && position.y == 100, "far copy");
+    for (int i = 0; i < stars.size(); ++i)
+        QVERIFY2(output[i] == i, "far copy");
+}
+
 void TestStarCorrespondence::basicTest()
 {
     for (int i = 0; i < 6; ++i)
         runTest(i);
     runAdaptationTest();
+    runTrackingTest();
+}
+
+void TestStarCorrespondence::benchmarkFind_data()
+{
+    QTest::addColumn<int>("NUM_STARS");
+    QTest::addColumn<bool>("JUMP");
+
+    for (int numStars : {25, 50, 100, 200, 400})
+    {
+        QTest::newRow(QString("%1 stars").arg(numStars).toLatin1()) << numStars << false;
+        QTest::newRow(QString("%1 stars, jumping").arg(numStars).toLatin1()) << numStars << true;
+    }
+}
+
+// Times the matching of a whole field of stars, all of them references, to a shifted
+// and slightly noisy copy of that field, which then moves back and forth.
+// Only the stars near where the guide star was last found are tried as the guide star,
+// unless the field jumps farther than that, when all the stars are tried.
+void TestStarCorrespondence::benchmarkFind()
+{
+    QFETCH(int, NUM_STARS);
+    QFETCH(bool, JUMP);
+    constexpr int width = 2000, height = 1500;
+    constexpr int guideStar = 0;
+
+    srand(NUM_STARS);
+    QList<Edge> references, stars;
+    for (int i = 0; i < NUM_STARS; ++i)
+    {
+        const double x = 50 + rand() % (width - 100);
+        const double y = 50 + rand() % (height - 100);
+        references.append(makeEdge(x, y));
+        stars.append(makeEdge(x + 3 + ((rand() % 100) - 50) / 100.0, y - 2 + ((rand() % 100) - 50) / 100.0));
+    }
+
+    QList<Edge> movedStars;
+    const double move = JUMP ? 60 : 2;
+    for (const auto &star : stars)
+        movedStars.append(makeEdge(star.x + move, star.y + move));
+
+    StarCorrespondence c(references, guideStar);
+    c.setImageSize(width, height);
+    QVector<int> output;
+
+    Vector position = c.find(stars, 5.0, &output, false);
+    QCOMPARE(position.x, static_cast<double>(stars[guideStar].x));
+    QCOMPARE(position.y, static_cast<double>(stars[guideStar].y));
+    position = c.find(movedStars, 5.0, &output, false);
+    QCOMPARE(position.x, static_cast<double>(movedStars[guideStar].x));
+    QCOMPARE(position.y, static_cast<double>(movedStars[guideStar].y));
+
+    QBENCHMARK
+    {
+        c.find(stars, 5.0, &output, false);
+        c.find(movedStars, 5.0, &output, false);
+    }
 }
 
 QTEST_GUILESS_MAIN(TestStarCorrespondence)
@@ -0,0 +1,219 @@
+/*
+    This application is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+ */
+
+#include "test_projectors.h"
+
+#include "projections/azimuthalequidistantprojector.h"
+#include "projections/equirectangularprojector.h"
+#include "projections/gnomonicprojector.h"
+#include "projections/lambertprojector.h"
+#include "projections/orthographicprojector.h"
+#include "projections/stereographicprojector.h"
+
+#include <QtTest>
+
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <random>
+#include <vector>
+
+namespace
+{
+
+constexpr int NUM_POINTS = 20000;
+
+std::unique_ptr<Projector> makeProjector(Projector::Projection projection, const ViewParams &vp)
+{
+    switch (projection)
+    {
+        case Projector::Lambert:
+            return std::unique_ptr<Projector>(new LambertProjector(vp));
+        case Projector::AzimuthalEquidistant:
+            return std::unique_ptr<Projector>(new AzimuthalEquidistantProjector(vp));
+        case Projector::Orthographic:
+            return std::unique_ptr<Projector>(new OrthographicProjector(vp));
+        case Projector::Equirectangular:
+            return std::unique_ptr<Projector>(new EquirectangularProjector(vp));
+        case Projector::Stereographic:
+            return std::unique_ptr<Projector>(new StereographicProjector(vp));
+        case Projector::Gnomonic:
+            return std::unique_ptr<Projector>(new GnomonicProjector(vp));
+        default:
+            return nullptr;
+    }
+}
+
+// Points spread uniformly over the sphere, in both coordinate systems.
+// The last one has invalid coordinates.
+std::vector<SkyPoint> randomPoints(int count)
+{
+    std::mt19937 generator(count);
+    std::uniform_real_distribution<double> longitude(0, 360), sine(-1, 1);
+
+    std::vector<SkyPoint> points(count);
+    for (int i = 0; i < count - 1; ++i)
+    {
+        points[i] = SkyPoint(CachingDms(longitude(generator)), CachingDms(asin(sine(generator)) / dms::DegToRad));
+        points[i].setAz(longitude(generator));
+        points[i].setAlt(asin(sine(generator)) / dms::DegToRad);
+    }
+    const double nan = std::numeric_limits<double>::quiet_NaN();
+    points[count - 1] = SkyPoint(CachingDms(nan), CachingDms(nan));
+    points[count - 1].setAz(nan);
+    points[count - 1].setAlt(nan);
+    return points;
+}
+
+// Positions of the hidden points may be infinite or NaN, those must match too
+bool samePosition(float a, float b)
+{
+    return a == b || (std::isnan(a) && std::isnan(b));
+}
+
+void addProjectionRows(bool benchmark)
+{
+    const QMetaEnum projections = QMetaEnum::fromType<Projector::Projection>();
+    for (int p = Projector::Lambert; p < Projector::UnknownProjection; ++p)
+    {
+        for (bool altAz : { false, true })
+        {
+            for (bool refraction : { false, true })
+            {
+                // Refraction only applies to horizontal coordinates
+                if (benchmark && refraction && !altAz)
+                    continue;
+
+                const QString name = QString("%1 %2%3").arg(projections.valueToKey(p))
+                                     .arg(altAz ? "alt-az" : "equatorial").arg(refraction ? " refracted" : "");
+                if (benchmark)
+                {
+                    QTest::newRow(qPrintable(name + " one by one")) << p << altAz << refraction << false;
+                    QTest::newRow(qPrintable(name + " at once")) << p << altAz << refraction << true;
+                }
+                else
+                    QTest::newRow(qPrintable(name)) << p << altAz << refraction;
+            }
+        }
+    }
+}
+
+ViewParams makeViewParams(SkyPoint *focus, bool altAz, bool refraction)
+{
+    ViewParams vp;
+    vp.width         = 1600;
+    vp.height        = 1200;
+    vp.zoomFactor    = 600;
+    vp.useAltAz      = altAz;
+    vp.useRefraction = refraction;
+    vp.fillGround    = false;
+    vp.focus         = focus;
+    return vp;
+}
+
+}  // namespace
+
+TestProjectors::TestProjectors() : QObject()
+{
+}
+
+void TestProjectors::compareToScreenVecs_data()
+{
+    QTest::addColumn<int>("projection");
+    QTest::addColumn<bool>("altAz");
+    QTest::addColumn<bool>("refraction");
+
+    addProjectionRows(false);
+}
+
+void TestProjectors::compareToScreenVecs()
+{
+    QFETCH(int, projection);
+    QFETCH(bool, altAz);
+    QFETCH(bool, refraction);
+
+    SkyPoint focus(CachingDms(83.8), CachingDms(-5.4));
+    focus.setAz(137.5);
+    focus.setAlt(31.2);
+    const std::unique_ptr<Projector> projector =
+        makeProjector(static_cast<Projector::Projection>(projection), makeViewParams(&focus, altAz, refraction));
+    QVERIFY(projector);
+
+    std::vector<SkyPoint> points = randomPoints(NUM_POINTS);
+    std::vector<const SkyPoint *> pointers;
+    for (const SkyPoint &point : points)
+        pointers.push_back(&point);
+
+    // Both refraction arguments, the projector only refracts if both are set
+    for (bool oRefract : { false, true })
+    {
+        std::vector<Vector2f> screen(NUM_POINTS);
+        // Flags that are not set must be left alone by both
+        std::unique_ptr<bool[]> visible(new bool[NUM_POINTS]);
+        for (int i = 0; i < NUM_POINTS; ++i)
+            visible[i] = i % 2;
+        projector->toScreenVecs(pointers.data(), NUM_POINTS, screen.data(), oRefract, visible.get());
+
+        for (int i = 0; i < NUM_POINTS; ++i)
+        {
+            bool isVisible = i % 2;
+            const Vector2f expected = projector->toScreenVec(pointers[i], oRefract, &isVisible);
+            QVERIFY2(samePosition(screen[i].x(), expected.x()) && samePosition(screen[i].y(), expected.y()),
+                     qPrintable(QString("Point %1 projected to %2, %3 instead of %4, %5").arg(i)
+                                .arg(screen[i].x(), 0, 'g', 9).arg(screen[i].y(), 0, 'g', 9)
+                                .arg(expected.x(), 0, 'g', 9).arg(expected.y(), 0, 'g', 9)));
+            QCOMPARE(visible[i], isVisible);
+        }
+    }
+}
+
+void TestProjectors::benchmarkToScreen_data()
+{
+    QTest::addColumn<int>("projection");
+    QTest::addColumn<bool>("altAz");
+    QTest::addColumn<bool>("refraction");
+    QTest::addColumn<bool>("atOnce");
+
+    addProjectionRows(true);
+}
+
+void TestProjectors::benchmarkToScreen()
+{
+    QFETCH(int, projection);
+    QFETCH(bool, altAz);
+    QFETCH(bool, refraction);
+    QFETCH(bool, atOnce);
+
+    SkyPoint focus(CachingDms(83.8), CachingDms(-5.4));
+    focus.setAz(137.5);
+    focus.setAlt(31.2);
+    const std::unique_ptr<Projector> projector =
+        makeProjector(static_cast<Projector::Projection>(projection), makeViewParams(&focus, altAz, refraction));
+    QVERIFY(projector);
+
+    std::vector<SkyPoint> points = randomPoints(NUM_POINTS);
+    std::vector<const SkyPoint *> pointers;
+    for (const SkyPoint &point : points)
+        pointers.push_back(&point);
+    std::vector<Vector2f> screen(NUM_POINTS);
+    std::unique_ptr<bool[]> visible(new bool[NUM_POINTS]);
+
+    if (atOnce)
+    {
+        QBENCHMARK { projector->toScreenVecs(pointers.data(), NUM_POINTS, screen.data(), true, visible.get()); }
+    }
+    else
+    {
+        QBENCHMARK
+        {
+            for (int i = 0; i < NUM_POINTS; ++i)
+                screen[i] = projector->toScreenVec(pointers[i], true, &visible[i]);
+        }
+    }
+}
+
+QTEST_GUILESS_MAIN(TestProjectors)
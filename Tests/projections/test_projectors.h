@@ -0,0 +1,33 @@
+/*
+    This application is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+ */
+
+#pragma once
+
+#include <QObject>
+
+/**
+ * @class TestProjectors
+ * @short Tests that projecting many points at once gives the same positions as projecting them one by one
+ */
+class TestProjectors : public QObject
+{
+        Q_OBJECT
+
+    public:
+        /** @short Constructor */
+        TestProjectors();
+
+        /** @short Destructor */
+        ~TestProjectors() override = default;
+
+    private slots:
+        void compareToScreenVecs_data();
+        void compareToScreenVecs();
+
+        void benchmarkToScreen_data();
+        void benchmarkToScreen();
+};
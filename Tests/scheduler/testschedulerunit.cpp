@@ -17,6 +17,7 @@
 #include "indi/indiproperty.h"
 #include "ekos/capture/sequencejob.h"
 #include "ekos/capture/placeholderpath.h"
+#include "skyobjects/ksmoon.h"
 #include "Options.h"
 
 #include <QtTest>
@@ -46,6 +47,8 @@ class TestSchedulerUnit : public QObject
         void estimateJobTimeTest();
         void calculateJobScoreTest();
         void evaluateJobsTest();
+        void calculateAltitudeTimeTest();
+        void evaluateJobsBenchmark();
 
     private:
         void runSetupJob(SchedulerJob &job,
@@ -55,6 +58,7 @@ class TestSchedulerUnit : public QObject
                          int16_t sOffset, SchedulerJob::CompletionCondition eCond, const QDateTime &eTime, int eReps,
                          double minAlt, double minMoonSep = 0, bool enforceWeather = false, bool enforceTwilight = true,
                          bool track = true, bool focus = true, bool align = true, bool guide = true);
+        QDateTime scanAltitudeTime(const SchedulerJob &job, const KStarsDateTime &ltWhen, bool withMoon);
 };
 
 #include "testschedulerunit.moc"
@@ -94,6 +98,10 @@ struct CaptureJobDetails
 
 // This sequence corresponds to the contents of the sequence file 9filters.esq.
 const QString seqFile9Filters = "9filters.esq";
+
+// This schedule holds 100 synthetic jobs spread over the sky, all using 9filters.esq.
+// A third of them have a Moon separation constraint.
+const QString schedFile100Jobs = "synthetic_100_jobs.esl";
 QList<CaptureJobDetails> details9Filters =
 {
     {"Luminance", 6,  60.0, FRAME_LIGHT},
@@ -698,4 +706,205 @@ void TestSchedulerUnit::evaluateJobsTest()
     sortedJobs.clear();
 }
 
+// The old per-minute search of SchedulerJob::calculateAltitudeTime(), used as reference for the analytic search.
+QDateTime TestSchedulerUnit::scanAltitudeTime(const SchedulerJob &job, const KStarsDateTime &ltWhen, bool withMoon)
+{
+    const GeoLocation *geo = SchedulerJob::getGeo();
+    SkyObject o;
+    o.setRA0(job.getTargetCoords().ra0());
+    o.setDec0(job.getTargetCoords().dec0());
+
+    for (unsigned int minute = 0; minute < 24 * 60; minute++)
+    {
+        KStarsDateTime const ltOffset(ltWhen.addSecs(minute * 60));
+
+        KSNumbers numbers(ltOffset.djd());
+        o.updateCoordsNow(&numbers);
+
+        CachingDms const LST = geo->GSTtoLST(geo->LTtoUT(ltOffset).gst());
+        o.EquatorialToHorizontal(&LST, geo->lat());
+        double const altitude = o.alt().Degrees();
+
+        if (job.getMinAltitude() <= altitude)
+        {
+            if (withMoon && 0 < job.getMinMoonSeparation() && job.getMoonSeparationScore(ltOffset) < 0)
+                continue;
+
+            double offset = LST.Hours() - o.ra().Hours();
+            if (24.0 <= offset)
+                offset -= 24.0;
+            else if (offset < 0.0)
+                offset += 24.0;
+            if (0.0 <= offset && offset < 12.0)
+                if (altitude - Options::settingAltitudeCutoff() < job.getMinAltitude())
+                    continue;
+
+            return ltOffset;
+        }
+    }
+
+    return QDateTime();
+}
+
+namespace
+{
+// A Moon half illuminated, moving eastwards along the celestial equator at the mean lunar rate.
+// KSMoon needs the KStars data to compute its position, which the unit tests don't load.
+class TestMoon : public KSMoon
+{
+    public:
+        TestMoon(const KStarsDateTime &when, double raHours) : m_JD(when.djd()), m_RA(raHours)
+        {
+            Phase = 90.0;
+        }
+
+        void updateCoords(const KSNumbers *num, bool, const CachingDms *lat, const CachingDms *LST, bool) override
+        {
+            setRA(fmod(m_RA + static_cast<double>(num->julianDay() - m_JD) * 24.0 / 27.32, 24.0));
+            setDec(0.0);
+            if (lat != nullptr && LST != nullptr)
+                EquatorialToHorizontal(LST, lat);
+        }
+
+    private:
+        long double m_JD;
+        double m_RA;
+};
+}
+
+// Compare SchedulerJob::calculateAltitudeTime() with the old per-minute search, with and without the Moon.
+void TestSchedulerUnit::calculateAltitudeTimeTest()
+{
+    TestMoon moon(midNight, 12.0);
+    int moonLimited = 0;
+
+    for (int hour : {-4, 3})
+    {
+        KStarsDateTime start = midNight.addSecs(hour * 3600);
+        Scheduler::setLocalTime(&start);
+
+        for (int raHours = 0; raHours < 24; raHours += 3)
+        {
+            for (double decDegrees : {-20.0, 10.0, 37.56, 60.0})
+            {
+                for (double minAltitude : {10.0, 30.0})
+                {
+                    for (double minMoonSeparation : {0.0, 20.0, 40.0, 60.0})
+                    {
+                        SchedulerJob job(&moon);
+                        runSetupJob(job, &siliconValley, &start, "Job", 10,
+                                    dms(raHours * 15.0), dms(decDegrees), 0.0,
+                                    QUrl(QString("file:%1").arg(seqFile9Filters)), QUrl(""),
+                                    SchedulerJob::START_ASAP, QDateTime(), 0,
+                                    SchedulerJob::FINISH_SEQUENCE, QDateTime(), 1,
+                                    minAltitude, minMoonSeparation);
+
+                        QDateTime const expected = scanAltitudeTime(job, start, true);
+                        QDateTime const actual = job.calculateAltitudeTime(start);
+                        QString const message = QString("RA %1h DEC %2 alt %3 moon %4 from %5: expected %6, got %7")
+                                                .arg(raHours).arg(decDegrees).arg(minAltitude).arg(minMoonSeparation)
+                                                .arg(start.toString()).arg(expected.toString()).arg(actual.toString());
+
+                        QVERIFY2(expected.isValid() == actual.isValid(), qPrintable(message));
+                        if (expected.isValid())
+                            QVERIFY2(std::abs(expected.secsTo(actual)) <= 60, qPrintable(message));
+
+                        if (expected != scanAltitudeTime(job, start, false))
+                            moonLimited++;
+                    }
+                }
+            }
+        }
+    }
+
+    // Make sure the Moon constraint was actually exercised
+    QVERIFY(moonLimited > 0);
+}
+
+// Benchmark Scheduler::evaluateJobs() on the synthetic schedule of 100 jobs spread over the sky, a third of them
+// with a Moon separation constraint.
+void TestSchedulerUnit::evaluateJobsBenchmark()
+{
+    auto now = midNight.addSecs(-4 * 3600);
+    Scheduler::setLocalTime(&now);
+
+    const double _dawn = .25, _dusk = .75;
+    QDateTime const dawn = midNight.addSecs(_dawn * 24.0 * 3600.0);
+    QDateTime const dusk = midNight.addSecs(_dusk * 24.0 * 3600.0);
+    const bool rescheduleErrors = true;
+    const bool restart = true;
+    bool possiblyDelay = true;
+    const QMap<QString, uint16_t> capturedFrames;
+    const Ekos::SchedulerState state = Ekos::SCHEDULER_IDLE;
+
+    QFile file(schedFile100Jobs);
+    QVERIFY(file.open(QIODevice::ReadOnly));
+
+    TestMoon moon(midNight, 12.0);
+    char errmsg[MAXRBUF];
+    LilXML *xmlParser = newLilXML();
+    XMLEle *root = nullptr;
+    std::vector<std::unique_ptr<SchedulerJob>> jobs;
+    QList<SchedulerJob *> jobList;
+    QLocale cLocale = QLocale::c();
+    char c;
+
+    while (file.getChar(&c))
+    {
+        root = readXMLEle(xmlParser, c, errmsg);
+        if (root == nullptr)
+        {
+            QVERIFY(errmsg[0] == '\0');
+            continue;
+        }
+
+        for (XMLEle *ep = nextXMLEle(root, 1); ep != nullptr; ep = nextXMLEle(root, 0))
+        {
+            if (strcmp(tagXMLEle(ep), "Job"))
+                continue;
+
+            XMLEle *coords = findXMLEle(ep, "Coordinates");
+            QVERIFY(coords != nullptr);
+            dms ra, dec;
+            ra.setH(cLocale.toDouble(pcdataXMLEle(findXMLEle(coords, "J2000RA"))));
+            dec.setD(cLocale.toDouble(pcdataXMLEle(findXMLEle(coords, "J2000DE"))));
+
+            double minAltitude = 0, minMoonSeparation = 0;
+            XMLEle *constraints = findXMLEle(ep, "Constraints");
+            QVERIFY(constraints != nullptr);
+            for (XMLEle *subEP = nextXMLEle(constraints, 1); subEP != nullptr; subEP = nextXMLEle(constraints, 0))
+            {
+                if (!strcmp("MinimumAltitude", pcdataXMLEle(subEP)))
+                    minAltitude = cLocale.toDouble(findXMLAttValu(subEP, "value"));
+                else if (!strcmp("MoonSeparation", pcdataXMLEle(subEP)))
+                    minMoonSeparation = cLocale.toDouble(findXMLAttValu(subEP, "value"));
+            }
+
+            jobs.push_back(std::unique_ptr<SchedulerJob>(new SchedulerJob(&moon)));
+            runSetupJob(*jobs.back(), &siliconValley, &now, pcdataXMLEle(findXMLEle(ep, "Name")), 10,
+                        ra, dec, 0.0,
+                        QUrl(QString("file:%1").arg(seqFile9Filters)), QUrl(""),
+                        SchedulerJob::START_ASAP, QDateTime(), 0,
+                        SchedulerJob::FINISH_SEQUENCE, QDateTime(), 1,
+                        minAltitude, minMoonSeparation);
+            jobList.append(jobs.back().get());
+        }
+        delXMLEle(root);
+    }
+    delLilXML(xmlParser);
+
+    QVERIFY(jobList.size() == 100);
+
+    QList<SchedulerJob *> sortedJobs;
+    QBENCHMARK
+    {
+        // Reset the jobs so that each iteration plans the whole schedule again.
+        for (auto job : jobList)
+            job->reset();
+        sortedJobs = Scheduler::evaluateJobs(jobList, state, capturedFrames,  dawn, dusk,
+                                             rescheduleErrors, restart, &possiblyDelay, nullptr);
+    }
+    QVERIFY(!sortedJobs.empty());
+}
+
 QTEST_GUILESS_MAIN(TestSchedulerUnit)
@@ -126,6 +126,54 @@ QHash<QString, QVariant> KSParser::ReadCSVRow()
     return newRow;
 }
 
+bool KSParser::ReadNextCSVFields(QVector<QStringRef> &fields)
+{
+    fields.clear();
+    if (readFunctionPtr != &KSParser::ReadCSVRow)
+        return false;
+
+    while (file_reader_.hasMoreLines())
+    {
+        current_line_ = file_reader_.readLine();
+        if (current_line_.isEmpty() || current_line_.at(0) == comment_char_)
+            continue;
+
+        QVector<QStringRef> const words = current_line_.splitRef(delimiter_);
+        if (words.size() == 1)
+            continue; // Length will be 1 if there is no delimiter
+
+        // Combine the words between quote marks, following CombineQuoteParts but without copies
+        fields.clear();
+        for (int i = 0; i < words.size(); ++i)
+        {
+            if (!words[i].startsWith('\"'))
+            {
+                fields.append(words[i]);
+                continue;
+            }
+
+            int const begin = words[i].position() + 1;
+            QStringRef last = words[i].mid(1);
+            while (!last.isEmpty() && !last.endsWith('\"') && i + 1 < words.size())
+                last = words[++i];
+
+            int end = words[i].position() + words[i].size();
+            if (!last.isEmpty())
+                end--; // remove the quote at the end
+            fields.append(current_line_.midRef(begin, end - begin));
+        }
+
+        // Skip incomplete rows
+        if (fields.size() != name_type_sequence_.length())
+            continue;
+
+        return true;
+    }
+
+    fields.clear();
+    return false;
+}
+
 QHash<QString, QVariant> KSParser::ReadFixedWidthRow()
 {
     if (name_type_sequence_.length() != (width_sequence_.length() + 1))
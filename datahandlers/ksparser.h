@@ -20,6 +20,7 @@
 #include <QHash>
 #include <QList>
 #include <QVariant>
+#include <QVector>
 
 #include "ksfilereader.h"
 
@@ -129,6 +130,17 @@ class KSParser
      **/
     QHash<QString, QVariant> ReadNextRow();
 
+    /**
+     * @brief Reads the next row of a CSV file as references to its fields, without conversion.
+     * Rows are skipped and quotes are combined exactly like ReadNextRow does, but no QHash or
+     * QVariant is built. This is meant for large files whose rows are converted by the caller.
+     * Numeric fields are to be converted with trimmed().toDouble() and similar, which yield 0 on error.
+     *
+     * @param fields receives the fields in sequence order, valid until the next call
+     * @return true if a row was read, false at the end of the file or if this is not a CSV parser
+     **/
+    bool ReadNextCSVFields(QVector<QStringRef> &fields);
+
     /**
      * @brief Returns True if there are more rows to be read
      *
@@ -217,4 +229,7 @@ class KSParser
     QList<QPair<QString, DataTypes>> name_type_sequence_;
     QList<int> width_sequence_;
     char delimiter_ { 0 };
+
+    /// Line referenced by the fields returned by ReadNextCSVFields
+    QString current_line_;
 };
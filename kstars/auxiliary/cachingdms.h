@@ -227,6 +227,15 @@ class CachingDms : public dms
      */
     static CachingDms fromString(const QString &s, bool deg);
 
+    /**
+     * @short Construct an angle from its value in degrees and its known sine and cosine
+     * @note The sine and cosine are not checked, they must be those saved from another CachingDms
+     */
+    static inline CachingDms fromSinCos(const double &degrees, const double &sine, const double &cosine)
+    {
+        return CachingDms(degrees, sine, cosine);
+    }
+
     /**
      * @short operator -
      * @note In addition to negating the angle, we negate the sine value
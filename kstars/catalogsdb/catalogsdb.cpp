@@ -17,9 +17,13 @@
 
 #include <limits>
 #include <cmath>
+#include <atomic>
 #include <QSqlDriver>
 #include <QSqlRecord>
 #include <QMutexLocker>
+#include <QHash>
+#include <QSet>
+#include <QRegularExpression>
 #include <qsqldatabase.h>
 #include "cachingdms.h"
 #include "catalogsdb.h"
@@ -36,7 +40,7 @@ using namespace CatalogsDB;
  */
 int get_connection_index()
 {
-    static int connection_index = 0;
+    static std::atomic<int> connection_index{ 0 };
     return connection_index++;
 }
 
@@ -135,6 +139,28 @@ DBManager::DBManager(const QString &filename)
     const bool master_does_exist = master_exists.next();
     master_exists.finish();
 
+    if (master_does_exist && !init)
+    {
+        // databases compiled before the name search table existed
+        QSqlQuery names_exist{ m_db };
+        names_exist.exec(SqlStatements::exists_master_names);
+        const bool names_do_exist = names_exist.next();
+        names_exist.finish();
+
+        if (!names_do_exist)
+        {
+            auto _ = gsl::finally([&]() { m_db.commit(); });
+            m_db.transaction();
+
+            if (!compile_master_names())
+            {
+                throw DatabaseError(QString("Unable to create master name index!"),
+                                    DatabaseError::ErrorType::CREATE_MASTER,
+                                    m_db.lastError());
+            }
+        }
+    }
+
     if (init || !master_does_exist)
     {
         if (!initialize_db())
@@ -174,6 +200,7 @@ DBManager::DBManager(const QString &filename)
     m_q_obj_by_trixel            = make_query(m_db, SqlStatements::dso_by_trixel, false);
     m_q_obj_by_name              = make_query(m_db, SqlStatements::dso_by_name, true);
     m_q_obj_by_name_exact = make_query(m_db, SqlStatements::dso_by_name_exact, true);
+    m_q_obj_by_name_prefix = make_query(m_db, SqlStatements::dso_by_name_prefix, true);
     m_q_obj_by_maglim            = make_query(m_db, SqlStatements::dso_by_maglim, true);
     m_q_obj_by_maglim_and_type =
         make_query(m_db, SqlStatements::dso_by_maglim_and_type, true);
@@ -347,9 +374,113 @@ bool DBManager::compile_master_catalog()
     success &= query.exec(SqlStatements::create_master_mag_index);
     success &= query.exec(SqlStatements::create_master_type_index);
     success &= query.exec(SqlStatements::create_master_name_index);
+    success &= compile_master_names();
     return success;
 };
 
+bool DBManager::compile_master_names()
+{
+    // one transaction for all the rows, unless the caller has already opened one
+    const bool own_transaction = m_db.transaction();
+    auto _                     = gsl::finally([&]() {
+        if (own_transaction)
+            m_db.commit();
+    });
+
+    QSqlQuery query{ m_db };
+
+    if (!query.exec(SqlStatements::create_master_names) ||
+        !query.exec(SqlStatements::create_master_names_index) ||
+        !query.exec(SqlStatements::create_master_names_object_index))
+    {
+        return false;
+    }
+
+    // the names and long names indexed so far, so that only the objects
+    // that were added, removed or renamed have to be updated
+    QHash<CatalogObject::oid, std::pair<QString, QString>> indexed;
+    query.setForwardOnly(true);
+    if (!query.exec(SqlStatements::get_indexed_master_names))
+        return false;
+
+    while (query.next())
+    {
+        auto &names = indexed[query.value(0).toByteArray()];
+        (query.value(1).toInt() == 0 ? names.first : names.second) =
+            query.value(2).toString();
+    }
+    query.finish();
+
+    QSqlQuery insert{ m_db };
+    insert.prepare(SqlStatements::insert_master_name);
+
+    const auto add_name = [&](const QVariant &oid, const int rank, const QString &word) {
+        insert.bindValue(":oid", oid);
+        insert.bindValue(":rank", rank);
+        insert.bindValue(":word", word);
+
+        return insert.exec();
+    };
+
+    // the first word is already covered by the prefix search on the whole name
+    static const QRegularExpression separators{ "[^\\w]+" };
+    const auto add_words = [&](const QVariant &oid, const int rank, const QString &name) {
+        bool success     = true;
+        const auto words = name.split(separators, QString::SkipEmptyParts);
+
+        for (int i = 1; i < words.size(); i++)
+            success &= add_name(oid, rank, words[i]);
+
+        return success;
+    };
+
+    QSqlQuery remove{ m_db };
+    remove.prepare(SqlStatements::remove_master_names);
+
+    const auto remove_names = [&](const QVariant &oid) {
+        remove.bindValue(":oid", oid);
+        return remove.exec();
+    };
+
+    QSqlQuery names{ m_db };
+    names.setForwardOnly(true);
+    if (!names.exec(SqlStatements::get_master_names))
+        return false;
+
+    bool success = true;
+    while (success && names.next())
+    {
+        const auto &oid       = names.value(0);
+        const auto &name      = names.value(1).toString().toLower();
+        const auto &long_name = names.value(2).toString().toLower();
+
+        const auto found = indexed.find(oid.toByteArray());
+        if (found != indexed.end())
+        {
+            const bool unchanged =
+                found->first == name && found->second == long_name;
+            indexed.erase(found);
+
+            if (unchanged)
+                continue;
+
+            success &= remove_names(oid);
+        }
+
+        if (!name.isEmpty())
+            success &= add_name(oid, 0, name) && add_words(oid, 2, name);
+
+        if (!long_name.isEmpty())
+            success &= add_name(oid, 1, long_name) && add_words(oid, 3, long_name);
+    }
+
+    // objects that are no longer in the master catalog
+    for (auto it = indexed.cbegin(); success && it != indexed.cend(); ++it)
+        success &= remove_names(it.key());
+
+    return success;
+}
+
 const Catalog read_catalog(const QSqlQuery &query)
 {
     return { query.value("id").toInt(),
@@ -496,10 +627,35 @@ std::list<CatalogObject> DBManager::find_objects_by_name(const QString &name,
         }
     }
 
+    // prefixes of the names and of their words are found through the index
+    const auto &lower = name.toLower();
+    m_q_obj_by_name_prefix.bindValue(":lower", lower);
+    m_q_obj_by_name_prefix.bindValue(":upper", lower + QChar(0xFFFF));
+    m_q_obj_by_name_prefix.bindValue(":limit", limit);
+
+    auto objs = fetch_objects(m_q_obj_by_name_prefix);
+    if (limit >= 0 && static_cast<int>(objs.size()) >= limit)
+        return objs;
+
+    // the rest are substring matches, which need a full scan. Every prefix
+    // match is also a substring match, so `limit` rows leave enough new ones.
     m_q_obj_by_name.bindValue(":name", name);
     m_q_obj_by_name.bindValue(":limit", limit);
 
-    return fetch_objects(m_q_obj_by_name);
+    QSet<CatalogObject::oid> found;
+    for (const auto &obj : objs)
+        found.insert(obj.getObjectId());
+
+    for (auto &obj : fetch_objects(m_q_obj_by_name))
+    {
+        if (limit >= 0 && static_cast<int>(objs.size()) >= limit)
+            break;
+
+        if (!found.contains(obj.getObjectId()))
+            objs.push_back(std::move(obj));
+    }
+
+    return objs;
 }
 
 std::list<CatalogObject> DBManager::find_objects_by_name(const int catalog_id,
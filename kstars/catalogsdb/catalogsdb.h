@@ -25,6 +25,9 @@
 #include <catalogsdb_debug.h>
 #include <QSqlQuery>
 #include <QMutex>
+#include <QThreadPool>
+#include <QtConcurrent>
+#include <memory>
 #include <utility>
 #include "catalogobject.h"
 #include "nan.h"
@@ -169,6 +172,7 @@ class DBManager
         swap(m_q_obj_by_trixel, other.m_q_obj_by_trixel);
         swap(m_q_obj_by_name, other.m_q_obj_by_name);
         swap(m_q_obj_by_name_exact, other.m_q_obj_by_name_exact);
+        swap(m_q_obj_by_name_prefix, other.m_q_obj_by_name_prefix);
         swap(m_q_obj_by_maglim, other.m_q_obj_by_maglim);
         swap(m_q_obj_by_maglim_and_type, other.m_q_obj_by_maglim_and_type);
         swap(m_q_obj_by_oid, other.m_q_obj_by_oid);
@@ -222,6 +226,11 @@ class DBManager
      * fields in all enabled catalogs for \p `name` and then return a new
      * instance of `CatalogObject` sourced from the master catalog.
      *
+     * Objects whose name, long name or one of their words start with \p
+     * `name` are looked up in an index and ranked in that order. If they
+     * do not fill \p `limit`, the objects containing \p `name` anywhere
+     * in their names follow, which requires a scan of all names.
+     *
      * \param limit Upper limit to the quanitity of results. `-1` means "no
      * limit"
      *
@@ -431,6 +440,17 @@ class DBManager
      */
     bool compile_master_catalog();
 
+    /**
+     * Fills the `master_names` table with the lower case names, long
+     * names and their words of all objects in the master catalog and
+     * indexes it, so that name searches do not have to scan `master`.
+     * Only the rows of objects that were added, removed or renamed
+     * since the last call are written, in a single transaction.
+     *
+     * @return true in case of success, false in case of an error
+     */
+    bool compile_master_names();
+
     /**
      * Updates the all_catalog_view so that it includes all known
      * catalogs.
@@ -462,6 +482,7 @@ class DBManager
     QSqlQuery m_q_obj_by_trixel;
     QSqlQuery m_q_obj_by_name;
     QSqlQuery m_q_obj_by_name_exact;
+    QSqlQuery m_q_obj_by_name_prefix;
     QSqlQuery m_q_obj_by_maglim;
     QSqlQuery m_q_obj_by_maglim_and_type;
     QSqlQuery m_q_obj_by_oid;
@@ -594,6 +615,77 @@ class DatabaseError : std::exception
     const std::string m_report;
 };
 
+/**
+ * A database connection for queries run in the background.
+ *
+ * A database connection may only be used by the thread that opened
+ * it, so the connection is opened by the first query and only used,
+ * and closed, in a single thread of its own.
+ */
+class BackgroundConnection
+{
+  public:
+    BackgroundConnection(const QString &filename)
+        : m_connection{ std::make_shared<Connection>() }
+    {
+        // one thread, which keeps the connection open between queries
+        m_pool.setMaxThreadCount(1);
+        m_pool.setExpiryTimeout(-1);
+        m_connection->db_file = filename;
+    }
+
+    ~BackgroundConnection()
+    {
+        // the connection has to be closed in the thread that opened it
+        auto connection = m_connection;
+        QtConcurrent::run(&m_pool, [connection]() { connection->db.reset(); })
+            .waitForFinished();
+    }
+
+    BackgroundConnection(const BackgroundConnection &) = delete;
+    BackgroundConnection &operator=(const BackgroundConnection &) = delete;
+
+    /**
+     * Run `query` with the `DBManager` of the connection in the
+     * background.
+     *
+     * \returns the future result of `query`, or a default
+     * constructed result if the database could not be opened
+     */
+    template <typename Query>
+    auto run(Query query) -> QFuture<decltype(query(std::declval<DBManager &>()))>
+    {
+        using Result    = decltype(query(std::declval<DBManager &>()));
+        auto connection = m_connection;
+
+        return QtConcurrent::run(&m_pool, [connection, query]() {
+            try
+            {
+                if (!connection->db)
+                    connection->db.reset(new DBManager(connection->db_file));
+            }
+            catch (const DatabaseError &e)
+            {
+                qCCritical(KSTARS_CATALOGS)
+                    << "Could not open catalog database: " << e.what();
+                return Result{};
+            }
+
+            return query(*connection->db);
+        });
+    }
+
+  private:
+    struct Connection
+    {
+        QString db_file;
+        std::unique_ptr<DBManager> db;
+    };
+
+    std::shared_ptr<Connection> m_connection;
+    QThreadPool m_pool;
+};
+
 /** \returns the path to the dso database */
 QString dso_db_path();
 
@@ -281,6 +281,30 @@ const QString create_master_name_index =
     "COLLATE NOCASE ASC, long_name COLLATE NOCASE ASC, "
     "magnitude ASC)";
 
+/*
+ * The name search table holds, for each object in `master`, its lower case
+ * `name` and `long_name` and every later word of them, so that prefix and
+ * word searches can use an index instead of scanning `master`.
+ *
+ * Rank: 0 = name, 1 = long name, 2 = word in the name, 3 = word in the long name
+ */
+const QString create_master_names =
+    "CREATE TABLE IF NOT EXISTS master_names (object_oid BLOB NOT NULL, rank INTEGER "
+    "NOT NULL, word TEXT NOT NULL)";
+const QString get_master_names = "SELECT oid, name, long_name FROM master";
+const QString get_indexed_master_names =
+    "SELECT object_oid, rank, word FROM master_names WHERE rank < 2";
+const QString insert_master_name = "INSERT INTO master_names (object_oid, rank, word) "
+                                   "VALUES (:oid, :rank, :word)";
+const QString remove_master_names = "DELETE FROM master_names WHERE object_oid = :oid";
+const QString create_master_names_index =
+    "CREATE INDEX IF NOT EXISTS master_names_word ON master_names(word ASC, rank ASC)";
+const QString create_master_names_object_index =
+    "CREATE INDEX IF NOT EXISTS master_names_object ON master_names(object_oid)";
+
+const QString exists_master_names =
+    "SELECT name FROM sqlite_master WHERE type='table' AND name='master_names';";
+
 const QString get_first_catalog = "SELECT id, name, precedence, author, source, "
                                   "description, mut, enabled, version, color, license, "
                                   "maintainer, timestamp FROM catalogs LIMIT 1";
@@ -326,10 +350,18 @@ const QString _dso_by_name =
     "ORDER BY name, long_name, "
     "%2 LIMIT :limit";
 
+// the bounds are lower case and :upper is :lower followed by the highest character
+const QString _dso_by_name_prefix =
+    "SELECT %1 FROM master JOIN (SELECT object_oid, MIN(rank) AS match_rank FROM "
+    "master_names WHERE word >= :lower AND word < :upper GROUP BY object_oid) ON oid = "
+    "object_oid ORDER BY match_rank, name, long_name, %2 LIMIT :limit";
+
 const QString _dso_by_name_exact = "SELECT %1 FROM master WHERE name = :name LIMIT 1";
 
 const QString dso_by_name       = QString(_dso_by_name).arg(object_fields).arg(mag_asc);
 const QString dso_by_name_exact = QString(_dso_by_name_exact).arg(object_fields);
+const QString dso_by_name_prefix =
+    QString(_dso_by_name_prefix).arg(object_fields).arg(mag_asc);
 
 inline const QString dso_by_name_and_catalog(const int id)
 {
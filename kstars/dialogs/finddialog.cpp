@@ -71,9 +71,12 @@ FindDialog *FindDialog::Instance()
 
 FindDialog::FindDialog(QWidget *parent)
     : QDialog(parent), timer(nullptr),
-      m_targetObject(nullptr), m_manager{ CatalogsDB::dso_db_path() }
+      m_targetObject(nullptr), m_manager{ CatalogsDB::dso_db_path() },
+      m_catalogSearch{ m_manager.db_file_name() }
 
 {
+    connect(&m_searchWatcher, &QFutureWatcherBase::finished, this, &FindDialog::catalogSearchFinished);
+
 #ifdef Q_OS_OSX
     setWindowFlags(Qt::Tool | Qt::WindowStaysOnTopHint);
 #endif
@@ -155,6 +158,11 @@ FindDialog::FindDialog(QWidget *parent)
     listFiltered = false;
 }
 
+FindDialog::~FindDialog()
+{
+    m_searchWatcher.waitForFinished();
+}
+
 void FindDialog::init()
 {
     ui->SearchBox->clear();
@@ -298,13 +306,50 @@ void FindDialog::filterByType()
 void FindDialog::filterList()
 {
     QString SearchText = processSearchText();
-    const auto &objs   = m_manager.find_objects_by_name(SearchText, 10);
-    for (const auto &obj : objs)
+
+    // A search running for older text is followed by one for the current text when it finishes
+    if (!SearchText.isEmpty() && !m_searchWatcher.isRunning())
+        searchCatalogs(SearchText);
+
+    applyFilter(SearchText);
+}
+
+void FindDialog::searchCatalogs(const QString &searchText)
+{
+    m_searchText = searchText;
+
+    m_searchWatcher.setFuture(m_catalogSearch.run([searchText](CatalogsDB::DBManager &db)
+    {
+        return db.find_objects_by_name(searchText, 10);
+    }));
+}
+
+void FindDialog::catalogSearchFinished()
+{
+    const auto objects = m_searchWatcher.result();
+    insertCatalogObjects(objects);
+
+    QString SearchText = processSearchText();
+    if (SearchText != m_searchText)
+    {
+        if (!SearchText.isEmpty())
+            searchCatalogs(SearchText);
+    }
+    else if (!objects.empty())
+        applyFilter(SearchText);
+}
+
+void FindDialog::insertCatalogObjects(const CatalogsDB::DBManager::CatalogObjectList &objects)
+{
+    for (const auto &obj : objects)
     {
         KStarsData::Instance()->skyComposite()->catalogsComponent()->insertStaticObject(
             obj);
     }
+}
 
+void FindDialog::applyFilter(const QString &SearchText)
+{
     sortModel->setFilterFixedString(SearchText);
     ui->InternetSearchButton->setText(i18n("or search the Internet for %1", SearchText));
     filterByType();
@@ -402,7 +447,12 @@ void FindDialog::slotOk()
     SkyObject *selObj;
     if (!listFiltered)
     {
-        filterList();
+        // The selection is needed right away, so the database is searched without waiting
+        QString SearchText = processSearchText();
+        if (!SearchText.isEmpty())
+            insertCatalogObjects(m_manager.find_objects_by_name(SearchText, 10));
+
+        applyFilter(SearchText);
     }
     selObj = selectedObject();
     finishProcessing(selObj, Options::resolveNamesOnline());
@@ -21,6 +21,7 @@
 #include "catalogsdb.h"
 
 #include <QDialog>
+#include <QFutureWatcher>
 #include <QKeyEvent>
 
 class QTimer;
@@ -73,6 +74,9 @@ class FindDialog : public QDialog
     /**
      * When Text is entered in the QLineEdit, filter the List of objects
      * so that only objects which start with the filter text are shown.
+     *
+     * Matching DSOs are searched in the catalog database in the background
+     * and added to the list when found.
      */
     void filterList();
 
@@ -121,6 +125,7 @@ class FindDialog : public QDialog
      * Signals and Slots. Runs initObjectList().
      */
     explicit FindDialog(QWidget *parent = nullptr);
+    ~FindDialog() override;
 
     static FindDialog *m_Instance;
     /**
@@ -135,6 +140,18 @@ class FindDialog : public QDialog
     /** @short pre-filter the list of objects according to the selected object type. */
     void filterByType();
 
+    /** @short filter the list of objects by the search text and select the best match. */
+    void applyFilter(const QString &searchText);
+
+    /** @short search the catalog database for DSOs named like searchText in the background. */
+    void searchCatalogs(const QString &searchText);
+
+    /** @short add the DSOs found by the background search to the list. */
+    void catalogSearchFinished();
+
+    /** @short make the DSOs found in the catalog database known to the list. */
+    void insertCatalogObjects(const CatalogsDB::DBManager::CatalogObjectList &objects);
+
     FindDialogUI *ui { nullptr };
     SkyObjectListModel *fModel { nullptr };
     QSortFilterProxyModel *sortModel { nullptr };
@@ -149,5 +166,11 @@ class FindDialog : public QDialog
 
     // DSO Database
     CatalogsDB::DBManager m_manager;
+
+    // Background DSO search
+    CatalogsDB::BackgroundConnection m_catalogSearch;
+    QFutureWatcher<CatalogsDB::DBManager::CatalogObjectList> m_searchWatcher;
+    // Search text of the running background search
+    QString m_searchText;
 };
 
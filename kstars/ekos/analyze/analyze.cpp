@@ -56,6 +56,9 @@ QString timeFormat = "yyyy-MM-dd hh:mm:ss.zzz";
 // The resolution of the scroll bar.
 constexpr int MAX_SCROLL_VALUE = 10000;
 
+// Buffered .analyze log lines are written to disk at most this long after being logged.
+constexpr int LOG_FLUSH_INTERVAL_MS = 2000;
+
 // Half the height of a timeline line.
 // That is timeline lines are horizontal bars along y=1 or y=2 ... and their
 // vertical widths are from y-halfTimelineHeight to y+halfTimelineHeight.
@@ -325,6 +328,10 @@ Analyze::Analyze()
 
     alternateFolder = QDir::homePath();
 
+    logFlushTimer.setSingleShot(true);
+    logFlushTimer.setInterval(LOG_FLUSH_INTERVAL_MS);
+    connect(&logFlushTimer, &QTimer::timeout, this, &Ekos::Analyze::flushLog);
+
     initInputSelection();
     initTimelinePlot();
     initStatsPlot();
@@ -402,6 +409,7 @@ void Analyze::initInputSelection()
             {
                 reset();
                 inputValue->setText(i18n("Current Session"));
+                flushLog();
                 maxXValue = readDataFromFile(logFilename);
                 runtimeDisplay = true;
             }
@@ -471,6 +479,7 @@ void Analyze::setupKeyboardShortcuts(QCustomPlot *plot)
 
 Analyze::~Analyze()
 {
+    flushLog();
     // TODO:
     // We should write out to disk any sessions that haven't terminated
     // (e.g. capture, focus, guide)
@@ -594,23 +603,39 @@ void Analyze::addGuideStatsInternal(double raDrift, double decDrift, double raPu
     statsPlot->graph(DRIFT_GRAPH)->addData(time, drift);
     statsPlot->graph(RMS_GRAPH)->addData(time, rms);
 
-    // Set the SNR axis' maximum to 95% of the way up from the middle to the top.
-    if (!qIsNaN(snr))
-        snrMax = std::max(snr, snrMax);
-    if (!qIsNaN(skyBackground))
-        skyBgMax = std::max(skyBackground, skyBgMax);
-    if (!qIsNaN(numStars))
-        numStarsMax = std::max(numStars, static_cast<double>(numStarsMax));
+    // Only rescale the axes when a new maximum is seen, not for every guide sample.
+    bool newMax = false;
+    if (!qIsNaN(snr) && snr > snrMax)
+    {
+        snrMax = snr;
+        newMax = true;
+    }
+    if (!qIsNaN(skyBackground) && skyBackground > skyBgMax)
+    {
+        skyBgMax = skyBackground;
+        newMax = true;
+    }
+    if (!qIsNaN(numStars) && numStars > numStarsMax)
+    {
+        numStarsMax = numStars;
+        newMax = true;
+    }
+    if (newMax)
+        updateStatsAxesRanges();
 
+    statsPlot->graph(SNR_GRAPH)->addData(time, snr);
+    statsPlot->graph(NUMSTARS_GRAPH)->addData(time, numStars);
+    statsPlot->graph(SKYBG_GRAPH)->addData(time, skyBackground);
+}
+
+void Analyze::updateStatsAxesRanges()
+{
+    // Set the SNR axis' maximum to 95% of the way up from the middle to the top.
     snrAxis->setRange(-1.05 * snrMax, std::max(10.0, 1.05 * snrMax));
     medianAxis->setRange(-1.35 * medianMax, std::max(10.0, 1.35 * medianMax));
     numCaptureStarsAxis->setRange(-1.45 * numCaptureStarsMax, std::max(10.0, 1.45 * numCaptureStarsMax));
     skyBgAxis->setRange(0, std::max(10.0, 1.15 * skyBgMax));
     numStarsAxis->setRange(0, std::max(10.0, 1.25 * numStarsMax));
-
-    statsPlot->graph(SNR_GRAPH)->addData(time, snr);
-    statsPlot->graph(NUMSTARS_GRAPH)->addData(time, numStars);
-    statsPlot->graph(SKYBG_GRAPH)->addData(time, skyBackground);
 }
 
 void Analyze::addTemperature(double temperature, double time)
@@ -644,8 +669,12 @@ void Analyze::addHFR(double hfr, int numCaptureStars, int median, double eccentr
     statsPlot->graph(ECCENTRICITY_GRAPH)->addData(time, eccentricity);
     statsPlot->graph(ECCENTRICITY_GRAPH)->addData(time + .0001, qQNaN());
 
-    medianMax = std::max(median, medianMax);
-    numCaptureStarsMax = std::max(numCaptureStars, numCaptureStarsMax);
+    if (median > medianMax || numCaptureStars > numCaptureStarsMax)
+    {
+        medianMax = std::max(median, medianMax);
+        numCaptureStarsMax = std::max(numCaptureStars, numCaptureStarsMax);
+        updateStatsAxesRanges();
+    }
 }
 
 // Add the Mount Coordinates values to the Stats graph.
@@ -669,9 +698,10 @@ double Analyze::readDataFromFile(const QString &filename)
     if (inputFile.open(QIODevice::ReadOnly))
     {
         QTextStream in(&inputFile);
-        while (!in.atEnd())
+        QString line;
+        // readLineInto() reuses the line buffer, instead of allocating a string per line.
+        while (in.readLineInto(&line))
         {
-            QString line = in.readLine();
             double time = processInputLine(line);
             if (time > lastTime)
                 lastTime = time;
@@ -685,8 +715,9 @@ double Analyze::readDataFromFile(const QString &filename)
 double Analyze::processInputLine(const QString &line)
 {
     bool ok;
-    // Break the line into comma-separated components
-    QStringList list = line.split(QLatin1Char(','));
+    // Break the line into comma-separated components.
+    // The components refer to the line, rather than being copied into new strings.
+    const QVector<QStringRef> list = line.splitRef(QLatin1Char(','));
     // We need at least a command and a timestamp
     if (list.size() < 2)
         return 0;
@@ -696,147 +727,147 @@ double Analyze::processInputLine(const QString &line)
         return 0;
     }
 
-    if ((list[0] == "AnalyzeStartTime") && list.size() == 3)
+    if ((list[0] == QLatin1String("AnalyzeStartTime")) && list.size() == 3)
     {
-        displayStartTime = QDateTime::fromString(list[1], timeFormat);
+        displayStartTime = QDateTime::fromString(list[1].toString(), timeFormat);
         startTimeInitialized = true;
-        analyzeTimeZone = list[2];
+        analyzeTimeZone = list[2].toString();
         return 0;
     }
 
     // Except for comments and the above AnalyzeStartTime, the second item
     // in the csv line is a double which represents seconds since start of the log.
-    const double time = QString(list[1]).toDouble(&ok);
+    const double time = list[1].toDouble(&ok);
     if (!ok)
         return 0;
     if (time < 0 || time > 3600 * 24 * 10)
         return 0;
 
-    if ((list[0] == "CaptureStarting") && (list.size() == 4))
+    if ((list[0] == QLatin1String("CaptureStarting")) && (list.size() == 4))
     {
-        const double exposureSeconds = QString(list[2]).toDouble(&ok);
+        const double exposureSeconds = list[2].toDouble(&ok);
         if (!ok)
             return 0;
-        const QString filter = list[3];
+        const QString filter = list[3].toString();
         processCaptureStarting(time, exposureSeconds, filter, true);
     }
-    else if ((list[0] == "CaptureComplete") && (list.size() >= 6) && (list.size() <= 9))
+    else if ((list[0] == QLatin1String("CaptureComplete")) && (list.size() >= 6) && (list.size() <= 9))
     {
-        const double exposureSeconds = QString(list[2]).toDouble(&ok);
+        const double exposureSeconds = list[2].toDouble(&ok);
         if (!ok)
             return 0;
-        const QString filter = list[3];
-        const double hfr = QString(list[4]).toDouble(&ok);
+        const QString filter = list[3].toString();
+        const double hfr = list[4].toDouble(&ok);
         if (!ok)
             return 0;
-        const QString filename = list[5];
-        const int numStars = (list.size() > 6) ? QString(list[6]).toInt(&ok) : 0;
+        const QString filename = list[5].toString();
+        const int numStars = (list.size() > 6) ? list[6].toInt(&ok) : 0;
         if (!ok)
             return 0;
-        const int median = (list.size() > 7) ? QString(list[7]).toInt(&ok) : 0;
+        const int median = (list.size() > 7) ? list[7].toInt(&ok) : 0;
         if (!ok)
             return 0;
-        const double eccentricity = (list.size() > 8) ? QString(list[8]).toDouble(&ok) : 0;
+        const double eccentricity = (list.size() > 8) ? list[8].toDouble(&ok) : 0;
         if (!ok)
             return 0;
         processCaptureComplete(time, filename, exposureSeconds, filter, hfr, numStars, median, eccentricity, true);
     }
-    else if ((list[0] == "CaptureAborted") && (list.size() == 3))
+    else if ((list[0] == QLatin1String("CaptureAborted")) && (list.size() == 3))
     {
-        const double exposureSeconds = QString(list[2]).toDouble(&ok);
+        const double exposureSeconds = list[2].toDouble(&ok);
         if (!ok)
             return 0;
         processCaptureAborted(time, exposureSeconds, true);
     }
-    else if ((list[0] == "AutofocusStarting") && (list.size() == 4))
+    else if ((list[0] == QLatin1String("AutofocusStarting")) && (list.size() == 4))
     {
-        QString filter = list[2];
-        double temperature = QString(list[3]).toDouble(&ok);
+        QString filter = list[2].toString();
+        double temperature = list[3].toDouble(&ok);
         if (!ok)
             return 0;
         processAutofocusStarting(time, temperature, filter, true);
     }
-    else if ((list[0] == "AutofocusComplete") && (list.size() == 4))
+    else if ((list[0] == QLatin1String("AutofocusComplete")) && (list.size() == 4))
     {
-        QString filter = list[2];
-        QString samples = list[3];
+        QString filter = list[2].toString();
+        QString samples = list[3].toString();
         processAutofocusComplete(time, filter, samples, true);
     }
-    else if ((list[0] == "AutofocusAborted") && (list.size() == 4))
+    else if ((list[0] == QLatin1String("AutofocusAborted")) && (list.size() == 4))
     {
-        QString filter = list[2];
-        QString samples = list[3];
+        QString filter = list[2].toString();
+        QString samples = list[3].toString();
         processAutofocusAborted(time, filter, samples, true);
     }
-    else if ((list[0] == "GuideState") && list.size() == 3)
+    else if ((list[0] == QLatin1String("GuideState")) && list.size() == 3)
     {
-        processGuideState(time, list[2], true);
+        processGuideState(time, list[2].toString(), true);
     }
-    else if ((list[0] == "GuideStats") && list.size() == 9)
+    else if ((list[0] == QLatin1String("GuideStats")) && list.size() == 9)
     {
-        const double ra = QString(list[2]).toDouble(&ok);
+        const double ra = list[2].toDouble(&ok);
         if (!ok)
             return 0;
-        const double dec = QString(list[3]).toDouble(&ok);
+        const double dec = list[3].toDouble(&ok);
         if (!ok)
             return 0;
-        const double raPulse = QString(list[4]).toInt(&ok);
+        const double raPulse = list[4].toInt(&ok);
         if (!ok)
             return 0;
-        const double decPulse = QString(list[5]).toInt(&ok);
+        const double decPulse = list[5].toInt(&ok);
         if (!ok)
             return 0;
-        const double snr = QString(list[6]).toDouble(&ok);
+        const double snr = list[6].toDouble(&ok);
         if (!ok)
             return 0;
-        const double skyBg = QString(list[7]).toDouble(&ok);
+        const double skyBg = list[7].toDouble(&ok);
         if (!ok)
             return 0;
-        const double numStars = QString(list[8]).toInt(&ok);
+        const double numStars = list[8].toInt(&ok);
         if (!ok)
             return 0;
         processGuideStats(time, ra, dec, raPulse, decPulse, snr, skyBg, numStars, true);
     }
-    else if ((list[0] == "Temperature") && list.size() == 3)
+    else if ((list[0] == QLatin1String("Temperature")) && list.size() == 3)
     {
-        const double temperature = QString(list[2]).toDouble(&ok);
+        const double temperature = list[2].toDouble(&ok);
         if (!ok)
             return 0;
         processTemperature(time, temperature, true);
     }
-    else if ((list[0] == "MountState") && list.size() == 3)
+    else if ((list[0] == QLatin1String("MountState")) && list.size() == 3)
     {
-        processMountState(time, list[2], true);
+        processMountState(time, list[2].toString(), true);
     }
-    else if ((list[0] == "MountCoords") && (list.size() == 7 || list.size() == 8))
+    else if ((list[0] == QLatin1String("MountCoords")) && (list.size() == 7 || list.size() == 8))
     {
-        const double ra = QString(list[2]).toDouble(&ok);
+        const double ra = list[2].toDouble(&ok);
         if (!ok)
             return 0;
-        const double dec = QString(list[3]).toDouble(&ok);
+        const double dec = list[3].toDouble(&ok);
         if (!ok)
             return 0;
-        const double az = QString(list[4]).toDouble(&ok);
+        const double az = list[4].toDouble(&ok);
         if (!ok)
             return 0;
-        const double alt = QString(list[5]).toDouble(&ok);
+        const double alt = list[5].toDouble(&ok);
         if (!ok)
             return 0;
-        const int side = QString(list[6]).toInt(&ok);
+        const int side = list[6].toInt(&ok);
         if (!ok)
             return 0;
-        const double ha = (list.size() > 7) ? QString(list[7]).toDouble(&ok) : 0;
+        const double ha = (list.size() > 7) ? list[7].toDouble(&ok) : 0;
         if (!ok)
             return 0;
         processMountCoords(time, ra, dec, az, alt, side, ha, true);
     }
-    else if ((list[0] == "AlignState") && list.size() == 3)
+    else if ((list[0] == QLatin1String("AlignState")) && list.size() == 3)
     {
-        processAlignState(time, list[2], true);
+        processAlignState(time, list[2].toString(), true);
     }
-    else if ((list[0] == "MeridianFlipState") && list.size() == 3)
+    else if ((list[0] == QLatin1String("MeridianFlipState")) && list.size() == 3)
     {
-        processMountFlipState(time, list[2], true);
+        processMountFlipState(time, list[2].toString(), true);
     }
     else
     {
@@ -1385,9 +1416,10 @@ void Analyze::replot(bool adjustSlider)
 
     dateTicker->setOffset(displayStartTime.toMSecsSinceEpoch() / 1000.0);
 
-    timelinePlot->replot();
-    statsPlot->replot();
-    graphicsPlot->replot();
+    // Queued replots are merged, so scrolling or a burst of new data repaints the plots only once.
+    timelinePlot->replot(QCustomPlot::rpQueuedReplot);
+    statsPlot->replot(QCustomPlot::rpQueuedReplot);
+    graphicsPlot->replot(QCustomPlot::rpQueuedReplot);
     updateStatsValues();
 }
 
@@ -1791,6 +1823,116 @@ void Analyze::initStatsPlot()
     // Didn't include QCP::iRangeDrag as it  interacts poorly with the curson logic.
     statsPlot->setInteractions(QCP::iRangeZoom);
     statsPlot->axisRect()->setRangeZoomAxes(0, statsPlot->yAxis);
+
+    // A night of guiding has far more samples than pixels, only draw what can be seen.
+    connect(statsPlot, &QCustomPlot::beforeReplot, this, &Analyze::useBinnedStatsData);
+    connect(statsPlot, &QCustomPlot::afterReplot, this, &Analyze::useRawStatsData);
+}
+
+namespace
+{
+// Time between the first and the last sample of a graph.
+double sampleSpan(const QCPGraphDataContainer &data)
+{
+    return data.isEmpty() ? 0.0 : (data.constEnd() - 1)->key - data.constBegin()->key;
+}
+
+// Reduce the samples to the smallest and largest value of each bin of binSeconds, kept in time order.
+// NaN samples mark the gaps in the graphs, so they are kept and they end the current bin.
+void binSamples(const QCPGraphDataContainer &raw, double binSeconds, QCPGraphDataContainer *binned)
+{
+    QVector<QCPGraphData> samples;
+    samples.reserve(static_cast<int>(std::min<double>(raw.size(), 2 * (sampleSpan(raw) / binSeconds + 2))));
+
+    bool binOpen = false;
+    qint64 bin = 0;
+    QCPGraphData minSample, maxSample;
+    auto closeBin = [&]()
+    {
+        if (!binOpen)
+            return;
+        if (minSample.key < maxSample.key)
+            samples << minSample << maxSample;
+        else if (minSample.key > maxSample.key)
+            samples << maxSample << minSample;
+        else
+            samples << minSample;
+        binOpen = false;
+    };
+
+    for (auto sample = raw.constBegin(); sample != raw.constEnd(); ++sample)
+    {
+        if (qIsNaN(sample->value))
+        {
+            closeBin();
+            samples << *sample;
+            continue;
+        }
+        const qint64 sampleBin = static_cast<qint64>(std::floor(sample->key / binSeconds));
+        if (binOpen && sampleBin != bin)
+            closeBin();
+        if (!binOpen)
+        {
+            binOpen = true;
+            bin = sampleBin;
+            minSample = maxSample = *sample;
+        }
+        else if (sample->value < minSample.value)
+            minSample = *sample;
+        else if (sample->value > maxSample.value)
+            maxSample = *sample;
+    }
+    closeBin();
+
+    binned->set(samples, true);
+}
+}  // namespace
+
+// Called just before the stats plot is drawn. Graphs with more samples than pixels are given
+// the min/max of their samples per pixel, which draws the same envelope in much less time.
+// The statistics keep using the raw samples, which are put back by useRawStatsData() once drawn.
+void Analyze::useBinnedStatsData()
+{
+    const double pixels = std::max(1, statsPlot->axisRect()->width());
+    const double secondsPerPixel = statsPlot->xAxis->range().size() / pixels;
+    if (secondsPerPixel <= 0)
+        return;
+    // Bins are a power of 2 seconds wide, so that panning and small zooms reuse the binned samples.
+    const double binSeconds = std::exp2(std::floor(std::log2(secondsPerPixel)));
+
+    binnedStatsData.resize(statsPlot->graphCount());
+    for (int i = 0; i < statsPlot->graphCount(); ++i)
+    {
+        QCPGraph *graph = statsPlot->graph(i);
+        BinnedStatsData &data = binnedStatsData[i];
+        data.raw = graph->data();
+        if (!graph->visible() || data.raw->size() < 2)
+            continue;
+
+        // Binning keeps up to 2 samples per bin, it only helps graphs with more than that on average.
+        const double bins = sampleSpan(*data.raw) / binSeconds + 1;
+        if (data.raw->size() <= 2 * bins)
+            continue;
+
+        if (data.binned.isNull())
+            data.binned.reset(new QCPGraphDataContainer);
+        if (data.binSeconds != binSeconds || data.rawSize != data.raw->size())
+        {
+            binSamples(*data.raw, binSeconds, data.binned.data());
+            data.binSeconds = binSeconds;
+            data.rawSize = data.raw->size();
+        }
+        graph->setData(data.binned);
+    }
+}
+
+void Analyze::useRawStatsData()
+{
+    for (int i = 0; i < binnedStatsData.size() && i < statsPlot->graphCount(); ++i)
+    {
+        if (!binnedStatsData[i].raw.isNull())
+            statsPlot->graph(i)->setData(binnedStatsData[i].raw);
+    }
 }
 
 // Clear the graphics and state when changing input data.
@@ -1807,6 +1949,7 @@ void Analyze::reset()
 
     for (int i = 0; i < statsPlot->graphCount(); ++i)
         statsPlot->graph(i)->data()->clear();
+    binnedStatsData.clear();
     statsPlot->clearItems();
 
     for (int i = 0; i < timelinePlot->graphCount(); ++i)
@@ -1850,6 +1993,7 @@ void Analyze::reset()
     resetMountState();
     resetMountCoords();
     resetMountFlipState();
+    updateStatsAxesRanges();
 
     // Note: no replot().
 }
@@ -1995,6 +2139,7 @@ void Analyze::startLog()
     logFilename = dir + "ekos-" + QDateTime::currentDateTime().toString("yyyy-MM-ddThh-mm-ss") + ".analyze";
     logFile.setFileName(logFilename);
     logFile.open(QIODevice::WriteOnly | QIODevice::Text);
+    logStream.setDevice(&logFile);
 
     // This must happen before the below appendToLog() call.
     logInitialized = true;
@@ -2011,9 +2156,17 @@ void Analyze::appendToLog(const QString &lines)
 {
     if (!logInitialized)
         startLog();
-    QTextStream out(&logFile);
-    out << lines;
-    out.flush();
+    logStream << lines;
+    // Guide stats arrive every few seconds, don't write each one to disk separately.
+    if (!logFlushTimer.isActive())
+        logFlushTimer.start();
+}
+
+void Analyze::flushLog()
+{
+    logFlushTimer.stop();
+    if (logInitialized)
+        logStream.flush();
 }
 
 // maxXValue is the largest time value we have seen so far for this data.
@@ -285,6 +285,11 @@ class Analyze : public QWidget, public Ui::Analyze
         void addHFR(double hfr, int numCaptureStars, int median, double eccentricity,
                     const double time, double startTime);
         void addTemperature(double temperature, const double time);
+        // Rescales the stats axes whose range depends on the largest values seen.
+        void updateStatsAxesRanges();
+        // While the stats plot is drawn, dense graphs show their samples binned to the plot's resolution.
+        void useBinnedStatsData();
+        void useRawStatsData();
 
         // Initialize the graphs (axes, linestyle, pen, name, checkbox callbacks).
         // Returns the graph index.
@@ -349,12 +354,26 @@ class Analyze : public QWidget, public Ui::Analyze
         // low level file writing.
         void startLog();
         void appendToLog(const QString &lines);
+        void flushLog();
 
         // The .analyze log file being written.
         QString logFilename { "" };
         QFile logFile;
+        QTextStream logStream;
+        // Log lines are buffered and written to disk once this timer expires.
+        QTimer logFlushTimer;
         bool logInitialized { false };
 
+        // The raw samples of a stats graph, which the statistics use, and their min/max per bin, which are drawn.
+        struct BinnedStatsData
+        {
+            QSharedPointer<QCPGraphDataContainer> raw;
+            QSharedPointer<QCPGraphDataContainer> binned;
+            double binSeconds { 0 };
+            int rawSize { -1 };
+        };
+        QVector<BinnedStatsData> binnedStatsData;
+
         // These define the view for the timeline and stats plots.
         // The plots start plotStart seconds from the start of the session, and
         // are plotWidth seconds long. The end of the X-axis is maxXValue.
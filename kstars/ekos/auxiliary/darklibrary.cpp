@@ -32,6 +32,7 @@
 #include <QtConcurrent>
 #include <algorithm>
 #include <array>
+#include <type_traits>
 
 namespace Ekos
 {
@@ -604,7 +605,34 @@ T DarkLibrary::median3x3Filter(uint16_t x, uint16_t y, uint32_t width, T *buffer
     elements[6] = *(bot + 1);
     elements[7] = *(bot + 2);
 
-    std::sort(elements.begin(), elements.end());
+    // Batcher odd-even merge network for 8 elements. It is branch-free and much cheaper than
+    // std::sort for such a small fixed size, and yields the same ordering.
+    auto sortPair = [](T & a, T & b)
+    {
+        const T low = std::min(a, b);
+        b = std::max(a, b);
+        a = low;
+    };
+    sortPair(elements[0], elements[1]);
+    sortPair(elements[2], elements[3]);
+    sortPair(elements[4], elements[5]);
+    sortPair(elements[6], elements[7]);
+    sortPair(elements[0], elements[2]);
+    sortPair(elements[1], elements[3]);
+    sortPair(elements[4], elements[6]);
+    sortPair(elements[5], elements[7]);
+    sortPair(elements[1], elements[2]);
+    sortPair(elements[5], elements[6]);
+    sortPair(elements[0], elements[4]);
+    sortPair(elements[3], elements[7]);
+    sortPair(elements[1], elements[5]);
+    sortPair(elements[2], elements[6]);
+    sortPair(elements[1], elements[4]);
+    sortPair(elements[3], elements[6]);
+    sortPair(elements[2], elements[4]);
+    sortPair(elements[3], elements[5]);
+    sortPair(elements[3], elements[4]);
+
     auto median = (elements[3] + elements[4]) / 2;
     return median;
 }
@@ -671,15 +699,40 @@ void DarkLibrary::subtractInternal(const QSharedPointer<FITSData> &darkData, con
     const uint32_t darkoffset = offsetX + offsetY * darkStride;
     T const *darkBuffer  = reinterpret_cast<T const*>(darkData->getImageBuffer()) + darkoffset;
 
-    for (uint32_t y = 0; y < height; y++)
+    // Subtract bands of rows in parallel. The inner loop is branch-free so it vectorizes.
+    const uint32_t nThreads = std::max(1u, std::min(static_cast<uint32_t>(QThread::idealThreadCount()), height));
+    QList<QFuture<void>> futures;
+    // Calculate how many rows we process per thread
+    const uint32_t tStride = height / nThreads;
+    // Calculate the final stride since we can have some left over due to division above
+    const uint32_t fStride = tStride + (height - (tStride * nThreads));
+
+    for (uint32_t i = 0; i < nThreads; i++)
     {
-        for (uint32_t x = 0; x < width; x++)
-            lightBuffer[x] = (lightBuffer[x] > darkBuffer[x]) ? (lightBuffer[x] - darkBuffer[x]) : 0;
+        const uint32_t cStart = i * tStride;
+        const uint32_t cEnd = cStart + ((i == (nThreads - 1)) ? fStride : tStride);
+        futures.append(QtConcurrent::run([ = ]()
+        {
+            T *light = lightBuffer + cStart * width;
+            T const *dark = darkBuffer + cStart * darkStride;
+            for (uint32_t y = cStart; y < cEnd; y++)
+            {
+                for (uint32_t x = 0; x < width; x++)
+                {
+                    const T value = light[x];
+                    const T darkValue = dark[x];
+                    light[x] = (value > darkValue) ? static_cast<T>(value - darkValue) : static_cast<T>(0);
+                }
 
-        lightBuffer += width;
-        darkBuffer += darkStride;
+                light += width;
+                dark += darkStride;
+            }
+        }));
     }
 
+    for (auto &oneFuture : futures)
+        oneFuture.waitForFinished();
+
     lightData->calculateStats(true);
     emit darkFrameCompleted(true);
 }
@@ -770,7 +823,10 @@ void DarkLibrary::processNewBLOB(IBLOB *bp)
 
     uint32_t totalElements = m_CurrentDarkFrame->channels() * m_CurrentDarkFrame->samplesPerChannel();
     if (totalElements != m_DarkMasterBuffer.size())
+    {
         m_DarkMasterBuffer.assign(totalElements, 0);
+        resetDarkAggregation();
+    }
 
     aggregate(m_CurrentDarkFrame);
     darkProgress->setValue(darkProgress->value() + 1);
@@ -1368,6 +1424,7 @@ void DarkLibrary::generateDarkJobs()
 void DarkLibrary::executeDarkJobs()
 {
     m_DarkImagesCounter = 0;
+    resetDarkAggregation();
     darkProgress->setValue(0);
     darkProgress->setTextVisible(true);
     connect(m_CaptureModule, &Capture::newImage, this, &DarkLibrary::processNewImage, Qt::UniqueConnection);
@@ -1459,9 +1516,100 @@ void DarkLibrary::aggregate(const QSharedPointer<FITSData> &data)
 template <typename T>
 void DarkLibrary::aggregateInternal(const QSharedPointer<FITSData> &data)
 {
-    T const *darkBuffer  = reinterpret_cast<T const*>(data->getImageBuffer());
-    for (uint32_t i = 0; i < m_DarkMasterBuffer.size(); i++)
-        m_DarkMasterBuffer[i] += darkBuffer[i];
+    const size_t frameBytes = m_DarkMasterBuffer.size() * sizeof(T);
+    if (m_DarkChunkBuffer.size() != frameBytes * MAX_DARK_CHUNK_FRAMES)
+    {
+        m_DarkChunkBuffer.assign(frameBytes * MAX_DARK_CHUNK_FRAMES, 0);
+        m_DarkChunkFrames = 0;
+    }
+
+    memcpy(m_DarkChunkBuffer.data() + m_DarkChunkFrames * frameBytes, data->getImageBuffer(), frameBytes);
+    m_DarkChunkFrames++;
+
+    if (m_DarkChunkFrames >= darkChunkTarget())
+        combineDarkChunk<T>();
+}
+
+///////////////////////////////////////////////////////////////////////////////////////
+///
+///////////////////////////////////////////////////////////////////////////////////////
+uint32_t DarkLibrary::darkChunkTarget() const
+{
+    // Split the frames still expected for this job into equally sized chunks so that
+    // the last chunk is never left with one or two frames that cannot reject anything.
+    const uint32_t expected = countSpin->value();
+    if (expected <= m_DarkFramesAggregated)
+        return MAX_DARK_CHUNK_FRAMES;
+
+    const uint32_t remaining = expected - m_DarkFramesAggregated;
+    const uint32_t chunks = (remaining + MAX_DARK_CHUNK_FRAMES - 1) / MAX_DARK_CHUNK_FRAMES;
+    return (remaining + chunks - 1) / chunks;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////
+///
+///////////////////////////////////////////////////////////////////////////////////////
+template <typename T>
+void DarkLibrary::combineDarkChunk()
+{
+    const uint32_t frames = m_DarkChunkFrames;
+    if (frames == 0)
+        return;
+
+    T const *chunk = reinterpret_cast<T const*>(m_DarkChunkBuffer.data());
+    float *master = m_DarkMasterBuffer.data();
+    const uint32_t samples = m_DarkMasterBuffer.size();
+    // Weight of this chunk in the running mean of all chunk medians.
+    const float weight = frames / static_cast<float>(m_DarkFramesAggregated + frames);
+
+    const int nThreads = QThread::idealThreadCount();
+    QList<QFuture<void>> futures;
+    // Calculate how many elements we process per thread
+    const uint32_t tStride = samples / nThreads;
+    // Calculate the final stride since we can have some left over due to division above
+    const uint32_t fStride = tStride + (samples - (tStride * nThreads));
+
+    for (int i = 0; i < nThreads; i++)
+    {
+        const uint32_t cStart = i * tStride;
+        const uint32_t cEnd = cStart + ((i == (nThreads - 1)) ? fStride : tStride);
+        futures.append(QtConcurrent::run([ = ]()
+        {
+            std::array<T, MAX_DARK_CHUNK_FRAMES> values;
+            const auto begin = values.begin();
+            const auto middle = begin + frames / 2;
+            const auto end = begin + frames;
+
+            for (uint32_t j = cStart; j < cEnd; j++)
+            {
+                for (uint32_t k = 0; k < frames; k++)
+                    values[k] = chunk[k * samples + j];
+
+                std::nth_element(begin, middle, end);
+                float median = *middle;
+                if (frames % 2 == 0)
+                    median = (median + *std::max_element(begin, middle)) / 2.0f;
+
+                master[j] += (median - master[j]) * weight;
+            }
+        }));
+    }
+
+    for (auto &oneFuture : futures)
+        oneFuture.waitForFinished();
+
+    m_DarkFramesAggregated += frames;
+    m_DarkChunkFrames = 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////////////
+///
+///////////////////////////////////////////////////////////////////////////////////////
+void DarkLibrary::resetDarkAggregation()
+{
+    m_DarkMasterBuffer.assign(m_DarkMasterBuffer.size(), 0);
+    m_DarkFramesAggregated = 0;
+    m_DarkChunkFrames = 0;
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////
@@ -1508,7 +1656,7 @@ void DarkLibrary::generateMasterFrame(const QSharedPointer<FITSData> &data, cons
     }
 
     // Reset Master Buffer
-    m_DarkMasterBuffer.assign(m_DarkMasterBuffer.size(), 0);
+    resetDarkAggregation();
 }
 
 ///////////////////////////////////////////////////////////////////////////////////////
@@ -1517,11 +1665,13 @@ void DarkLibrary::generateMasterFrame(const QSharedPointer<FITSData> &data, cons
 template <typename T>  void DarkLibrary::generateMasterFrameInternal(const QSharedPointer<FITSData> &data,
         const QJsonObject &metadata)
 {
+    // Fold in the frames of the last, possibly partial, chunk.
+    combineDarkChunk<T>();
+
     T *writableBuffer = reinterpret_cast<T *>(data->getWritableImageBuffer());
-    const uint32_t count = metadata["count"].toInt();
-    // Average the values
     for (uint32_t i = 0; i < m_DarkMasterBuffer.size(); i++)
-        writableBuffer[i] = m_DarkMasterBuffer[i] / count;
+        writableBuffer[i] = std::is_integral<T>::value ? static_cast<T>(std::lround(m_DarkMasterBuffer[i])) :
+                            static_cast<T>(m_DarkMasterBuffer[i]);
 
 
     QString ts = QDateTime::currentDateTime().toString("yyyy-MM-ddThh-mm-ss");
@@ -131,11 +131,28 @@ class DarkLibrary : public QDialog, public Ui::DarkLibrary
 
         /**
          * @brief aggregate Aggregate the data as per the selected algorithm. Each time a new dark frame is received, this function
-         * adds the frame data to the dark buffer.
+         * adds the frame data to the current chunk, and combines the chunk into the dark buffer once it is full.
          * @param data Dark frame data.
          */
         template <typename T> void aggregateInternal(const QSharedPointer<FITSData> &data);
 
+        /**
+         * @brief combineDarkChunk Take the per-pixel median of the frames in the current chunk, which rejects cosmic rays
+         * and transient hot pixels, and fold it into the running mean kept in the dark buffer. Memory stays bounded by
+         * MAX_DARK_CHUNK_FRAMES frames regardless of how many darks are taken.
+         */
+        template <typename T> void combineDarkChunk();
+
+        /**
+         * @brief darkChunkTarget Number of frames the current chunk should hold before it is combined.
+         */
+        uint32_t darkChunkTarget() const;
+
+        /**
+         * @brief resetDarkAggregation Clear the dark buffer and any partially filled chunk.
+         */
+        void resetDarkAggregation();
+
         /**
          * @brief subtractHelper Calls tempelated subtract function
          * @param darkData passes dark frame data to templerated subtract function.
@@ -227,7 +244,14 @@ class DarkLibrary : public QDialog, public Ui::DarkLibrary
         QSqlTableModel *darkFramesModel = nullptr;
         QSortFilterProxyModel *sortFilter = nullptr;
 
-        std::vector<uint32_t> m_DarkMasterBuffer;
+        // Maximum number of dark frames held in memory for median combination.
+        static constexpr uint8_t MAX_DARK_CHUNK_FRAMES { 5 };
+        // Running mean of the chunk medians.
+        std::vector<float> m_DarkMasterBuffer;
+        // Raw frames of the chunk being collected.
+        std::vector<uint8_t> m_DarkChunkBuffer;
+        uint32_t m_DarkChunkFrames {0};
+        uint32_t m_DarkFramesAggregated {0};
         uint32_t m_DarkImagesCounter {0};
         bool m_RememberFITSViewer {true};
         bool m_RememberSummaryView {true};
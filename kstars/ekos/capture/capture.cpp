@@ -14,6 +14,7 @@
 #include "kstarsdata.h"
 #include "Options.h"
 #include "rotatorsettings.h"
+#include "capturefileindex.h"
 #include "sequencejob.h"
 #include "placeholderpath.h"
 #include "skymap.h"
@@ -2416,51 +2417,22 @@ void Capture::checkSeqBoundary(const QString &path)
     int newFileIndex = -1;
     QFileInfo const path_info(path);
     QString const sig_dir(path_info.dir().path());
-    QString const sig_file(path_info.completeBaseName());
-    QString tempName;
     // seqFileCount = 0;
 
     // No updates during meridian flip
     if (meridianFlipStage >= MF_ALIGNING)
         return;
 
-    QDirIterator it(sig_dir, QDir::Files);
+    QString finalSeqPrefix = seqPrefix;
+    finalSeqPrefix.remove(SequenceJob::ISOMarker);
 
-    while (it.hasNext())
-    {
-        tempName = it.next();
-        QFileInfo info(tempName);
-
-        // This returns the filename without the extension
-        tempName = info.completeBaseName();
-
-        // This remove any additional extension (e.g. m42_001.fits.fz)
-        // the completeBaseName() would return m42_001.fits
-        // and this remove .fits so we end up with m42_001
-        tempName = tempName.remove(".fits");
-
-        QString finalSeqPrefix = seqPrefix;
-        finalSeqPrefix.remove(SequenceJob::ISOMarker);
-        // find the prefix first
-        if (tempName.startsWith(finalSeqPrefix, Qt::CaseInsensitive) == false)
-            continue;
-
-        /* Do not change the number of captures.
-         * - If the sequence is required by the end-user, unconditionally run what each sequence item is requiring.
-         * - If the sequence is required by the scheduler, use capturedFramesMap to determine when to stop capturing.
-         */
-        //seqFileCount++;
-
-        int lastUnderScoreIndex = tempName.lastIndexOf("_");
-        if (lastUnderScoreIndex > 0)
-        {
-            bool indexOK = false;
-
-            newFileIndex = tempName.midRef(lastUnderScoreIndex + 1).toInt(&indexOK);
-            if (indexOK && newFileIndex >= nextSequenceID)
-                nextSequenceID = newFileIndex + 1;
-        }
-    }
+    /* Do not change the number of captures.
+     * - If the sequence is required by the end-user, unconditionally run what each sequence item is requiring.
+     * - If the sequence is required by the scheduler, use capturedFramesMap to determine when to stop capturing.
+     */
+    newFileIndex = CaptureFileIndex::Instance()->lastSequenceID(sig_dir, finalSeqPrefix);
+    if (newFileIndex >= nextSequenceID)
+        nextSequenceID = newFileIndex + 1;
 }
 
 void Capture::appendLogText(const QString &text)
@@ -0,0 +1,163 @@
+/*  Ekos Capture File Index
+    Copyright (C) 2021 KStars Team
+
+    This application is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+ */
+
+#include "capturefileindex.h"
+
+#include <QDir>
+#include <QFileInfo>
+
+#include <algorithm>
+
+#include <ekos_capture_debug.h>
+
+namespace
+{
+// Range of sorted names starting with prefix
+QPair<QStringList::const_iterator, QStringList::const_iterator> prefixRange(const QStringList &names,
+        const QString &prefix)
+{
+    auto begin = std::lower_bound(names.constBegin(), names.constEnd(), prefix);
+    auto end = std::lower_bound(begin, names.constEnd(), prefix + QChar(0xFFFF));
+    return qMakePair(begin, end);
+}
+
+// Insert a name into sorted names, keeping them sorted
+void insertSorted(QStringList &names, const QString &name)
+{
+    names.insert(std::lower_bound(names.begin(), names.end(), name), name);
+}
+
+// Base name used for sequence numbers, without any ".fits" (e.g. m42_001.fits.fz)
+QString sequenceName(QString baseName)
+{
+    return baseName.remove(".fits").toLower();
+}
+}
+
+namespace Ekos
+{
+
+CaptureFileIndex *CaptureFileIndex::_CaptureFileIndex = nullptr;
+
+CaptureFileIndex *CaptureFileIndex::Instance()
+{
+    if (_CaptureFileIndex == nullptr)
+        _CaptureFileIndex = new CaptureFileIndex();
+
+    return _CaptureFileIndex;
+}
+
+const CaptureFileIndex::Listing &CaptureFileIndex::listing(const QString &directory)
+{
+    const QString path = QDir::cleanPath(directory);
+    const QDateTime lastModified = QFileInfo(path).lastModified();
+
+    auto cached = m_Listings.find(path);
+    if (cached != m_Listings.end() && cached->settled && cached->lastModified == lastModified)
+        return cached.value();
+
+    // A listing read within the settle time after the last modification may miss files added during
+    // the same modification time tick, so it is read again on the next query.
+    Listing newListing;
+    newListing.lastModified = lastModified;
+    newListing.settled = lastModified.msecsTo(QDateTime::currentDateTime()) > m_SettleTime;
+
+    const QStringList fileNames = QDir(path).entryList(QDir::Files, QDir::NoSort);
+    newListing.baseNames.reserve(fileNames.size());
+    newListing.sequenceNames.reserve(fileNames.size());
+    newListing.fileNames.reserve(fileNames.size());
+    for (const QString &fileName : fileNames)
+    {
+        newListing.fileNames.insert(fileName);
+        const QString baseName = QFileInfo(fileName).completeBaseName();
+        newListing.baseNames.append(baseName);
+        newListing.sequenceNames.append(sequenceName(baseName));
+    }
+    std::sort(newListing.baseNames.begin(), newListing.baseNames.end());
+    std::sort(newListing.sequenceNames.begin(), newListing.sequenceNames.end());
+
+    qCDebug(KSTARS_EKOS_CAPTURE) << "Indexed" << fileNames.size() << "files in" << path;
+
+    return m_Listings[path] = newListing;
+}
+
+int CaptureFileIndex::count(const QString &directory, const QString &prefix)
+{
+    QMutexLocker locker(&m_Mutex);
+    auto range = prefixRange(listing(directory).baseNames, prefix);
+    return static_cast<int>(std::distance(range.first, range.second));
+}
+
+int CaptureFileIndex::lastSequenceID(const QString &directory, const QString &prefix)
+{
+    QMutexLocker locker(&m_Mutex);
+    auto range = prefixRange(listing(directory).sequenceNames, prefix.toLower());
+
+    int lastID = -1;
+    for (auto name = range.first; name != range.second; ++name)
+    {
+        int lastUnderScoreIndex = name->lastIndexOf("_");
+        if (lastUnderScoreIndex > 0)
+        {
+            bool indexOK = false;
+            int fileIndex = name->midRef(lastUnderScoreIndex + 1).toInt(&indexOK);
+            if (indexOK && fileIndex > lastID)
+                lastID = fileIndex;
+        }
+    }
+
+    return lastID;
+}
+
+void CaptureFileIndex::add(const QString &filePath, const QDateTime &directoryModified)
+{
+    const QFileInfo file(filePath);
+    const QString path = QDir::cleanPath(file.absolutePath());
+
+    QMutexLocker locker(&m_Mutex);
+    auto cached = m_Listings.find(path);
+    if (cached == m_Listings.end())
+        return;
+
+    // If the directory changed since it was listed, something else than this file changed in it
+    if (!cached->settled || cached->lastModified != directoryModified)
+    {
+        m_Listings.erase(cached);
+        return;
+    }
+
+    // A file written again over an older one is already listed
+    if (!cached->fileNames.contains(file.fileName()))
+    {
+        cached->fileNames.insert(file.fileName());
+        insertSorted(cached->baseNames, file.completeBaseName());
+        insertSorted(cached->sequenceNames, sequenceName(file.completeBaseName()));
+    }
+
+    // As in listing(), another file may have been added during the same modification time tick
+    const QDateTime lastModified = QFileInfo(path).lastModified();
+    if (lastModified.msecsTo(QDateTime::currentDateTime()) > m_SettleTime)
+        cached->lastModified = lastModified;
+    else
+        cached->settled = false;
+}
+
+void CaptureFileIndex::invalidate(const QString &directory)
+{
+    QMutexLocker locker(&m_Mutex);
+    m_Listings.remove(QDir::cleanPath(directory));
+}
+
+void CaptureFileIndex::setSettleTime(int msecs)
+{
+    QMutexLocker locker(&m_Mutex);
+    m_SettleTime = msecs;
+}
+
+}
@@ -0,0 +1,105 @@
+/*  Ekos Capture File Index
+    Copyright (C) 2021 KStars Team
+
+    This application is free software; you can redistribute it and/or
+    modify it under the terms of the GNU General Public
+    License as published by the Free Software Foundation; either
+    version 2 of the License, or (at your option) any later version.
+ */
+
+#pragma once
+
+#include <QDateTime>
+#include <QHash>
+#include <QMutex>
+#include <QSet>
+#include <QStringList>
+
+namespace Ekos
+{
+
+/**
+ * @class CaptureFileIndex
+ * @brief Index of the file names found in capture storage directories.
+ *
+ * Each directory is listed once and its sorted file names are kept, so counting the captures of a
+ * sequence is a binary search instead of a walk through the whole storage directory.
+ *
+ * The files KStars writes itself are reported with add() and inserted into the cached listing. The
+ * listing of a directory is read again only when its modification time changes for another reason,
+ * which happens when a file is added, removed or renamed in it from outside. As the modification time
+ * may have a resolution of a few seconds, a listing read within the settle time after the last
+ * modification is not trusted and is read again on the next query.
+ */
+class CaptureFileIndex
+{
+    public:
+        static CaptureFileIndex *Instance();
+
+        /**
+         * @brief count Count the files of a directory whose base name starts with a prefix.
+         * @param directory Directory to look into.
+         * @param prefix Case-sensitive prefix of the file base name, as in QFileInfo::completeBaseName().
+         * @return Number of matching files.
+         */
+        int count(const QString &directory, const QString &prefix);
+
+        /**
+         * @brief lastSequenceID Find the highest sequence number of the files with a prefix.
+         * The ".fits" part of the file names and the case are ignored, the sequence number is the
+         * number after the last underscore, as in m42_Light_005.fits.fz.
+         * @param directory Directory to look into.
+         * @param prefix Case-insensitive prefix of the file names.
+         * @return Highest sequence number, or -1 if no file has one.
+         */
+        int lastSequenceID(const QString &directory, const QString &prefix);
+
+        /**
+         * @brief add Insert a file written by KStars into the listing of its directory.
+         * The listing is only updated if the directory did not change since it was listed, otherwise
+         * it is forgotten and read again on the next query. It is also read again if the directory was
+         * modified within the settle time, as another file may have been added during the same time tick.
+         * @param filePath Path of the file that was written.
+         * @param directoryModified Modification time of the directory just before the file was written.
+         */
+        void add(const QString &filePath, const QDateTime &directoryModified);
+
+        /**
+         * @brief invalidate Forget the listing of a directory, it is read again on the next query.
+         */
+        void invalidate(const QString &directory);
+
+        /**
+         * @brief setSettleTime Set how long after the last modification of a directory its listing is trusted.
+         * @param msecs Settle time in milliseconds, 2000 by default.
+         */
+        void setSettleTime(int msecs);
+
+    private:
+        CaptureFileIndex() = default;
+
+        struct Listing
+        {
+            /// Modification time of the directory when it was listed
+            QDateTime lastModified;
+            /// Whether the directory was listed after the settle time, so the listing is complete
+            bool settled { false };
+            /// Name of each file
+            QSet<QString> fileNames;
+            /// Sorted QFileInfo::completeBaseName() of each file
+            QStringList baseNames;
+            /// Sorted lower case base names without ".fits", for sequence numbers
+            QStringList sequenceNames;
+        };
+
+        // Get the listing of a directory, reading it again if it changed. Called with m_Mutex locked.
+        const Listing &listing(const QString &directory);
+
+        static CaptureFileIndex *_CaptureFileIndex;
+
+        QHash<QString, Listing> m_Listings;
+        QMutex m_Mutex;
+        int m_SettleTime { 2000 };
+};
+
+}
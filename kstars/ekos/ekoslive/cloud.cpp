@@ -175,13 +175,15 @@ void Cloud::asyncUpload()
     // Filename only without path
     QString filepath = m_ImageData->isCompressed() ? m_ImageData->compressedFilename() : m_ImageData->filename();
     QString filenameOnly = QFileInfo(filepath).fileName();
+    // Captures saved tile-compressed are decoded from the uncompressed blob, but the file is already packed
+    const bool isPacked = m_ImageData->isCompressed() || filepath.endsWith(".fz");
 
     // Add filename and size as wells
     metadata.insert("uuid", m_UUID);
     metadata.insert("filename", filenameOnly);
     metadata.insert("filesize", static_cast<int>(m_ImageData->size()));
     // Must set Content-Disposition so
-    if (m_ImageData->isCompressed())
+    if (isPacked)
         metadata.insert("Content-Disposition", QString("attachment;filename=%1").arg(filenameOnly));
     else
         metadata.insert("Content-Disposition", QString("attachment;filename=%1.fz").arg(filenameOnly));
@@ -193,7 +195,7 @@ void Cloud::asyncUpload()
 
     QString compressedFile = filepath;
     // Use cfitsio pack to compress the file first
-    if (m_ImageData->isCompressed() == false)
+    if (isPacked == false)
     {
         compressedFile = QDir::tempPath() + QString("/ekoslivecloud%1").arg(m_UUID);
 
@@ -21,8 +21,12 @@
 #include "ekos/auxiliary/stellarsolverprofileeditor.h"
 
 #include <QVector3D>
+#include <algorithm>
 #include <cmath>
+#include <limits>
 #include <set>
+#include <type_traits>
+#include <vector>
 
 #define DEF_SQR_0 (8 - 0)
 #define DEF_SQR_1 (16 - 0)
@@ -66,6 +70,249 @@ typedef struct
     int x, y;
 } point_t;
 
+namespace
+{
+// Sums the pixels of each ring of the 9x9 kernel used by the "Fast" (CENTROID_THRESHOLD) algorithm.
+// p is the top left corner of the kernel. Pixels are always added row by row, left to right, so
+// float sums do not depend on the order in which kernel positions are scanned.
+template <typename T, typename S>
+inline void kernelRingSums(T const *p, int stride, S sums[9])
+{
+    S i0 = 0, i1 = 0, i2 = 0, i3 = 0, i4 = 0, i5 = 0, i6 = 0, i7 = 0, i8 = 0;
+    T const *r = p;
+
+    i8 += r[0]; i8 += r[1]; i8 += r[2]; i8 += r[3]; i8 += r[4]; i8 += r[5]; i8 += r[6]; i8 += r[7]; i8 += r[8];
+    r += stride;
+    i8 += r[0]; i8 += r[1]; i8 += r[2]; i7 += r[3]; i6 += r[4]; i7 += r[5]; i8 += r[6]; i8 += r[7]; i8 += r[8];
+    r += stride;
+    i8 += r[0]; i8 += r[1]; i5 += r[2]; i4 += r[3]; i3 += r[4]; i4 += r[5]; i5 += r[6]; i8 += r[7]; i8 += r[8];
+    r += stride;
+    i8 += r[0]; i7 += r[1]; i4 += r[2]; i2 += r[3]; i1 += r[4]; i2 += r[5]; i4 += r[6]; i8 += r[7]; i8 += r[8];
+    r += stride;
+    i8 += r[0]; i6 += r[1]; i3 += r[2]; i1 += r[3]; i0 += r[4]; i1 += r[5]; i3 += r[6]; i6 += r[7]; i8 += r[8];
+    r += stride;
+    i8 += r[0]; i7 += r[1]; i4 += r[2]; i2 += r[3]; i1 += r[4]; i2 += r[5]; i4 += r[6]; i8 += r[7]; i8 += r[8];
+    r += stride;
+    i8 += r[0]; i8 += r[1]; i5 += r[2]; i4 += r[3]; i3 += r[4]; i4 += r[5]; i5 += r[6]; i8 += r[7]; i8 += r[8];
+    r += stride;
+    i8 += r[0]; i8 += r[1]; i8 += r[2]; i7 += r[3]; i6 += r[4]; i7 += r[5]; i8 += r[6]; i8 += r[7]; i8 += r[8];
+    r += stride;
+    i8 += r[0]; i8 += r[1]; i8 += r[2]; i8 += r[3]; i8 += r[4]; i8 += r[5]; i8 += r[6]; i8 += r[7]; i8 += r[8];
+
+    sums[0] = i0;
+    sums[1] = i1;
+    sums[2] = i2;
+    sums[3] = i3;
+    sums[4] = i4;
+    sums[5] = i5;
+    sums[6] = i6;
+    sums[7] = i7;
+    sums[8] = i8;
+}
+
+// Weight of each ring of the "Fast" kernel.
+constexpr double P0 = 0.906, P1 = 0.584, P2 = 0.365, P3 = 0.117, P4 = 0.049, P5 = -0.05, P6 = -0.064, P7 = -0.074,
+                 P8 = -0.094;
+
+// How well the rings of the "Fast" kernel around a pixel match a star.
+inline double kernelFit(float i0, float i1, float i2, float i3, float i4, float i5, float i6, float i7, float i8)
+{
+    const double average = (i0 + i1 + i2 + i3 + i4 + i5 + i6 + i7 + i8) / 85.0;
+    return P0 * (i0 - average) + P1 * (i1 - 4 * average) + P2 * (i2 - 4 * average) +
+           P3 * (i3 - 4 * average) + P4 * (i4 - 8 * average) + P5 * (i5 - 4 * average) +
+           P6 * (i6 - 4 * average) + P7 * (i7 - 8 * average) + P8 * (i8 - 48 * average);
+}
+
+// Keeps the best fit. On equal fits, the position with the smallest x then the smallest y wins,
+// as when the tracking box was scanned column by column.
+inline void keepBestFit(double fit, int x, int y, double *bestFit, int *ix, int *iy)
+{
+    if (*bestFit < fit || (*bestFit == fit && x < *ix))
+    {
+        *bestFit = fit;
+        *ix      = x;
+        *iy      = y;
+    }
+}
+
+// 8 and 16 bit pixels are summed exactly as integers: the largest ring sum, 81 pixels of 65535, is
+// still exactly representable as a float, so the sums do not depend on the order they are made in.
+template <typename T>
+using ExactKernelSums = std::integral_constant < bool, std::is_integral<T>::value && sizeof(T) <= 2 >;
+
+// Finds the best fit of the "Fast" kernel in the tracking box, evaluating the whole kernel at each position.
+template <typename T>
+double findKernelPeak(T const *psrc, int stride, int width, int height, int *ix, int *iy, std::false_type)
+{
+    float sums[9];
+    double bestFit = 0;
+    for (int y = 0; y < height; y++)
+    {
+        T const *row = psrc + (y - 4) * stride - 4;
+        for (int x = 0; x < width; x++)
+        {
+            kernelRingSums(row + x, stride, sums);
+            keepBestFit(kernelFit(sums[0], sums[1], sums[2], sums[3], sums[4], sums[5], sums[6], sums[7], sums[8]),
+                        x, y, &bestFit, ix, iy);
+        }
+    }
+    return bestFit;
+}
+
+// Finds the best fit of the "Fast" kernel in the tracking box from running column sums.
+// For each row of the box, the pixels of each column are summed once per kernel row distance, then
+// the rings of every position are put together from a few of these column sums. The sum of the whole
+// kernel slides along the row. This gives the same sums as evaluating the kernel at each position.
+template <typename T>
+double findKernelPeak(T const *psrc, int stride, int width, int height, int *ix, int *iy, std::true_type)
+{
+    // The kernel spans 4 columns on each side of the box
+    const int columns = width + 8;
+    // Sums of the center row, of the two rows 1 to 4 rows away from it, and of all 9 rows of each column
+    std::vector<int32_t> v0(columns), v1(columns), v2(columns), v3(columns), v4(columns), v9(columns);
+
+    double bestFit = 0;
+    for (int y = 0; y < height; y++)
+    {
+        T const *center = psrc + y * stride - 4;
+        for (int c = 0; c < columns; c++)
+        {
+            T const *p = center + c;
+            v0[c] = p[0];
+            v1[c] = p[-stride] + p[stride];
+            v2[c] = p[-2 * stride] + p[2 * stride];
+            v3[c] = p[-3 * stride] + p[3 * stride];
+            v4[c] = p[-4 * stride] + p[4 * stride];
+            v9[c] = v0[c] + v1[c] + v2[c] + v3[c] + v4[c];
+        }
+
+        int32_t total = 0;
+        for (int c = 0; c < 9; c++)
+            total += v9[c];
+
+        for (int x = 0; x < width; x++)
+        {
+            // Column of the kernel center
+            const int c = x + 4;
+            if (x > 0)
+                total += v9[c + 4] - v9[c - 5];
+
+            const int32_t i0 = v0[c];
+            const int32_t i1 = v1[c] + v0[c - 1] + v0[c + 1];
+            const int32_t i2 = v1[c - 1] + v1[c + 1];
+            const int32_t i3 = v2[c] + v0[c - 2] + v0[c + 2];
+            const int32_t i4 = v2[c - 1] + v2[c + 1] + v1[c - 2] + v1[c + 2];
+            const int32_t i5 = v2[c - 2] + v2[c + 2];
+            const int32_t i6 = v3[c] + v0[c - 3] + v0[c + 3];
+            // As in the kernel, the pixels 3 columns right of the center and 1 row away belong to the outer ring
+            const int32_t i7 = v3[c - 1] + v3[c + 1] + v1[c - 3];
+            const int32_t i8 = total - (i0 + i1 + i2 + i3 + i4 + i5 + i6 + i7);
+
+            keepBestFit(kernelFit(i0, i1, i2, i3, i4, i5, i6, i7, i8), x, y, &bestFit, ix, iy);
+        }
+    }
+    return bestFit;
+}
+
+// Largest of the n pixels of a row. Four running maxima keep the comparisons independent of each other.
+template <typename T>
+T rowMaximum(T const *p, int n)
+{
+    T m0 = p[0], m1 = p[0], m2 = p[0], m3 = p[0];
+    int i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        m0 = std::max(m0, p[i]);
+        m1 = std::max(m1, p[i + 1]);
+        m2 = std::max(m2, p[i + 2]);
+        m3 = std::max(m3, p[i + 3]);
+    }
+    for (; i < n; ++i)
+        m0 = std::max(m0, p[i]);
+    return std::max(std::max(m0, m1), std::max(m2, m3));
+}
+
+// Pixels of up to 32 bits are summed exactly as 64-bit integers, as the double sums they replace were exact too.
+template <typename T>
+using FrameSum = typename std::conditional < std::is_integral<T>::value && sizeof(T) <= 4, int64_t, double >::type;
+
+// Centroid of the pixels of the tracking box above threshold, relative to the box.
+// If the largest pixel of each row is given, rows without any pixel above threshold are skipped,
+// as they add nothing to the centroid.
+template <typename T>
+Vector thresholdCentroid(T const *psrc, int stride, int boxWidth, double threshold, T const *rowMax = nullptr)
+{
+    double resx = 0, resy = 0, mass = 0;
+    for (int j = 0; j < boxWidth; ++j, psrc += stride)
+    {
+        if (rowMax != nullptr && rowMax[j] <= threshold)
+            continue;
+
+        for (int i = 0; i < boxWidth; ++i)
+        {
+            double pval = psrc[i] - threshold;
+            pval = pval < 0 ? 0 : pval;
+
+            resx += (double)i * pval;
+            resy += (double)j * pval;
+
+            mass += pval;
+        }
+    }
+
+    if (mass == 0)
+        mass = 1;
+
+    return Vector(resx / mass, resy / mass, 0);
+}
+
+template <typename T>
+void copyToFloat(uint8_t const *buffer, int width, const QRect &rect, float *destination)
+{
+    T const *source = reinterpret_cast<T const *>(buffer) + rect.y() * width + rect.x();
+    for (int line = 0; line < rect.height(); line++, source += width)
+        for (int i = 0; i < rect.width(); i++)
+            *destination++ = source[i];
+}
+
+// Converts a rectangle of the first plane of the image to a row-major float array.
+bool copyToFloat(const QSharedPointer<FITSData> &imageData, const QRect &rect, float *destination)
+{
+    uint8_t const *buffer = imageData->getImageBuffer();
+    const int width = imageData->width();
+
+    switch (imageData->getStatistics().dataType)
+    {
+        case TBYTE:
+            copyToFloat<uint8_t>(buffer, width, rect, destination);
+            return true;
+        case TSHORT:
+            copyToFloat<int16_t>(buffer, width, rect, destination);
+            return true;
+        case TUSHORT:
+            copyToFloat<uint16_t>(buffer, width, rect, destination);
+            return true;
+        case TLONG:
+            copyToFloat<int32_t>(buffer, width, rect, destination);
+            return true;
+        case TULONG:
+            copyToFloat<uint32_t>(buffer, width, rect, destination);
+            return true;
+        case TFLOAT:
+            copyToFloat<float>(buffer, width, rect, destination);
+            return true;
+        case TLONGLONG:
+            copyToFloat<int64_t>(buffer, width, rect, destination);
+            return true;
+        case TDOUBLE:
+            copyToFloat<double>(buffer, width, rect, destination);
+            return true;
+        default:
+            return false;
+    }
+}
+}
+
 cgmath::cgmath() : QObject()
 {
     // sky coord. system vars.
@@ -345,75 +592,10 @@ float *cgmath::createFloatImage(const QSharedPointer<FITSData> &target) const
         return nullptr;
     }
 
-    switch (imageData->getStatistics().dataType)
+    if (!copyToFloat(imageData, QRect(0, 0, imageData->width(), imageData->height()), imgFloat))
     {
-        case TBYTE:
-        {
-            uint8_t const *buffer = imageData->getImageBuffer();
-            for (uint32_t i = 0; i < imgSize; i++)
-                imgFloat[i] = buffer[i];
-        }
-        break;
-
-        case TSHORT:
-        {
-            int16_t const *buffer = reinterpret_cast<int16_t const *>(imageData->getImageBuffer());
-            for (uint32_t i = 0; i < imgSize; i++)
-                imgFloat[i] = buffer[i];
-        }
-        break;
-
-        case TUSHORT:
-        {
-            uint16_t const *buffer = reinterpret_cast<uint16_t const*>(imageData->getImageBuffer());
-            for (uint32_t i = 0; i < imgSize; i++)
-                imgFloat[i] = buffer[i];
-        }
-        break;
-
-        case TLONG:
-        {
-            int32_t const *buffer = reinterpret_cast<int32_t const*>(imageData->getImageBuffer());
-            for (uint32_t i = 0; i < imgSize; i++)
-                imgFloat[i] = buffer[i];
-        }
-        break;
-
-        case TULONG:
-        {
-            uint32_t const *buffer = reinterpret_cast<uint32_t const*>(imageData->getImageBuffer());
-            for (uint32_t i = 0; i < imgSize; i++)
-                imgFloat[i] = buffer[i];
-        }
-        break;
-
-        case TFLOAT:
-        {
-            float const *buffer = reinterpret_cast<float const*>(imageData->getImageBuffer());
-            for (uint32_t i = 0; i < imgSize; i++)
-                imgFloat[i] = buffer[i];
-        }
-        break;
-
-        case TLONGLONG:
-        {
-            int64_t const *buffer = reinterpret_cast<int64_t const*>(imageData->getImageBuffer());
-            for (uint32_t i = 0; i < imgSize; i++)
-                imgFloat[i] = buffer[i];
-        }
-        break;
-
-        case TDOUBLE:
-        {
-            double const *buffer = reinterpret_cast<double const*>(imageData->getImageBuffer());
-            for (uint32_t i = 0; i < imgSize; i++)
-                imgFloat[i] = buffer[i];
-        }
-        break;
-
-        default:
-            delete[] imgFloat;
-            return nullptr;
+        delete[] imgFloat;
+        return nullptr;
     }
 
     return imgFloat;
@@ -425,11 +607,6 @@ QVector<float *> cgmath::partitionImage() const
 
     const QSharedPointer<FITSData> &imageData = guideView->imageData();
 
-    float *imgFloat = createFloatImage(QSharedPointer<FITSData>());
-
-    if (imgFloat == nullptr)
-        return regions;
-
     const uint16_t width  = imageData->width();
     const uint16_t height = imageData->height();
 
@@ -438,35 +615,26 @@ QVector<float *> cgmath::partitionImage() const
     // Find number of regions to divide the image
     //uint8_t regions =  xRegions * yRegions;
 
-    float *regionPtr = imgFloat;
-
+    // Each region is converted straight from the image buffer, without a float copy of the whole frame
     for (uint8_t i = 0; i < yRegions; i++)
     {
         for (uint8_t j = 0; j < xRegions; j++)
         {
             // Allocate space for one region
             float *oneRegion = new float[regionAxis * regionAxis];
-            // Create points to region and current location of the source image in the desired region
-            float *oneRegionPtr = oneRegion, *imgFloatPtr = regionPtr + j * regionAxis;
 
-            // copy from image to region line by line
-            for (uint32_t line = 0; line < regionAxis; line++)
+            if (!copyToFloat(imageData, QRect(j * regionAxis, i * regionAxis, regionAxis, regionAxis), oneRegion))
             {
-                memcpy(oneRegionPtr, imgFloatPtr, regionAxis);
-                oneRegionPtr += regionAxis;
-                imgFloatPtr += width;
+                delete[] oneRegion;
+                foreach (float *region, regions)
+                    delete[] region;
+                return QVector<float *>();
             }
 
             regions.append(oneRegion);
         }
-
-        // Move regionPtr block by (width * regionAxis) elements
-        regionPtr += width * regionAxis;
     }
 
-    // We're done with imgFloat
-    delete[] imgFloat;
-
     return regions;
 }
 
@@ -584,15 +752,7 @@ Vector cgmath::findLocalStarPosition(void)
 template <typename T>
 Vector cgmath::findLocalStarPosition(void) const
 {
-    static const double P0 = 0.906, P1 = 0.584, P2 = 0.365, P3 = 0.117, P4 = 0.049, P5 = -0.05, P6 = -0.064, P7 = -0.074,
-                        P8 = -0.094;
-
     Vector ret;
-    int i, j;
-    double resx, resy, mass, threshold, pval;
-    T const *psrc    = nullptr;
-    T const *porigin = nullptr;
-    T const *pptr;
 
     QRect trackingBox = guideView->getTrackingBox();
 
@@ -635,317 +795,199 @@ Vector cgmath::findLocalStarPosition(void) const
 
     qCDebug(KSTARS_EKOS_GUIDE) << "Tracking Square " << trackingBox;
 
-    double square_square = trackingBox.width() * trackingBox.width();
-
-    psrc = porigin = pdata + trackingBox.y() * video_width + trackingBox.x();
-
-    resx = resy = 0;
-    threshold = mass = 0;
-
     // several threshold adaptive smart algorithms
     switch (square_alg_idx)
     {
         case CENTROID_THRESHOLD:
-        {
-            int width  = trackingBox.width();
-            int height = trackingBox.width();
-            float i0, i1, i2, i3, i4, i5, i6, i7, i8;
-            int ix = 0, iy = 0;
-            int xM4;
-            T const *p;
-            double average, fit, bestFit = 0;
-            int minx = 0;
-            int maxx = width;
-            int miny = 0;
-            int maxy = height;
-            for (int x = minx; x < maxx; x++)
-                for (int y = miny; y < maxy; y++)
-                {
-                    i0 = i1 = i2 = i3 = i4 = i5 = i6 = i7 = i8 = 0;
-                    xM4                                        = x - 4;
-                    p                                          = psrc + (y - 4) * video_width + xM4;
-                    i8 += *p++;
-                    i8 += *p++;
-                    i8 += *p++;
-                    i8 += *p++;
-                    i8 += *p++;
-                    i8 += *p++;
-                    i8 += *p++;
-                    i8 += *p++;
-                    i8 += *p++;
-                    p = psrc + (y - 3) * video_width + xM4;
-                    i8 += *p++;
-                    i8 += *p++;
-                    i8 += *p++;
-                    i7 += *p++;
-                    i6 += *p++;
-                    i7 += *p++;
-                    i8 += *p++;
-                    i8 += *p++;
-                    i8 += *p++;
-                    p = psrc + (y - 2) * video_width + xM4;
-                    i8 += *p++;
-                    i8 += *p++;
-                    i5 += *p++;
-                    i4 += *p++;
-                    i3 += *p++;
-                    i4 += *p++;
-                    i5 += *p++;
-                    i8 += *p++;
-                    i8 += *p++;
-                    p = psrc + (y - 1) * video_width + xM4;
-                    i8 += *p++;
-                    i7 += *p++;
-                    i4 += *p++;
-                    i2 += *p++;
-                    i1 += *p++;
-                    i2 += *p++;
-                    i4 += *p++;
-                    i8 += *p++;
-                    i8 += *p++;
-                    p = psrc + (y + 0) * video_width + xM4;
-                    i8 += *p++;
-                    i6 += *p++;
-                    i3 += *p++;
-                    i1 += *p++;
-                    i0 += *p++;
-                    i1 += *p++;
-                    i3 += *p++;
-                    i6 += *p++;
-                    i8 += *p++;
-                    p = psrc + (y + 1) * video_width + xM4;
-                    i8 += *p++;
-                    i7 += *p++;
-                    i4 += *p++;
-                    i2 += *p++;
-                    i1 += *p++;
-                    i2 += *p++;
-                    i4 += *p++;
-                    i8 += *p++;
-                    i8 += *p++;
-                    p = psrc + (y + 2) * video_width + xM4;
-                    i8 += *p++;
-                    i8 += *p++;
-                    i5 += *p++;
-                    i4 += *p++;
-                    i3 += *p++;
-                    i4 += *p++;
-                    i5 += *p++;
-                    i8 += *p++;
-                    i8 += *p++;
-                    p = psrc + (y + 3) * video_width + xM4;
-                    i8 += *p++;
-                    i8 += *p++;
-                    i8 += *p++;
-                    i7 += *p++;
-                    i6 += *p++;
-                    i7 += *p++;
-                    i8 += *p++;
-                    i8 += *p++;
-                    i8 += *p++;
-                    p = psrc + (y + 4) * video_width + xM4;
-                    i8 += *p++;
-                    i8 += *p++;
-                    i8 += *p++;
-                    i8 += *p++;
-                    i8 += *p++;
-                    i8 += *p++;
-                    i8 += *p++;
-                    i8 += *p++;
-                    i8 += *p++;
-                    average = (i0 + i1 + i2 + i3 + i4 + i5 + i6 + i7 + i8) / 85.0;
-                    fit     = P0 * (i0 - average) + P1 * (i1 - 4 * average) + P2 * (i2 - 4 * average) +
-                              P3 * (i3 - 4 * average) + P4 * (i4 - 8 * average) + P5 * (i5 - 4 * average) +
-                              P6 * (i6 - 4 * average) + P7 * (i7 - 8 * average) + P8 * (i8 - 48 * average);
-                    if (bestFit < fit)
-                    {
-                        bestFit = fit;
-                        ix      = x;
-                        iy      = y;
-                    }
-                }
+            return findCentroidThreshold(pdata, video_width, trackingBox);
 
-            if (bestFit > 50)
-            {
-                double sumX  = 0;
-                double sumY  = 0;
-                double total = 0;
-                for (int y = iy - 4; y <= iy + 4; y++)
-                {
-                    p = psrc + y * width + ix - 4;
-                    for (int x = ix - 4; x <= ix + 4; x++)
-                    {
-                        double w = *p++;
-                        sumX += x * w;
-                        sumY += y * w;
-                        total += w;
-                    }
-                }
-                if (total > 0)
-                {
-                    ret = (Vector(trackingBox.x(), trackingBox.y(), 0) + Vector(sumX / total, sumY / total, 0));
-                    return ret;
-                }
-            }
-
-            return Vector(-1, -1, -1);
-        }
-        break;
         // Alexander's Stepanenko smart threshold algorithm
         case SMART_THRESHOLD:
+            return findSmartThreshold(pdata, video_width, video_height, trackingBox);
+
+        default:
+            break;
+    }
+
+    T const *psrc = pdata + trackingBox.y() * video_width + trackingBox.x();
+    double threshold = 0;
+
+    // simple adaptive threshold
+    if (square_alg_idx == AUTO_THRESHOLD)
+    {
+        T const *pptr = psrc;
+        for (int j = 0; j < trackingBox.width(); ++j, pptr += video_width)
+            for (int i = 0; i < trackingBox.width(); ++i)
+                threshold += pptr[i];
+        threshold /= trackingBox.width() * trackingBox.width();
+    }
+
+    // no threshold subtracion otherwise
+    return Vector(trackingBox.x(), trackingBox.y(), 0) + thresholdCentroid(psrc, video_width, trackingBox.width(), threshold);
+}
+
+template <typename T>
+Vector cgmath::findCentroidThreshold(T const *pdata, int videoWidth, const QRect &trackingBox)
+{
+    int width  = trackingBox.width();
+    int height = trackingBox.width();
+    T const *psrc = pdata + trackingBox.y() * videoWidth + trackingBox.x();
+
+    int ix = 0, iy = 0;
+    const double bestFit = findKernelPeak(psrc, videoWidth, width, height, &ix, &iy, ExactKernelSums<T>());
+
+    if (bestFit > 50)
+    {
+        double sumX  = 0;
+        double sumY  = 0;
+        double total = 0;
+        for (int y = iy - 4; y <= iy + 4; y++)
         {
-            point_t bbox_lt = { trackingBox.x() - SMART_FRAME_WIDTH, trackingBox.y() - SMART_FRAME_WIDTH };
-            point_t bbox_rb = { trackingBox.x() + trackingBox.width() + SMART_FRAME_WIDTH,
-                                trackingBox.y() + trackingBox.width() + SMART_FRAME_WIDTH
-                              };
-            int offset      = 0;
-
-            // clip frame
-            if (bbox_lt.x < 0)
-                bbox_lt.x = 0;
-            if (bbox_lt.y < 0)
-                bbox_lt.y = 0;
-            if (bbox_rb.x > video_width)
-                bbox_rb.x = video_width;
-            if (bbox_rb.y > video_height)
-                bbox_rb.y = video_height;
-
-            // calc top bar
-            int box_wd  = bbox_rb.x - bbox_lt.x;
-            int box_ht  = trackingBox.y() - bbox_lt.y;
-            int pix_cnt = 0;
-            if (box_wd > 0 && box_ht > 0)
-            {
-                pix_cnt += box_wd * box_ht;
-                for (j = bbox_lt.y; j < trackingBox.y(); ++j)
-                {
-                    offset = j * video_width;
-                    for (i = bbox_lt.x; i < bbox_rb.x; ++i)
-                    {
-                        pptr = pdata + offset + i;
-                        threshold += *pptr;
-                    }
-                }
-            }
-            // calc left bar
-            box_wd = trackingBox.x() - bbox_lt.x;
-            box_ht = trackingBox.width();
-            if (box_wd > 0 && box_ht > 0)
-            {
-                pix_cnt += box_wd * box_ht;
-                for (j = trackingBox.y(); j < trackingBox.y() + box_ht; ++j)
-                {
-                    offset = j * video_width;
-                    for (i = bbox_lt.x; i < trackingBox.x(); ++i)
-                    {
-                        pptr = pdata + offset + i;
-                        threshold += *pptr;
-                    }
-                }
-            }
-            // calc right bar
-            box_wd = bbox_rb.x - trackingBox.x() - trackingBox.width();
-            box_ht = trackingBox.width();
-            if (box_wd > 0 && box_ht > 0)
+            T const *p = psrc + y * width + ix - 4;
+            for (int x = ix - 4; x <= ix + 4; x++)
             {
-                pix_cnt += box_wd * box_ht;
-                for (j = trackingBox.y(); j < trackingBox.y() + box_ht; ++j)
-                {
-                    offset = j * video_width;
-                    for (i = trackingBox.x() + trackingBox.width(); i < bbox_rb.x; ++i)
-                    {
-                        pptr = pdata + offset + i;
-                        threshold += *pptr;
-                    }
-                }
-            }
-            // calc bottom bar
-            box_wd = bbox_rb.x - bbox_lt.x;
-            box_ht = bbox_rb.y - trackingBox.y() - trackingBox.width();
-            if (box_wd > 0 && box_ht > 0)
-            {
-                pix_cnt += box_wd * box_ht;
-                for (j = trackingBox.y() + trackingBox.width(); j < bbox_rb.y; ++j)
-                {
-                    offset = j * video_width;
-                    for (i = bbox_lt.x; i < bbox_rb.x; ++i)
-                    {
-                        pptr = pdata + offset + i;
-                        threshold += *pptr;
-                    }
-                }
+                double w = *p++;
+                sumX += x * w;
+                sumY += y * w;
+                total += w;
             }
-            // find maximum
-            double max_val = 0;
-            for (j = 0; j < trackingBox.width(); ++j)
-            {
-                for (i = 0; i < trackingBox.width(); ++i)
-                {
-                    pptr = psrc + i;
-                    if (*pptr > max_val)
-                        max_val = *pptr;
-                }
-                psrc += video_width;
-            }
-            if (pix_cnt != 0)
-                threshold /= (double)pix_cnt;
+        }
+        if (total > 0)
+            return (Vector(trackingBox.x(), trackingBox.y(), 0) + Vector(sumX / total, sumY / total, 0));
+    }
 
-            // cut by 10% higher then average threshold
-            if (max_val > threshold)
-                threshold += (max_val - threshold) * SMART_CUT_FACTOR;
+    return Vector(-1, -1, -1);
+}
 
-            //log_i("smart thr. = %f cnt = %d", threshold, pix_cnt);
-            break;
+template <typename T>
+Vector cgmath::findSmartThreshold(T const *pdata, int videoWidth, int videoHeight, const QRect &trackingBox)
+{
+    int i, j;
+    double threshold = 0;
+    FrameSum<T> frameSum = 0;
+    T const *pptr;
+    T const *psrc = pdata + trackingBox.y() * videoWidth + trackingBox.x();
+
+    point_t bbox_lt = { trackingBox.x() - SMART_FRAME_WIDTH, trackingBox.y() - SMART_FRAME_WIDTH };
+    point_t bbox_rb = { trackingBox.x() + trackingBox.width() + SMART_FRAME_WIDTH,
+                        trackingBox.y() + trackingBox.width() + SMART_FRAME_WIDTH
+                      };
+    int offset      = 0;
+
+    // clip frame
+    if (bbox_lt.x < 0)
+        bbox_lt.x = 0;
+    if (bbox_lt.y < 0)
+        bbox_lt.y = 0;
+    if (bbox_rb.x > videoWidth)
+        bbox_rb.x = videoWidth;
+    if (bbox_rb.y > videoHeight)
+        bbox_rb.y = videoHeight;
+
+    // calc top bar
+    int box_wd  = bbox_rb.x - bbox_lt.x;
+    int box_ht  = trackingBox.y() - bbox_lt.y;
+    int pix_cnt = 0;
+    if (box_wd > 0 && box_ht > 0)
+    {
+        pix_cnt += box_wd * box_ht;
+        for (j = bbox_lt.y; j < trackingBox.y(); ++j)
+        {
+            offset = j * videoWidth;
+            for (i = bbox_lt.x; i < bbox_rb.x; ++i)
+            {
+                pptr = pdata + offset + i;
+                frameSum += *pptr;
+            }
         }
-        // simple adaptive threshold
-        case AUTO_THRESHOLD:
+    }
+    // calc left bar
+    box_wd = trackingBox.x() - bbox_lt.x;
+    box_ht = trackingBox.width();
+    if (box_wd > 0 && box_ht > 0)
+    {
+        pix_cnt += box_wd * box_ht;
+        for (j = trackingBox.y(); j < trackingBox.y() + box_ht; ++j)
         {
-            for (j = 0; j < trackingBox.width(); ++j)
+            offset = j * videoWidth;
+            for (i = bbox_lt.x; i < trackingBox.x(); ++i)
             {
-                for (i = 0; i < trackingBox.width(); ++i)
-                {
-                    pptr = psrc + i;
-                    threshold += *pptr;
-                }
-                psrc += video_width;
+                pptr = pdata + offset + i;
+                frameSum += *pptr;
             }
-            threshold /= square_square;
-            break;
         }
-        // no threshold subtracion
-        default:
+    }
+    // calc right bar
+    box_wd = bbox_rb.x - trackingBox.x() - trackingBox.width();
+    box_ht = trackingBox.width();
+    if (box_wd > 0 && box_ht > 0)
+    {
+        pix_cnt += box_wd * box_ht;
+        for (j = trackingBox.y(); j < trackingBox.y() + box_ht; ++j)
         {
+            offset = j * videoWidth;
+            for (i = trackingBox.x() + trackingBox.width(); i < bbox_rb.x; ++i)
+            {
+                pptr = pdata + offset + i;
+                frameSum += *pptr;
+            }
         }
     }
-
-    psrc = porigin;
-    for (j = 0; j < trackingBox.width(); ++j)
+    // calc bottom bar
+    box_wd = bbox_rb.x - bbox_lt.x;
+    box_ht = bbox_rb.y - trackingBox.y() - trackingBox.width();
+    if (box_wd > 0 && box_ht > 0)
     {
-        for (i = 0; i < trackingBox.width(); ++i)
+        pix_cnt += box_wd * box_ht;
+        for (j = trackingBox.y() + trackingBox.width(); j < bbox_rb.y; ++j)
         {
-            pptr = psrc + i;
-            pval = *pptr - threshold;
-            pval = pval < 0 ? 0 : pval;
-
-            resx += (double)i * pval;
-            resy += (double)j * pval;
-
-            mass += pval;
+            offset = j * videoWidth;
+            for (i = bbox_lt.x; i < bbox_rb.x; ++i)
+            {
+                pptr = pdata + offset + i;
+                frameSum += *pptr;
+            }
         }
-        psrc += video_width;
     }
+    // find maximum, of the box and of each of its rows
+    std::vector<T> rowMax(trackingBox.width());
+    T boxMax = std::numeric_limits<T>::lowest();
+    pptr = psrc;
+    for (j = 0; j < trackingBox.width(); ++j, pptr += videoWidth)
+    {
+        rowMax[j] = rowMaximum(pptr, trackingBox.width());
+        boxMax = std::max(boxMax, rowMax[j]);
+    }
+    double max_val = std::max(0.0, static_cast<double>(boxMax));
+    threshold = frameSum;
+    if (pix_cnt != 0)
+        threshold /= (double)pix_cnt;
 
-    if (mass == 0)
-        mass = 1;
-
-    resx /= mass;
-    resy /= mass;
+    // cut by 10% higher then average threshold
+    if (max_val > threshold)
+        threshold += (max_val - threshold) * SMART_CUT_FACTOR;
 
-    ret = Vector(trackingBox.x(), trackingBox.y(), 0) + Vector(resx, resy, 0);
+    //log_i("smart thr. = %f cnt = %d", threshold, pix_cnt);
 
-    return ret;
+    // Only the rows of the star are above threshold
+    return Vector(trackingBox.x(), trackingBox.y(), 0) +
+           thresholdCentroid(psrc, videoWidth, trackingBox.width(), threshold, rowMax.data());
 }
 
+// The star finders are also used by the tests for each pixel type
+#define INSTANTIATE_STAR_FINDERS(T) \
+    template Vector cgmath::findCentroidThreshold<T>(T const *, int, const QRect &); \
+    template Vector cgmath::findSmartThreshold<T>(T const *, int, int, const QRect &);
+INSTANTIATE_STAR_FINDERS(uint8_t)
+INSTANTIATE_STAR_FINDERS(int16_t)
+INSTANTIATE_STAR_FINDERS(uint16_t)
+INSTANTIATE_STAR_FINDERS(int32_t)
+INSTANTIATE_STAR_FINDERS(uint32_t)
+INSTANTIATE_STAR_FINDERS(float)
+INSTANTIATE_STAR_FINDERS(int64_t)
+INSTANTIATE_STAR_FINDERS(double)
+#undef INSTANTIATE_STAR_FINDERS
+
 void cgmath::process_axes(void)
 {
     int cnt        = 0;
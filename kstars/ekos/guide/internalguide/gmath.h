@@ -17,6 +17,7 @@
 
 #include <QObject>
 #include <QPointer>
+#include <QRect>
 #include <QTime>
 #include <QVector>
 #include <QFile>
@@ -187,6 +188,28 @@ class cgmath : public QObject
         QVector3D selectGuideStar();
         double getGuideStarSNR();
 
+        /**
+         * @brief findCentroidThreshold Locate the star in a tracking box with the "Fast" 9x9 kernel.
+         * @param pdata First plane of the image.
+         * @param videoWidth Width of the image. The kernel also reads 4 pixels around the tracking box.
+         * @param trackingBox Square tracking box.
+         * @return Position of the star in the image, or (-1, -1, -1) if none is found.
+         */
+        template <typename T>
+        static Vector findCentroidThreshold(T const *pdata, int videoWidth, const QRect &trackingBox);
+
+        /**
+         * @brief findSmartThreshold Locate the star in a tracking box with the "Smart" threshold, which is set from the
+         * background around the box and the brightest pixel in it.
+         * @param pdata First plane of the image.
+         * @param videoWidth Width of the image.
+         * @param videoHeight Height of the image.
+         * @param trackingBox Square tracking box.
+         * @return Centroid of the pixels of the box above threshold, in the image.
+         */
+        template <typename T>
+        static Vector findSmartThreshold(T const *pdata, int videoWidth, int videoHeight, const QRect &trackingBox);
+
     signals:
         void newAxisDelta(double delta_ra, double delta_dec);
         void newStarPosition(QVector3D, bool);
@@ -486,10 +486,9 @@ void GuideStars::findTopStars(const QSharedPointer<FITSData> &imageData, int num
 void GuideStars::evaluateSEPStars(const QList<Edge *> &starCenters, QVector<double> *scores,
                                   const QRect *roi, const double maxHFR) const
 {
-    auto centers = starCenters;
     scores->clear();
-    for (int i = 0; i < centers.size(); ++i) scores->push_back(0);
-    if (centers.empty()) return;
+    for (int i = 0; i < starCenters.size(); ++i) scores->push_back(0);
+    if (starCenters.empty()) return;
 
     // Rough constants used by this weighting.
     // If the center pixel is above this, assume it's clipped and don't emphasize.
@@ -498,26 +497,26 @@ void GuideStars::evaluateSEPStars(const QList<Edge *> &starCenters, QVector<doub
 
     // Sort by SNR in increasing order so the weighting goes up.
     // Assign score based on the sorted position.
-    std::sort(centers.begin(), centers.end(), [&bg](const Edge * a, const Edge * b)
+    // The indexes of the stars are sorted, rather than the stars, to find their scores directly.
+    QVector<double> snrs(starCenters.size());
+    QVector<int> order(starCenters.size());
+    for (int j = 0; j < starCenters.size(); ++j)
     {
-        double snrA = bg.SNR(a->sum, a->numPixels);
-        double snrB = bg.SNR(b->sum, b->numPixels);
-        return snrA < snrB;
+        snrs[j] = bg.SNR(starCenters.at(j)->sum, starCenters.at(j)->numPixels);
+        order[j] = j;
+    }
+    std::sort(order.begin(), order.end(), [&snrs](int a, int b)
+    {
+        return snrs[a] < snrs[b];
     });
-    for (int i = 0; i < centers.size(); ++i)
+    for (int i = 0; i < order.size(); ++i)
     {
-        for (int j = 0; j < starCenters.size(); ++j)
-        {
-            if (starCenters.at(j) == centers.at(i))
-            {
-                // Don't emphasize stars that are too wide.
-                if (centers.at(i)->HFR > maxHFR)
-                    (*scores)[j] = -1;
-                else
-                    (*scores)[j] += snrWeight * i;
-                break;
-            }
-        }
+        const int j = order[i];
+        // Don't emphasize stars that are too wide.
+        if (starCenters.at(j)->HFR > maxHFR)
+            (*scores)[j] = -1;
+        else
+            (*scores)[j] += snrWeight * i;
     }
 
     // If we are insisting on a star in the tracking box.
@@ -599,20 +598,27 @@ bool GuideStars::getDrift(double oneStarDrift, double reticle_x, double reticle_
     QVector<double> raDrifts, decDrifts;
     qCDebug(KSTARS_EKOS_GUIDE)
             << QString("%1 %2  dRA   dDEC").arg(logHeader("")).arg(logHeader("    Ref:"));
+    const auto &bg = skybackground();
+    const int guideStarReference = starCorrespondence.guideStar();
+    raDrifts.reserve(detectedStars.size());
+    decDrifts.reserve(detectedStars.size());
     for (int i = 0; i < detectedStars.size(); ++i)
     {
+        // Stars that match no reference are skipped before any other work.
+        const int refIndex = getStarMap(i);
+        if (refIndex < 0)
+            continue;
         const auto &star = detectedStars[i];
-        auto bg = skybackground();
-        double snr = bg.SNR(detectedStars[i].sum, detectedStars[i].numPixels);
+        double snr = bg.SNR(star.sum, star.numPixels);
         // Probably should test SNR on the reference as well.
-        if (getStarMap(i) >= 0 && snr >= MIN_DRIFT_SNR)
+        if (snr >= MIN_DRIFT_SNR)
         {
-            auto ref = starCorrespondence.reference(getStarMap(i));
+            auto ref = starCorrespondence.reference(refIndex);
             ref.x += offset_x;
             ref.y += offset_y;
             double driftRA, driftDEC;
             computeStarDrift(star, ref, &driftRA, &driftDEC);
-            if (getStarMap(i) == starCorrespondence.guideStar())
+            if (refIndex == guideStarReference)
             {
                 guideStarRADrift = driftRA;
                 guideStarDECDrift = driftDEC;
@@ -625,7 +631,7 @@ bool GuideStars::getDrift(double oneStarDrift, double reticle_x, double reticle_
 
             qCDebug(KSTARS_EKOS_GUIDE)
                     << QString("%1 %2 %3 %4").arg(logStar("MultiStar", i, bg, star))
-                    .arg(logStar("    Ref:", getStarMap(i), bg, ref))
+                    .arg(logStar("    Ref:", refIndex, bg, ref))
                     .arg(driftRA, 5, 'f', 2).arg(driftDEC, 5, 'f', 2);
         }
     }
@@ -10,56 +10,131 @@
 #include "starcorrespondence.h"
 
 #include <math.h>
+#include <algorithm>
 #include "ekos_guide_debug.h"
 
-// Finds the star in sortedStars that's closest to x,y and within maxDistance pixels.
-// Returns the index of the closest star in  sortedStars, or -1 if none satisfies the criteria.
-// sortedStars must be sorted by x, from lower x to higher x.
+// Fills grid with the positions of stars, using cells large enough that any star within
+// maxDistance of a position lies in the cell of that position or in one of its 8 neighbors.
+void StarCorrespondence::makeGrid(const QList<Edge> &stars, double maxDistance, StarGrid *grid) const
+{
+    const int size = stars.size();
+    grid->columns = grid->rows = 0;
+    grid->cellStart.clear();
+    grid->starIndexes.clear();
+    if (size == 0)
+        return;
+
+    double minX = stars[0].x, maxX = minX, minY = stars[0].y, maxY = minY;
+    for (const auto &star : stars)
+    {
+        minX = std::min(minX, static_cast<double>(star.x));
+        maxX = std::max(maxX, static_cast<double>(star.x));
+        minY = std::min(minY, static_cast<double>(star.y));
+        maxY = std::max(maxY, static_cast<double>(star.y));
+    }
+
+    // Cells are a pixel wider than maxDistance to be safe from rounding at cell borders, and are
+    // enlarged for sparse fields so that there are about as many cells as stars.
+    const double area = (maxX - minX + 1) * (maxY - minY + 1);
+    grid->cellSize = std::max(maxDistance + 1, sqrt(area / size));
+    grid->x0 = minX;
+    grid->y0 = minY;
+    grid->columns = static_cast<int>((maxX - minX) / grid->cellSize) + 1;
+    grid->rows = static_cast<int>((maxY - minY) / grid->cellSize) + 1;
+
+    // Counting sort of the star indexes by cell. Within a cell, indexes stay in increasing order.
+    QVector<int> starCells(size);
+    grid->cellStart.fill(0, grid->columns * grid->rows + 1);
+    for (int i = 0; i < size; ++i)
+    {
+        const int column = static_cast<int>((stars[i].x - grid->x0) / grid->cellSize);
+        const int row = static_cast<int>((stars[i].y - grid->y0) / grid->cellSize);
+        starCells[i] = row * grid->columns + column;
+        grid->cellStart[starCells[i] + 1]++;
+    }
+    for (int c = 0; c < grid->columns * grid->rows; ++c)
+        grid->cellStart[c + 1] += grid->cellStart[c];
+    grid->starIndexes.resize(size);
+    QVector<int> next = grid->cellStart;
+    for (int i = 0; i < size; ++i)
+        grid->starIndexes[next[starCells[i]]++] = i;
+}
+
+// Finds the star in stars that's closest to x,y and within maxDistance pixels.
+// Returns the index of the closest star in stars, or -1 if none satisfies the criteria.
+// When several stars are at the same distance, the one with the highest index is returned.
 // Fills distance to the pixel distance to the closest star.
-int StarCorrespondence::findClosestStar(double x, double y, const QList<Edge> sortedStars,
+int StarCorrespondence::findClosestStar(double x, double y, const QList<Edge> &stars, const StarGrid &grid,
                                         double maxDistance, double *distance) const
 {
     if (x < -maxDistance || y < -maxDistance ||
             x > imageWidth + maxDistance || y > imageWidth + maxDistance)
         return -1;
 
-    const int size = sortedStars.size();
-    int startPoint = 0;
+    // Only the cells next to the one containing x,y can hold stars within maxDistance.
+    const double column = floor((x - grid.x0) / grid.cellSize);
+    const double row = floor((y - grid.y0) / grid.cellSize);
+    const int firstColumn = static_cast<int>(std::max(column - 1, 0.0));
+    const int lastColumn = static_cast<int>(std::min(column + 1, grid.columns - 1.0));
+    const int firstRow = static_cast<int>(std::max(row - 1, 0.0));
+    const int lastRow = static_cast<int>(std::min(row + 1, grid.rows - 1.0));
 
-    // Efficiency improvement to quickly find the start point.
-    // Increments by size/10 to find a better start point.
-    const int coarseIncrement = size / 10;
-    if (coarseIncrement > 1)
+    int bestIndex = -1;
+    double bestSquaredDistance = maxDistance * maxDistance;
+    for (int r = firstRow; r <= lastRow; ++r)
     {
-        for (int i = 0; i < size; i += coarseIncrement)
+        for (int c = firstColumn; c <= lastColumn; ++c)
         {
-            if (sortedStars[i].x < x - maxDistance)
-                startPoint = i;
-            else
-                break;
+            const int cell = r * grid.columns + c;
+            for (int k = grid.cellStart[cell]; k < grid.cellStart[cell + 1]; ++k)
+            {
+                const int i = grid.starIndexes[k];
+                const auto &star = stars[i];
+                const double xDiff = star.x - x;
+                const double yDiff = star.y - y;
+                const double squaredDistance = xDiff * xDiff + yDiff * yDiff;
+                if (squaredDistance < bestSquaredDistance ||
+                        (squaredDistance == bestSquaredDistance && i > bestIndex))
+                {
+                    bestIndex = i;
+                    bestSquaredDistance = squaredDistance;
+                }
+            }
         }
     }
+    if (distance != nullptr) *distance = sqrt(bestSquaredDistance);
+    return bestIndex;
+}
 
-    // Iterate through the stars starting with the star with lowest x where x >= x - maxDistance
-    // through the star with greatest x where x <= x + maxDistance.  Find the closest star to x,y.
-    int bestIndex = -1;
-    double bestSquaredDistance = maxDistance * maxDistance;
-    for (int i = startPoint; i < size; ++i)
+// Fills nearStars with the indexes of the stars within radius of x,y, in increasing order.
+void StarCorrespondence::findStarsNear(double x, double y, double radius, const QList<Edge> &stars,
+                                       const StarGrid &grid, QVector<int> *nearStars) const
+{
+    nearStars->clear();
+    if (grid.columns == 0)
+        return;
+
+    const double firstColumn = std::max(floor((x - radius - grid.x0) / grid.cellSize), 0.0);
+    const double lastColumn = std::min(floor((x + radius - grid.x0) / grid.cellSize), grid.columns - 1.0);
+    const double firstRow = std::max(floor((y - radius - grid.y0) / grid.cellSize), 0.0);
+    const double lastRow = std::min(floor((y + radius - grid.y0) / grid.cellSize), grid.rows - 1.0);
+
+    for (int r = static_cast<int>(firstRow); r <= lastRow; ++r)
     {
-        auto &star = sortedStars[i];
-        if (star.x < x - maxDistance) continue;
-        if (star.x > x + maxDistance) break;
-        const double xDiff = star.x - x;
-        const double yDiff = star.y - y;
-        const double squaredDistance = xDiff * xDiff + yDiff * yDiff;
-        if (squaredDistance <= bestSquaredDistance)
+        for (int c = static_cast<int>(firstColumn); c <= lastColumn; ++c)
         {
-            bestIndex = i;
-            bestSquaredDistance = squaredDistance;
+            const int cell = r * grid.columns + c;
+            for (int k = grid.cellStart[cell]; k < grid.cellStart[cell + 1]; ++k)
+            {
+                const int i = grid.starIndexes[k];
+                const double xDiff = stars[i].x - x;
+                const double yDiff = stars[i].y - y;
+                if (xDiff * xDiff + yDiff * yDiff <= radius * radius)
+                    nearStars->push_back(i);
+            }
         }
     }
-    if (distance != nullptr) *distance = sqrt(bestSquaredDistance);
-    return bestIndex;
+    std::sort(nearStars->begin(), nearStars->end());
 }
 
 namespace
@@ -107,6 +182,8 @@ void StarCorrespondence::initialize(const QList<Edge> &stars, int guideStar)
     guideStarIndex = guideStar;
     float guideX = references[guideStarIndex].x;
     float guideY = references[guideStarIndex].y;
+    expectedGuideStarX = guideX;
+    expectedGuideStarY = guideY;
     guideStarOffsets.clear();
 
     // Compute the x and y offsets from the guide star to all reference stars
@@ -130,8 +207,9 @@ void StarCorrespondence::reset()
     initialized = false;
 }
 
-int StarCorrespondence::findInternal(const QList<Edge> &stars, double maxDistance, QVector<int> *starMap,
-                                     int guideStarIndex, const QVector<Offsets> &offsets,
+int StarCorrespondence::findInternal(const QList<Edge> &stars, const StarGrid &grid, double maxDistance,
+                                     QVector<int> *starMap, int guideStarIndex, const QVector<Offsets> &offsets,
+                                     double expectedX, double expectedY,
                                      int *numFound, int *numNotFound, double minFraction) const
 {
     // This is the cost of not finding one of the reference stars.
@@ -154,17 +232,21 @@ int StarCorrespondence::findInternal(const QList<Edge> &stars, double maxDistanc
     if (stars.size() < minFraction * offsets.size())
         return -1;
 
-    // Assume the guide star corresponds to each of the stars.
+    // Assume the guide star corresponds to each of the candidate stars.
     // Score the assignment, pick the best, and then assign the rest.
-    const int numStars = stars.size();
+    // The (star index, reference index) pairs of an assignment are kept instead of a map over
+    // all the stars, so that scoring a candidate doesn't cost in proportion to the number of stars.
     int bestStarIndex = -1, bestNumFound = 0, bestNumNotFound = 0;
-    for (int starIndex = 0; starIndex < numStars; ++starIndex)
+    QVector<std::pair<int, int>> mapping, bestMapping;
+    mapping.reserve(offsets.size());
+    bestMapping.reserve(offsets.size());
+    auto scoreCandidate = [&](int starIndex)
     {
         const float starX = stars[starIndex].x;
         const float starY = stars[starIndex].y;
 
         double cost = 0.0;
-        QVector<int> mapping(stars.size(), -1);
+        mapping.clear();
         int numFound = 0, numNotFound = 0;
         for (int offsetIndex = 0; offsetIndex < offsets.size(); ++offsetIndex)
         {
@@ -179,7 +261,7 @@ int StarCorrespondence::findInternal(const QList<Edge> &stars, double maxDistanc
             const auto &offset = offsets[offsetIndex];
             double distance;
             const int closestIndex = findClosestStar(starX + offset.x, starY + offset.y,
-                                     stars, maxDistance, &distance);
+                                     stars, grid, maxDistance, &distance);
             if (closestIndex < 0)
             {
                 // This reference star position had no corresponding input star.
@@ -191,7 +273,7 @@ int StarCorrespondence::findInternal(const QList<Edge> &stars, double maxDistanc
 
             // If starIndex is the star that corresponds to guideStarIndex, then
             // stars[index] corresponds to references[offsetIndex]
-            mapping[closestIndex] = offsetIndex;
+            mapping.push_back(std::make_pair(closestIndex, offsetIndex));
             cost += distance * distanceWeight;
         }
         if (cost < bestCost)
@@ -200,12 +282,28 @@ int StarCorrespondence::findInternal(const QList<Edge> &stars, double maxDistanc
             bestStarIndex = starIndex;
             bestNumFound = numFound;
             bestNumNotFound = numNotFound;
-
-            *starMap = QVector<int>(stars.size(), -1);
-            for (int i = 0; i < mapping.size(); ++i)
-                (*starMap)[i] = mapping[i];
-            (*starMap)[starIndex] = guideStarIndex;
+            std::swap(mapping, bestMapping);
         }
+    };
+
+    // The guide star moves little between frames, so the stars around its expected position are
+    // tried first. Only if none of them fits, e.g. after a large jump, are all the stars tried.
+    const double searchRadius = 4 * maxDistance;
+    QVector<int> nearStars;
+    findStarsNear(expectedX, expectedY, searchRadius, stars, grid, &nearStars);
+    for (int starIndex : nearStars)
+        scoreCandidate(starIndex);
+    if (bestStarIndex < 0)
+    {
+        const int numStars = stars.size();
+        for (int starIndex = 0; starIndex < numStars; ++starIndex)
+            scoreCandidate(starIndex);
+    }
+    if (bestStarIndex >= 0)
+    {
+        for (const auto &match : bestMapping)
+            (*starMap)[match.first] = match.second;
+        (*starMap)[bestStarIndex] = guideStarIndex;
     }
     *numFound = bestNumFound;
     *numNotFound = bestNumNotFound;
@@ -297,15 +395,19 @@ Vector StarCorrespondence::find(const QList<Edge> &stars, double maxDistance,
     if (!initialized)  return Vector(-1, -1, -1);
     int numFound, numNotFound;
 
-    // findClosestStar needs an input with stars sorted by their x.
-    // Do this outside of the loops.
+    // Candidate guide stars are tried in order of increasing x.
+    // Sort and index the stars outside of the loops.
     QList<Edge> sortedStars;
     QVector<int> sortedToOriginal;
     sortByX(stars, &sortedStars, &sortedToOriginal);
 
+    StarGrid grid;
+    makeGrid(sortedStars, maxDistance, &grid);
+
     QVector<int> sortedStarMap;
-    int bestStarIndex = findInternal(sortedStars, maxDistance, &sortedStarMap, guideStarIndex,
-                                     guideStarOffsets, &numFound, &numNotFound, minFraction);
+    int bestStarIndex = findInternal(sortedStars, grid, maxDistance, &sortedStarMap, guideStarIndex,
+                                     guideStarOffsets, expectedGuideStarX, expectedGuideStarY,
+                                     &numFound, &numNotFound, minFraction);
 
     Vector starPosition(-1, -1, -1);
     if (bestStarIndex > -1)
@@ -315,6 +417,8 @@ Vector StarCorrespondence::find(const QList<Edge> &stars, double maxDistance,
         unmapStarMap(sortedStarMap, sortedToOriginal, starMap);
 
         starPosition = Vector(stars[bestStarIndex].x, stars[bestStarIndex].y, -1);
+        expectedGuideStarX = starPosition.x;
+        expectedGuideStarY = starPosition.y;
         qCDebug(KSTARS_EKOS_GUIDE)
                 << " StarCorrespondence found guideStar at " << bestStarIndex << "found/not"
                 << numFound << numNotFound;
@@ -334,8 +438,10 @@ Vector StarCorrespondence::find(const QList<Edge> &stars, double maxDistance,
             QVector<Offsets> gStarOffsets;
             makeOffsets(guideStarOffsets, &gStarOffsets, gStarIndex);
             QVector<int> newStarMap;
-            int detectedStarIndex = findInternal(sortedStars, maxDistance, &newStarMap,
+            int detectedStarIndex = findInternal(sortedStars, grid, maxDistance, &newStarMap,
                                                  gStarIndex, gStarOffsets,
+                                                 expectedGuideStarX + guideStarOffsets[gStarIndex].x,
+                                                 expectedGuideStarY + guideStarOffsets[gStarIndex].y,
                                                  &numFound, &numNotFound, minFraction);
             if (detectedStarIndex >= 0 && numFound > bestNumFound)
             {
@@ -358,6 +464,8 @@ Vector StarCorrespondence::find(const QList<Edge> &stars, double maxDistance,
         {
             // Convert back to the unsorted index value.
             unmapStarMap(sortedStarMap, sortedToOriginal, starMap);
+            expectedGuideStarX = bestPosition.x;
+            expectedGuideStarY = bestPosition.y;
             qCDebug(KSTARS_EKOS_GUIDE)
                     << "StarCorrespondence found guideStar (invented) at "
                     << bestPosition.x << bestPosition.y << "found/not" << bestNumFound << bestNumNotFound;
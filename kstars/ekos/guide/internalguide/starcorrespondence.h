@@ -109,11 +109,32 @@ class StarCorrespondence
         void initializeAdaptation();
         void adaptOffsets(const QList<Edge> &stars, const QVector<int> &starMap);
 
+        // Buckets the input stars of one find() call into square cells at least maxDistance wide,
+        // so that the stars within maxDistance of a position are all in the 3x3 cells around it.
+        struct StarGrid
+        {
+            double x0 { 0 };
+            double y0 { 0 };
+            double cellSize { 1 };
+            int columns { 0 };
+            int rows { 0 };
+            // The star indexes of cell c are starIndexes[cellStart[c]] to starIndexes[cellStart[c+1]-1].
+            QVector<int> cellStart;
+            QVector<int> starIndexes;
+        };
+        void makeGrid(const QList<Edge> &stars, double maxDistance, StarGrid *grid) const;
+
         // Utility used by find. Useful for iterating when the guide star is missing.
-        int findInternal(const QList<Edge> &stars, double maxDistance, QVector<int> *starMap,
-                         int guideStarIndex, const QVector<Offsets> &offsets,
+        // The stars near expectedX,expectedY are tried first as the guide star, then all the stars if none fits.
+        int findInternal(const QList<Edge> &stars, const StarGrid &grid, double maxDistance, QVector<int> *starMap,
+                         int guideStarIndex, const QVector<Offsets> &offsets, double expectedX, double expectedY,
                          int *numFound, int *numNotFound, double minFraction) const;
 
+        // Fills nearStars with the indexes, in increasing order, of the stars within radius of x,y.
+        // grid must have been made from stars by makeGrid().
+        void findStarsNear(double x, double y, double radius, const QList<Edge> &stars, const StarGrid &grid,
+                           QVector<int> *nearStars) const;
+
         // Used to when guide star is missing. Creates offsets as if other stars were the guide star.
         void makeOffsets(const QVector<Offsets> &offsets, QVector<Offsets> *targetOffsets, int targetStar) const;
 
@@ -126,9 +147,9 @@ class StarCorrespondence
         Vector inventStarPosition(const QList<Edge> &stars, QVector<int> &starMap,
                                   QVector<Offsets> offsets, Offsets offset) const;
 
-        // Finds the star closest to x,y. Returns the index in sortedStars.
-        // sortedStars should be sorted in x, which allows for a speedup in search.
-        int findClosestStar(double x, double y, const QList<Edge> sortedStars,
+        // Finds the star closest to x,y. Returns the index in stars.
+        // grid must have been made from stars by makeGrid() with the same maxDistance.
+        int findClosestStar(double x, double y, const QList<Edge> &stars, const StarGrid &grid,
                             double maxDistance, double *distance) const;
 
         // The offsets of the reference stars relative to the guide star.
@@ -141,6 +162,11 @@ class StarCorrespondence
         // If this is true, it will attempt star correspondence even if the guide star is missing.
         bool allowMissingGuideStar { false };
 
+        // Where the guide star is expected in the next input stars: where it was last found,
+        // or its reference position until then.
+        double expectedGuideStarX { 0 };
+        double expectedGuideStarY { 0 };
+
         // IIR filter parameter used to adapt offsets.
         double alpha;
 
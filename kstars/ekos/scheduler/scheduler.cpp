@@ -25,6 +25,7 @@
 #include "auxiliary/QProgressIndicator.h"
 #include "dialogs/finddialog.h"
 #include "ekos/manager.h"
+#include "ekos/capture/capturefileindex.h"
 #include "ekos/capture/sequencejob.h"
 #include "ekos/capture/placeholderpath.h"
 #include "skyobjects/starobject.h"
@@ -6526,26 +6527,16 @@ SequenceJob * Scheduler::processJobInfo(XMLEle *root, SchedulerJob *schedJob)
 
 int Scheduler::getCompletedFiles(const QString &path, const QString &seqPrefix)
 {
-    int seqFileCount = 0;
     QFileInfo const path_info(path);
     QString const sig_dir(path_info.dir().path());
     QString const sig_file(path_info.completeBaseName());
 
     qCDebug(KSTARS_EKOS_SCHEDULER) << QString("Searching in path '%1', files '%2*' for prefix '%3'...").arg(sig_dir, sig_file,
                                    seqPrefix);
-    QDirIterator it(sig_dir, QDir::Files);
 
     /* FIXME: this counts all files with prefix in the storage location, not just captures. DSS analysis files are counted in, for instance. */
-    while (it.hasNext())
-    {
-        QString const fileName = QFileInfo(it.next()).completeBaseName();
-
-        if (fileName.startsWith(seqPrefix))
-        {
-            qCDebug(KSTARS_EKOS_SCHEDULER) << QString("> Found '%1'").arg(fileName);
-            seqFileCount++;
-        }
-    }
+    int const seqFileCount = CaptureFileIndex::Instance()->count(sig_dir, seqPrefix);
+    qCDebug(KSTARS_EKOS_SCHEDULER) << QString("> Found %1 files").arg(seqFileCount);
 
     return seqFileCount;
 }
@@ -15,16 +15,160 @@
 #include "Options.h"
 #include "scheduler.h"
 #include "ksalmanac.h"
+#include "ksnumbers.h"
 
 #include <knotification.h>
 
+#include <QHash>
+#include <QPair>
+#include <QMutex>
 #include <QTableWidgetItem>
 
+#include <memory>
+
 #include <ekos_scheduler_debug.h>
 
 #define BAD_SCORE -1000
 #define MIN_ALTITUDE 15.0
 
+namespace
+{
+/**
+ * @brief Ephemeris shared by the scoring functions of all jobs, for the night and location being scheduled.
+ *
+ * Precession, nutation and aberration numbers are evaluated at the closest whole hour of the requested date/time.
+ * Within half an hour these terms drift by less than 0.05 arcsecond, so target altitudes and separations stay
+ * within 1e-5 degree of a per-call evaluation. Local sidereal time is never cached.
+ * Moon positions and dawn/dusk almanacs are computed at the exact requested date/time and memoized, so their
+ * contribution to scores is unchanged. Moon positions are memoized per Moon object.
+ * The cache is dropped when the location changes, and each table is bounded to a few nights of entries.
+ */
+class EphemerisCache
+{
+    public:
+        struct MoonState
+        {
+            SkyPoint position;
+            double altitude { 0 };
+            double illumination { 0 };
+        };
+
+        struct Twilight
+        {
+            KStarsDateTime date;
+            double dawn { 0 };
+            double dusk { 0 };
+        };
+
+        static EphemerisCache &instance()
+        {
+            static EphemerisCache cache;
+            return cache;
+        }
+
+        std::shared_ptr<KSNumbers const> numbers(GeoLocation const *geo, long double jd)
+        {
+            QMutexLocker locker(&mutex);
+            checkLocation(geo);
+
+            qint64 const hour = llroundl(jd * 24.0L);
+            auto it = numbersCache.constFind(hour);
+            if (it != numbersCache.constEnd())
+                return it.value();
+
+            if (MAX_HOURS <= numbersCache.size())
+                numbersCache.clear();
+            auto result = std::make_shared<KSNumbers const>(static_cast<long double>(hour) / 24.0L);
+            numbersCache.insert(hour, result);
+            return result;
+        }
+
+        MoonState moon(GeoLocation const *geo, KSMoon *moon, KStarsDateTime const &ltWhen)
+        {
+            QMutexLocker locker(&mutex);
+            checkLocation(geo);
+
+            // Jobs may use different Moon objects, whose positions are not interchangeable
+            MoonKey const key(moon, llroundl(ltWhen.djd() * 86400.0L));
+            auto it = moonCache.constFind(key);
+            if (it != moonCache.constEnd())
+                return it.value();
+
+            // Update moon
+            //ut = getGeo()->LTtoUT(ltWhen);
+            //KSNumbers ksnum(ut.djd()); // BUG: possibly LT.djd() != UT.djd() because of translation
+            //LST = getGeo()->GSTtoLST(ut.gst());
+            KSNumbers numbers(ltWhen.djd());
+            CachingDms LST = geo->GSTtoLST(geo->LTtoUT(ltWhen).gst());
+            moon->updateCoords(&numbers, true, geo->lat(), &LST, true);
+
+            MoonState state;
+            state.position = SkyPoint(moon->ra(), moon->dec());
+            state.altitude = moon->alt().Degrees();
+            state.illumination = moon->illum();
+
+            if (MAX_SECONDS <= moonCache.size())
+                moonCache.clear();
+            moonCache.insert(key, state);
+            return state;
+        }
+
+        Twilight twilight(GeoLocation const *geo, KStarsDateTime const &midnight)
+        {
+            QMutexLocker locker(&mutex);
+            checkLocation(geo);
+
+            qint64 const second = llroundl(midnight.djd() * 86400.0L);
+            auto it = twilightCache.constFind(second);
+            if (it != twilightCache.constEnd())
+                return it.value();
+
+            // KSAlmanac computes the closest dawn and dusk events from the local sidereal time corresponding to the midnight argument
+            KSAlmanac const ksal(midnight, geo);
+
+            Twilight result;
+            result.date = ksal.getDate();
+            result.dawn = ksal.getDawnAstronomicalTwilight();
+            result.dusk = ksal.getDuskAstronomicalTwilight();
+
+            if (MAX_NIGHTS <= twilightCache.size())
+                twilightCache.clear();
+            twilightCache.insert(second, result);
+            return result;
+        }
+
+    private:
+        EphemerisCache() = default;
+
+        void checkLocation(GeoLocation const *geo)
+        {
+            if (latitude == geo->lat()->Degrees() && longitude == geo->lng()->Degrees() && tz0 == geo->TZ0())
+                return;
+
+            latitude = geo->lat()->Degrees();
+            longitude = geo->lng()->Degrees();
+            tz0 = geo->TZ0();
+            numbersCache.clear();
+            moonCache.clear();
+            twilightCache.clear();
+        }
+
+        typedef QPair<KSMoon const *, qint64> MoonKey;
+
+        static constexpr int MAX_HOURS { 4 * 24 };
+        static constexpr int MAX_SECONDS { 4 * 24 * 60 };
+        static constexpr int MAX_NIGHTS { 16 };
+
+        QMutex mutex;
+        double latitude { qQNaN() };
+        double longitude { qQNaN() };
+        double tz0 { qQNaN() };
+        QHash<qint64, std::shared_ptr<KSNumbers const>> numbersCache;
+        QHash<MoonKey, MoonState> moonCache;
+        QHash<qint64, Twilight> twilightCache;
+};
+}
+
 
 GeoLocation *SchedulerJob::storedGeo = nullptr;
 KStarsDateTime *SchedulerJob::storedLocalTime = nullptr;
@@ -781,8 +925,8 @@ int16_t SchedulerJob::getAltitudeScore(QDateTime const &when, double *altPtr) co
     o.setDec0(target.dec0());
 
     // Update RA/DEC of the target for the current fraction of the day
-    KSNumbers numbers(ltWhen.djd());
-    o.updateCoordsNow(&numbers);
+    std::shared_ptr<KSNumbers const> const numbers = EphemerisCache::instance().numbers(getGeo(), ltWhen.djd());
+    o.updateCoordsNow(numbers.get());
 
     // Compute local sidereal time for the current fraction of the day, calculate altitude
     CachingDms const LST = getGeo()->GSTtoLST(getGeo()->LTtoUT(ltWhen).gst());
@@ -856,23 +1000,19 @@ int16_t SchedulerJob::getMoonSeparationScore(QDateTime const &when) const
     o.setDec0(target.dec0());
 
     // Update RA/DEC of the target for the current fraction of the day
-    KSNumbers numbers(ltWhen.djd());
-    o.updateCoordsNow(&numbers);
+    std::shared_ptr<KSNumbers const> const numbers = EphemerisCache::instance().numbers(getGeo(), ltWhen.djd());
+    o.updateCoordsNow(numbers.get());
 
     // Update moon
-    //ut = getGeo()->LTtoUT(ltWhen);
-    //KSNumbers ksnum(ut.djd()); // BUG: possibly LT.djd() != UT.djd() because of translation
-    //LST = getGeo()->GSTtoLST(ut.gst());
-    CachingDms LST = getGeo()->GSTtoLST(getGeo()->LTtoUT(ltWhen).gst());
-    moon->updateCoords(&numbers, true, getGeo()->lat(), &LST, true);
+    EphemerisCache::MoonState const moonState = EphemerisCache::instance().moon(getGeo(), moon, ltWhen);
 
-    double const moonAltitude = moon->alt().Degrees();
+    double const moonAltitude = moonState.altitude;
 
     // Lunar illumination %
-    double const illum = moon->illum() * 100.0;
+    double const illum = moonState.illumination * 100.0;
 
     // Moon/Sky separation p
-    double const separation = moon->angularDistanceTo(&o).Degrees();
+    double const separation = moonState.position.angularDistanceTo(&o).Degrees();
 
     // Zenith distance of the moon
     double const zMoon = (90 - moonAltitude);
@@ -931,18 +1071,14 @@ double SchedulerJob::getCurrentMoonSeparation() const
     o.setDec0(target.dec0());
 
     // Update RA/DEC of the target for the current fraction of the day
-    KSNumbers numbers(ltWhen.djd());
-    o.updateCoordsNow(&numbers);
+    std::shared_ptr<KSNumbers const> const numbers = EphemerisCache::instance().numbers(getGeo(), ltWhen.djd());
+    o.updateCoordsNow(numbers.get());
 
     // Update moon
-    //ut = getGeo()->LTtoUT(ltWhen);
-    //KSNumbers ksnum(ut.djd()); // BUG: possibly LT.djd() != UT.djd() because of translation
-    //LST = getGeo()->GSTtoLST(ut.gst());
-    CachingDms LST = getGeo()->GSTtoLST(getGeo()->LTtoUT(ltWhen).gst());
-    moon->updateCoords(&numbers, true, getGeo()->lat(), &LST, true);
+    EphemerisCache::MoonState const moonState = EphemerisCache::instance().moon(getGeo(), moon, ltWhen);
 
     // Moon/Sky separation p
-    return moon->angularDistanceTo(&o).Degrees();
+    return moonState.position.angularDistanceTo(&o).Degrees();
 }
 
 QDateTime SchedulerJob::calculateAltitudeTime(QDateTime const &when) const
@@ -960,48 +1096,145 @@ QDateTime SchedulerJob::calculateAltitudeTime(QDateTime const &when) const
     o.setRA0(target.ra0());
     o.setDec0(target.dec0());
 
-    // Calculate the UT at the argument time
-    KStarsDateTime const ut = getGeo()->LTtoUT(ltWhen);
+    // Update RA/DEC of the target once for the argument date/time.
+    // Over the 24-hour search window the apparent position moves by a few arcseconds only,
+    // so the altitude becomes a closed-form function of the hour angle.
+    std::shared_ptr<KSNumbers const> const numbers = EphemerisCache::instance().numbers(getGeo(), ltWhen.djd());
+    o.updateCoordsNow(numbers.get());
 
-    double const SETTING_ALTITUDE_CUTOFF = Options::settingAltitudeCutoff();
+    // Local sidereal time at the argument date/time, advancing at the sidereal rate afterwards
+    CachingDms const LST = getGeo()->GSTtoLST(getGeo()->LTtoUT(ltWhen).gst());
 
-    // Within the next 24 hours, search when the job target matches the altitude and moon constraints
-    for (unsigned int minute = 0; minute < 24 * 60; minute++)
-    {
-        KStarsDateTime const ltOffset(ltWhen.addSecs(minute * 60));
+    double sinLat, cosLat, sinDec, cosDec;
+    getGeo()->lat()->SinCos(sinLat, cosLat);
+    o.dec().SinCos(sinDec, cosDec);
 
-        // Update RA/DEC of the target for the current fraction of the day
-        KSNumbers numbers(ltOffset.djd());
-        o.updateCoordsNow(&numbers);
+    // Hours are reduced to [-12,12[, meridian being at 0
+    auto reduceHours = [](double hours)
+    {
+        hours = fmod(hours + 12.0, 24.0);
+        if (hours < 0.0)
+            hours += 24.0;
+        return hours - 12.0;
+    };
+
+    double const startHourAngle = reduceHours(LST.Hours() - o.ra().Hours());
+    auto hourAngleAt = [&](int minute)
+    {
+        return reduceHours(startHourAngle + minute * SIDEREALSECOND / 60.0);
+    };
 
-        // Compute local sidereal time for the current fraction of the day, calculate altitude
-        CachingDms const LST = getGeo()->GSTtoLST(getGeo()->LTtoUT(ltOffset).gst());
-        o.EquatorialToHorizontal(&LST, getGeo()->lat());
-        double const altitude = o.alt().Degrees();
+    double const SETTING_ALTITUDE_CUTOFF = Options::settingAltitudeCutoff();
+    double const minAltitude = getMinAltitude();
+    // Once past the meridian, the target must also stay above the cutoff
+    double const settingAltitude = std::max(minAltitude, minAltitude + SETTING_ALTITUDE_CUTOFF);
 
-        if (getMinAltitude() <= altitude)
+    auto isAltitudeValid = [&](int minute)
+    {
+        double const hourAngle = hourAngleAt(minute);
+        double const altitude = asin(sinDec * sinLat + cosDec * cosLat * cos(hourAngle * dms::PI / 12.0)) * 180.0 / dms::PI;
+        return (0.0 <= hourAngle) ? settingAltitude <= altitude : minAltitude <= altitude;
+    };
+
+    // Hour angle at which the target crosses the argument altitude, in hours, -1 if it never gets above,
+    // 12 if it never gets below.
+    auto crossingHourAngle = [&](double altitude)
+    {
+        double const cosHourAngle = (sin(altitude * dms::PI / 180.0) - sinDec * sinLat) / (cosDec * cosLat);
+        if (1.0 < cosHourAngle)
+            return -1.0;
+        if (cosHourAngle < -1.0)
+            return 12.0;
+        return acos(cosHourAngle) * 12.0 / dms::PI;
+    };
+
+    // The target is acceptable while its hour angle lies in [-risingLimit, settingLimit]
+    double const risingLimit = crossingHourAngle(minAltitude);
+
+    int const searchMinutes = 24 * 60;
+
+    // First minute at or after the argument minute at which altitude constraints are satisfied.
+    // The crossing is solved analytically, then adjusted to the minute grid of the search.
+    auto nextValidMinute = [&](int from)
+    {
+        if (searchMinutes <= from || isAltitudeValid(from))
+            return from;
+        if (risingLimit < 0.0)
+            return searchMinutes;
+
+        double delta = -risingLimit - hourAngleAt(from);
+        if (delta < 0.0)
+            delta += 24.0;
+        int minute = std::min(searchMinutes, from + static_cast<int>(ceil(delta * 60.0 / SIDEREALSECOND)));
+
+        while (from < minute && isAltitudeValid(minute - 1))
+            minute--;
+        while (minute < searchMinutes && !isAltitudeValid(minute))
+            minute++;
+        return minute;
+    };
+
+    int minute = nextValidMinute(0);
+
+    // Continue searching if Moon separation is not good enough.
+    // The Moon moves about half a degree per hour, so probe at a coarse step and refine the crossing.
+    if (0 < getMinMoonSeparation())
+    {
+        int const MOON_PROBE_MINUTES = 10;
+        auto isMoonValid = [&](int probeMinute)
         {
-            // Don't test proximity to dawn in this situation, we only cater for altitude here
+            return 0 <= getMoonSeparationScore(ltWhen.addSecs(probeMinute * 60));
+        };
 
-            // Continue searching if Moon separation is not good enough
-            if (0 < getMinMoonSeparation() && getMoonSeparationScore(ltOffset) < 0)
-                continue;
+        // Last probed minute with a bad Moon separation in the current altitude window, if any
+        int lastInvalid = -1;
+        while (minute < searchMinutes && !isMoonValid(minute))
+        {
+            lastInvalid = minute;
 
-            // Continue searching if target is setting and under the cutoff
-            double offset = LST.Hours() - o.ra().Hours();
-            if (24.0 <= offset)
-                offset -= 24.0;
-            else if (offset < 0.0)
-                offset += 24.0;
-            if (0.0 <= offset && offset < 12.0)
-                if (altitude - SETTING_ALTITUDE_CUTOFF < getMinAltitude())
-                    continue;
+            int probe = std::min(minute + MOON_PROBE_MINUTES, searchMinutes - 1);
+            if (probe == minute)
+            {
+                minute = searchMinutes;
+                break;
+            }
+            if (!isAltitudeValid(probe))
+            {
+                // Probe the last minute of the current window, or move on to the next window
+                int end = minute;
+                while (end + 1 < probe && isAltitudeValid(end + 1))
+                    end++;
+                if (end == minute)
+                {
+                    probe = nextValidMinute(probe);
+                    lastInvalid = -1;
+                }
+                else
+                    probe = end;
+            }
+            minute = probe;
+        }
 
-            return ltOffset;
+        if (minute < searchMinutes && 0 <= lastInvalid)
+        {
+            // Bisect between the last bad and the first good probe
+            int low = lastInvalid, high = minute;
+            while (1 < high - low)
+            {
+                int const middle = (low + high) / 2;
+                if (isMoonValid(middle))
+                    high = middle;
+                else
+                    low = middle;
+            }
+            minute = high;
         }
     }
 
-    return QDateTime();
+    if (searchMinutes <= minute)
+        return QDateTime();
+
+    return ltWhen.addSecs(minute * 60);
 }
 
 QDateTime SchedulerJob::calculateCulmination(QDateTime const &when) const
@@ -1022,8 +1255,8 @@ QDateTime SchedulerJob::calculateCulmination(QDateTime const &when) const
     o.setDec0(target.dec0());
 
     // Update RA/DEC for the argument date/time
-    KSNumbers numbers(ltWhen.djd());
-    o.updateCoordsNow(&numbers);
+    std::shared_ptr<KSNumbers const> const numbers = EphemerisCache::instance().numbers(getGeo(), ltWhen.djd());
+    o.updateCoordsNow(numbers.get());
 
     // Calculate transit date/time at the argument date - transitTime requires UT and returns LocalTime
     KStarsDateTime transitDateTime(ltWhen.date(), o.transitTime(getGeo()->LTtoUT(ltWhen), getGeo()), Qt::LocalTime);
@@ -1070,8 +1303,8 @@ double SchedulerJob::findAltitude(const SkyPoint &target, const QDateTime &when,
     o.setDec0(target.dec0());
 
     // Update RA/DEC of the target for the current fraction of the day
-    KSNumbers numbers(ltWhen.djd());
-    o.updateCoordsNow(&numbers);
+    std::shared_ptr<KSNumbers const> const numbers = EphemerisCache::instance().numbers(getGeo(), ltWhen.djd());
+    o.updateCoordsNow(numbers.get());
 
     // Calculate alt/az coordinates using KStars instance's geolocation
     CachingDms const LST = getGeo()->GSTtoLST(getGeo()->LTtoUT(ltWhen).gst());
@@ -1118,16 +1351,16 @@ void SchedulerJob::calculateDawnDusk(QDateTime const &when, QDateTime &nextDawn,
     // Loop dawn and dusk calculation until the events found are the next events
     for ( ; dawn <= startup || dusk <= startup ; midnight = midnight.addDays(1))
     {
-        // KSAlmanac computes the closest dawn and dusk events from the local sidereal time corresponding to the midnight argument
-        KSAlmanac const ksal(midnight, getGeo());
+        // The almanac of each midnight is shared by all jobs
+        EphemerisCache::Twilight const ksal = EphemerisCache::instance().twilight(getGeo(), midnight);
 
         // If dawn is in the past compared to this observation, fetch the next dawn
         if (dawn <= startup)
-            dawn = getGeo()->UTtoLT(ksal.getDate().addSecs((ksal.getDawnAstronomicalTwilight() * 24.0 + Options::dawnOffset()) * 3600.0));
+            dawn = getGeo()->UTtoLT(ksal.date.addSecs((ksal.dawn * 24.0 + Options::dawnOffset()) * 3600.0));
 
         // If dusk is in the past compared to this observation, fetch the next dusk
         if (dusk <= startup)
-            dusk = getGeo()->UTtoLT(ksal.getDate().addSecs((ksal.getDuskAstronomicalTwilight() * 24.0 + Options::duskOffset()) * 3600.0));
+            dusk = getGeo()->UTtoLT(ksal.date.addSecs((ksal.dusk * 24.0 + Options::duskOffset()) * 3600.0));
     }
 
     // Now we have the next events:
@@ -24,8 +24,6 @@
 #include "fitscentroiddetector.h"
 #include "fitssepdetector.h"
 
-#include "fpack.h"
-
 #include "kstarsdata.h"
 #include "ksutils.h"
 #include "kspaths.h"
@@ -88,8 +86,14 @@ FITSData::FITSData(const QSharedPointer<FITSData> &other)
     m_TemporaryDataFile.setFileTemplate("fits_memory_XXXXXX");
 
     this->m_Mode = other->m_Mode;
+    // The full statistics of the other image may be being computed by another thread
+    QMutexLocker locker(&other->m_FullStatisticsMutex);
     this->m_Statistics.channels = other->m_Statistics.channels;
     memcpy(&m_Statistics, &(other->m_Statistics), sizeof(m_Statistics));
+    m_StatisticsROI = other->m_StatisticsROI;
+    m_ROIStatistics = other->m_ROIStatistics;
+    m_FullStatistics = other->m_FullStatistics;
+    m_FullStatisticsPending = other->m_FullStatisticsPending.load();
     m_ImageBuffer = new uint8_t[m_Statistics.samples_per_channel * m_Statistics.channels * m_Statistics.bytesPerPixel];
     memcpy(m_ImageBuffer, other->m_ImageBuffer,
            m_Statistics.samples_per_channel * m_Statistics.channels * m_Statistics.bytesPerPixel);
@@ -112,8 +116,6 @@ FITSData::~FITSData()
     if (starCenters.count() > 0)
         qDeleteAll(starCenters);
 
-    delete[] m_WCSCoordinates;
-
     if (m_SkyObjects.count() > 0)
         qDeleteAll(m_SkyObjects);
 
@@ -159,6 +161,11 @@ QFuture<bool> FITSData::loadFromFile(const QString &inFilename, bool silent)
 
 namespace
 {
+// Initial spacing in pixels between the exact WCS positions sampled by loadWCS()
+constexpr int WCS_GRID_STEP = 32;
+// Maximum error in pixels when interpolating the WCS positions between samples
+constexpr double WCS_GRID_MAX_ERROR = 0.1;
+
 // Common code for reporting fits read errors. Always returns false.
 bool fitsOpenError(int status, const QString &message, bool silent)
 {
@@ -172,6 +179,15 @@ bool fitsOpenError(int status, const QString &message, bool silent)
     qCCritical(KSTARS_FITS) << errMessage;
     return false;
 }
+
+// Read the header of the current HDU as a string of 80 character records.
+// The keywords of a tile compressed image are converted to those of the uncompressed image.
+int readHeaderString(fitsfile *fptr, int nocomments, char **header, int *nkeys, int *status)
+{
+    if (fits_is_compressed_image(fptr, status))
+        return fits_convert_hdr2str(fptr, nocomments, nullptr, 0, header, nkeys, status);
+    return fits_hdr2str(fptr, nocomments, nullptr, 0, header, nkeys, status);
+}
 }
 
 bool FITSData::privateLoad(const QByteArray &buffer, const QString &extension, bool silent)
@@ -179,7 +195,7 @@ bool FITSData::privateLoad(const QByteArray &buffer, const QString &extension, b
     m_isTemporary = m_Filename.startsWith(m_TemporaryPath);
 
     if (extension.contains("fit"))
-        return loadFITSImage(buffer, extension, silent);
+        return loadFITSImage(buffer, silent);
     if (QImageReader::supportedImageFormats().contains(extension.toLatin1()))
         return loadCanonicalImage(buffer, extension, silent);
     else if (RAWFormats.contains(extension))
@@ -188,36 +204,15 @@ bool FITSData::privateLoad(const QByteArray &buffer, const QString &extension, b
     return false;
 }
 
-bool FITSData::loadFITSImage(const QByteArray &buffer, const QString &extension, bool silent)
+bool FITSData::loadFITSImage(const QByteArray &buffer, bool silent)
 {
     int status = 0, anynull = 0;
     long naxes[3];
-    QString errMessage;
 
     m_HistogramConstructed = false;
 
-    if (buffer.isEmpty() && extension.contains(".fz"))
-    {
-        // Store so we don't lose.
-        m_compressedFilename = m_Filename;
-
-        QString uncompressedFile = QDir::tempPath() + QString("/%1").arg(QUuid::createUuid().toString().remove(
-                                       QRegularExpression("[-{}]")));
-        fpstate fpvar;
-        fp_init (&fpvar);
-        if (fp_unpack(m_Filename.toLocal8Bit().data(), uncompressedFile.toLocal8Bit().data(), fpvar) < 0)
-        {
-            errMessage = i18n("Failed to unpack compressed fits");
-            if (!silent)
-                KSNotification::error(errMessage, i18n("FITS Open"));
-            qCCritical(KSTARS_FITS) << errMessage;
-            return false;
-        }
-
-        m_Filename = uncompressedFile;
-        m_isTemporary = true;
-        m_isCompressed = true;
-    }
+    m_isCompressed = false;
+    m_compressedFilename.clear();
 
     if (buffer.isEmpty())
     {
@@ -252,6 +247,23 @@ bool FITSData::loadFITSImage(const QByteArray &buffer, const QString &extension,
         return fitsOpenError(status, i18n("Could not locate image HDU."), silent);
     }
 
+    // A tile compressed image (.fits.fz) is stored in the extension following an empty primary HDU.
+    // CFITSIO decompresses its tiles while reading, so no uncompressed copy of the file is made.
+    int primaryAxes = 0, hduCount = 0;
+    if (fits_get_img_dim(fptr, &primaryAxes, &status) == 0 && primaryAxes == 0 &&
+            fits_get_num_hdus(fptr, &hduCount, &status) == 0 && hduCount > 1)
+    {
+        if (fits_movabs_hdu(fptr, 2, IMAGE_HDU, &status))
+        {
+            recordLastError(status);
+            return fitsOpenError(status, i18n("Could not locate image HDU."), silent);
+        }
+
+        m_isCompressed = fits_is_compressed_image(fptr, &status);
+        if (m_isCompressed)
+            m_compressedFilename = m_Filename;
+    }
+
     if (fits_get_img_param(fptr, 3, &m_FITSBITPIX, &(m_Statistics.ndim), naxes, &status))
     {
         recordLastError(status);
@@ -640,6 +652,9 @@ bool FITSData::saveImage(const QString &newFilename)
     if (newFilename == m_Filename)
         return true;
 
+    // Written images, their headers and their stretch use the statistics of the whole frame.
+    FITSImage::Statistic &stats = fullStatistics();
+
     const QString ext = QFileInfo(newFilename).suffix();
 
     if (ext == "jpg" || ext == "png")
@@ -665,8 +680,8 @@ bool FITSData::saveImage(const QString &newFilename)
             fitsImage = QImage(width(), height(), QImage::Format_RGB32);
         }
 
-        double dataMin = m_Statistics.mean[0] - m_Statistics.stddev[0];
-        double dataMax = m_Statistics.mean[0] + m_Statistics.stddev[0] * 3;
+        double dataMin = stats.mean[0] - stats.stddev[0];
+        double dataMax = stats.mean[0] + stats.stddev[0] * 3;
 
         double bscale = 255. / (dataMax - dataMin);
         double bzero  = (-dataMin) * (255. / (dataMax - dataMin));
@@ -803,65 +818,65 @@ bool FITSData::saveImage(const QString &newFilename)
     /* Write keywords */
 
     // Minimum
-    if (fits_update_key(fptr, TDOUBLE, "DATAMIN", &(m_Statistics.min), "Minimum value", &status))
+    if (fits_update_key(fptr, TDOUBLE, "DATAMIN", &(stats.min), "Minimum value", &status))
     {
         recordLastError(status);
         return false;
     }
 
     // Maximum
-    if (fits_update_key(fptr, TDOUBLE, "DATAMAX", &(m_Statistics.max), "Maximum value", &status))
+    if (fits_update_key(fptr, TDOUBLE, "DATAMAX", &(stats.max), "Maximum value", &status))
     {
         recordLastError(status);
         return false;
     }
 
     // KStars Min, for 3 channels
-    fits_write_key(fptr, TDOUBLE, "MIN1", &m_Statistics.min[0], "Min Channel 1", &status);
+    fits_write_key(fptr, TDOUBLE, "MIN1", &stats.min[0], "Min Channel 1", &status);
     if (channels() > 1)
     {
-        fits_write_key(fptr, TDOUBLE, "MIN2", &m_Statistics.min[1], "Min Channel 2", &status);
-        fits_write_key(fptr, TDOUBLE, "MIN3", &m_Statistics.min[2], "Min Channel 3", &status);
+        fits_write_key(fptr, TDOUBLE, "MIN2", &stats.min[1], "Min Channel 2", &status);
+        fits_write_key(fptr, TDOUBLE, "MIN3", &stats.min[2], "Min Channel 3", &status);
     }
 
     // KStars max, for 3 channels
-    fits_write_key(fptr, TDOUBLE, "MAX1", &m_Statistics.max[0], "Max Channel 1", &status);
+    fits_write_key(fptr, TDOUBLE, "MAX1", &stats.max[0], "Max Channel 1", &status);
     if (channels() > 1)
     {
-        fits_write_key(fptr, TDOUBLE, "MAX2", &m_Statistics.max[1], "Max Channel 2", &status);
-        fits_write_key(fptr, TDOUBLE, "MAX3", &m_Statistics.max[2], "Max Channel 3", &status);
+        fits_write_key(fptr, TDOUBLE, "MAX2", &stats.max[1], "Max Channel 2", &status);
+        fits_write_key(fptr, TDOUBLE, "MAX3", &stats.max[2], "Max Channel 3", &status);
     }
 
     // Mean
-    if (m_Statistics.mean[0] > 0)
+    if (stats.mean[0] > 0)
     {
-        fits_write_key(fptr, TDOUBLE, "MEAN1", &m_Statistics.mean[0], "Mean Channel 1", &status);
+        fits_write_key(fptr, TDOUBLE, "MEAN1", &stats.mean[0], "Mean Channel 1", &status);
         if (channels() > 1)
         {
-            fits_write_key(fptr, TDOUBLE, "MEAN2", &m_Statistics.mean[1], "Mean Channel 2", &status);
-            fits_write_key(fptr, TDOUBLE, "MEAN3", &m_Statistics.mean[2], "Mean Channel 3", &status);
+            fits_write_key(fptr, TDOUBLE, "MEAN2", &stats.mean[1], "Mean Channel 2", &status);
+            fits_write_key(fptr, TDOUBLE, "MEAN3", &stats.mean[2], "Mean Channel 3", &status);
         }
     }
 
     // Median
-    if (m_Statistics.median[0] > 0)
+    if (stats.median[0] > 0)
     {
-        fits_write_key(fptr, TDOUBLE, "MEDIAN1", &m_Statistics.median[0], "Median Channel 1", &status);
+        fits_write_key(fptr, TDOUBLE, "MEDIAN1", &stats.median[0], "Median Channel 1", &status);
         if (channels() > 1)
         {
-            fits_write_key(fptr, TDOUBLE, "MEDIAN2", &m_Statistics.median[1], "Median Channel 2", &status);
-            fits_write_key(fptr, TDOUBLE, "MEDIAN3", &m_Statistics.median[2], "Median Channel 3", &status);
+            fits_write_key(fptr, TDOUBLE, "MEDIAN2", &stats.median[1], "Median Channel 2", &status);
+            fits_write_key(fptr, TDOUBLE, "MEDIAN3", &stats.median[2], "Median Channel 3", &status);
         }
     }
 
     // Standard Deviation
-    if (m_Statistics.stddev[0] > 0)
+    if (stats.stddev[0] > 0)
     {
-        fits_write_key(fptr, TDOUBLE, "STDDEV1", &m_Statistics.stddev[0], "Standard Deviation Channel 1", &status);
+        fits_write_key(fptr, TDOUBLE, "STDDEV1", &stats.stddev[0], "Standard Deviation Channel 1", &status);
         if (channels() > 1)
         {
-            fits_write_key(fptr, TDOUBLE, "STDDEV2", &m_Statistics.stddev[1], "Standard Deviation Channel 2", &status);
-            fits_write_key(fptr, TDOUBLE, "STDDEV3", &m_Statistics.stddev[2], "Standard Deviation Channel 3", &status);
+            fits_write_key(fptr, TDOUBLE, "STDDEV2", &stats.stddev[1], "Standard Deviation Channel 2", &status);
+            fits_write_key(fptr, TDOUBLE, "STDDEV3", &stats.stddev[2], "Standard Deviation Channel 3", &status);
         }
     }
 
@@ -940,6 +955,7 @@ bool FITSData::saveImage(const QString &newFilename)
 
 void FITSData::clearImageBuffers()
 {
+    m_HistogramPrebinned = false;
     delete[] m_ImageBuffer;
     m_ImageBuffer = nullptr;
     //m_BayerBuffer = nullptr;
@@ -947,319 +963,411 @@ void FITSData::clearImageBuffers()
 
 void FITSData::calculateStats(bool refresh)
 {
-    // Calculate min max
-    calculateMinMax(refresh);
-    calculateMedian(refresh);
-
-    // Try to read mean/median/stddev if in file
-    if (refresh == false && fptr)
+    // Focus and guide frames pay for their ROI now, and for the full frame only if it is ever read.
+    if ((m_Mode == FITS_FOCUS || m_Mode == FITS_GUIDE) && m_StatisticsROI.isNull() == false && calculateROIStats())
     {
-        int status = 0;
-        int nfound = 0;
-        if (fits_read_key_dbl(fptr, "MEAN1", &m_Statistics.mean[0], nullptr, &status) == 0)
-            nfound++;
-        // NB. These could fail if missing, which is OK.
-        fits_read_key_dbl(fptr, "MEAN2", & m_Statistics.mean[1], nullptr, &status);
-        fits_read_key_dbl(fptr, "MEAN3", &m_Statistics.mean[2], nullptr, &status);
-
-        status = 0;
-        if (fits_read_key_dbl(fptr, "STDDEV1", &m_Statistics.stddev[0], nullptr, &status) == 0)
-            nfound++;
-        // NB. These could fail if missing, which is OK.
-        fits_read_key_dbl(fptr, "STDDEV2", &m_Statistics.stddev[1], nullptr, &status);
-        fits_read_key_dbl(fptr, "STDDEV3", &m_Statistics.stddev[2], nullptr, &status);
-
-        // If all is OK, we're done
-        if (nfound == 2)
-            return;
+        QMutexLocker locker(&m_FullStatisticsMutex);
+        m_ROIStatistics = true;
+        m_FullStatisticsPending = true;
+        return;
     }
 
-    // Get standard deviation and mean in one run
+    m_ROIStatistics = false;
+    m_FullStatisticsPending = false;
+    calculateFullStats(m_Statistics, refresh);
+}
+
+void FITSData::ensureFullStatistics() const
+{
+    if (m_FullStatisticsPending == false)
+        return;
+
+    // Statistics getters may be called from several threads, e.g. while stars are being detected.
+    // The first caller computes the full statistics, the others wait for them. The pending flag is
+    // only cleared once they are complete, so a caller that finds it cleared can read them unlocked.
+    QMutexLocker locker(&m_FullStatisticsMutex);
+    if (m_FullStatisticsPending == false)
+        return;
+
+    // Dimensions and data type are those of the ROI statistics, the values are all computed again.
+    m_FullStatistics = m_Statistics;
+    // The statistics cache properties of the image buffer, computing them does not change the data.
+    const_cast<FITSData *>(this)->calculateFullStats(m_FullStatistics, false);
+    m_FullStatisticsPending = false;
+}
+
+FITSImage::Statistic const &FITSData::fullStatistics() const
+{
+    if (m_ROIStatistics == false)
+        return m_Statistics;
+
+    ensureFullStatistics();
+    return m_FullStatistics;
+}
+
+FITSImage::Statistic &FITSData::fullStatistics()
+{
+    return const_cast<FITSImage::Statistic &>(static_cast<FITSData const *>(this)->fullStatistics());
+}
+
+bool FITSData::calculateROIStats()
+{
+    const QRect roi = m_StatisticsROI.intersected(QRect(0, 0, m_Statistics.width, m_Statistics.height));
+    if (roi.isEmpty())
+        return false;
+
     switch (m_Statistics.dataType)
     {
         case TBYTE:
-            runningAverageStdDev<uint8_t>();
+            calculateROIStatsInternal<uint8_t>(roi);
             break;
 
         case TSHORT:
-            runningAverageStdDev<int16_t>();
+            calculateROIStatsInternal<int16_t>(roi);
             break;
 
         case TUSHORT:
-            runningAverageStdDev<uint16_t>();
+            calculateROIStatsInternal<uint16_t>(roi);
             break;
 
         case TLONG:
-            runningAverageStdDev<int32_t>();
+            calculateROIStatsInternal<int32_t>(roi);
             break;
 
         case TULONG:
-            runningAverageStdDev<uint32_t>();
+            calculateROIStatsInternal<uint32_t>(roi);
             break;
 
         case TFLOAT:
-            runningAverageStdDev<float>();
+            calculateROIStatsInternal<float>(roi);
             break;
 
         case TLONGLONG:
-            runningAverageStdDev<int64_t>();
+            calculateROIStatsInternal<int64_t>(roi);
             break;
 
         case TDOUBLE:
-            runningAverageStdDev<double>();
+            calculateROIStatsInternal<double>(roi);
             break;
 
         default:
-            return;
+            return false;
     }
 
+    m_HistogramPrebinned = false;
     // FIXME That's not really SNR, must implement a proper solution for this value
     m_Statistics.SNR = m_Statistics.mean[0] / m_Statistics.stddev[0];
+    return true;
 }
 
-void FITSData::calculateMinMax(bool refresh)
+void FITSData::calculateFullStats(FITSImage::Statistic &stats, bool refresh)
 {
-    int status, nfound = 0;
+    bool haveMinMax = false, haveMedian = false, haveMeanStdDev = false;
+    m_HistogramPrebinned = false;
 
-    status = 0;
+    // Try to read min/max/median/mean/stddev if in file
+    if (refresh == false && fptr)
+        readStatsFromHeader(stats, haveMinMax, haveMedian, haveMeanStdDev);
 
-    // Only fetch from header if we have a single channel
-    // Otherwise, calculate manually.
-    if (fptr != nullptr && !refresh)
+    // Any values missing from the header are computed in a single sweep over the buffer.
+    if (!haveMinMax || !haveMedian || !haveMeanStdDev)
     {
+        if (!haveMinMax)
+        {
+            for (int n = 0; n < 3; n++)
+            {
+                stats.min[n] = 1.0E30;
+                stats.max[n] = -1.0E30;
+            }
+        }
 
-        status = 0;
-
-        if (fits_read_key_dbl(fptr, "DATAMIN", &(m_Statistics.min[0]), nullptr, &status) == 0)
-            nfound++;
-        else if (fits_read_key_dbl(fptr, "MIN1", &(m_Statistics.min[0]), nullptr, &status) == 0)
-            nfound++;
-
-        // NB. These could fail if missing, which is OK.
-        fits_read_key_dbl(fptr, "MIN2", &m_Statistics.min[1], nullptr, &status);
-        fits_read_key_dbl(fptr, "MIN3", &m_Statistics.min[2], nullptr, &status);
-
-        status = 0;
-
-        if (fits_read_key_dbl(fptr, "DATAMAX", &(m_Statistics.max[0]), nullptr, &status) == 0)
-            nfound++;
-        else if (fits_read_key_dbl(fptr, "MAX1", &(m_Statistics.max[0]), nullptr, &status) == 0)
-            nfound++;
-
-        // NB. These could fail if missing, which is OK.
-        fits_read_key_dbl(fptr, "MAX2", &m_Statistics.max[1], nullptr, &status);
-        fits_read_key_dbl(fptr, "MAX3", &m_Statistics.max[2], nullptr, &status);
-
-        // If we found both keywords, no need to calculate them, unless they are both zeros
-        if (nfound == 2 && !(m_Statistics.min[0] == 0 && m_Statistics.max[0] == 0))
-            return;
-    }
-
-    m_Statistics.min[0] = 1.0E30;
-    m_Statistics.max[0] = -1.0E30;
+        if (!haveMedian)
+        {
+            stats.median[RED_CHANNEL] = 0;
+            stats.median[GREEN_CHANNEL] = 0;
+            stats.median[BLUE_CHANNEL] = 0;
+        }
 
-    m_Statistics.min[1] = 1.0E30;
-    m_Statistics.max[1] = -1.0E30;
+        switch (stats.dataType)
+        {
+            case TBYTE:
+                calculateStatsInternal<uint8_t>(stats, !haveMinMax, !haveMedian, !haveMeanStdDev);
+                break;
 
-    m_Statistics.min[2] = 1.0E30;
-    m_Statistics.max[2] = -1.0E30;
+            case TSHORT:
+                calculateStatsInternal<int16_t>(stats, !haveMinMax, !haveMedian, !haveMeanStdDev);
+                break;
 
-    switch (m_Statistics.dataType)
-    {
-        case TBYTE:
-            calculateMinMax<uint8_t>();
-            break;
+            case TUSHORT:
+                calculateStatsInternal<uint16_t>(stats, !haveMinMax, !haveMedian, !haveMeanStdDev);
+                break;
 
-        case TSHORT:
-            calculateMinMax<int16_t>();
-            break;
+            case TLONG:
+                calculateStatsInternal<int32_t>(stats, !haveMinMax, !haveMedian, !haveMeanStdDev);
+                break;
 
-        case TUSHORT:
-            calculateMinMax<uint16_t>();
-            break;
+            case TULONG:
+                calculateStatsInternal<uint32_t>(stats, !haveMinMax, !haveMedian, !haveMeanStdDev);
+                break;
 
-        case TLONG:
-            calculateMinMax<int32_t>();
-            break;
+            case TFLOAT:
+                calculateStatsInternal<float>(stats, !haveMinMax, !haveMedian, !haveMeanStdDev);
+                break;
 
-        case TULONG:
-            calculateMinMax<uint32_t>();
-            break;
+            case TLONGLONG:
+                calculateStatsInternal<int64_t>(stats, !haveMinMax, !haveMedian, !haveMeanStdDev);
+                break;
 
-        case TFLOAT:
-            calculateMinMax<float>();
-            break;
+            case TDOUBLE:
+                calculateStatsInternal<double>(stats, !haveMinMax, !haveMedian, !haveMeanStdDev);
+                break;
 
-        case TLONGLONG:
-            calculateMinMax<int64_t>();
-            break;
+            default:
+                return;
+        }
+    }
 
-        case TDOUBLE:
-            calculateMinMax<double>();
-            break;
+    // If mean and standard deviation came from the header, we're done
+    if (haveMeanStdDev)
+        return;
 
-        default:
-            break;
-    }
+    // FIXME That's not really SNR, must implement a proper solution for this value
+    stats.SNR = stats.mean[0] / stats.stddev[0];
 }
 
-void FITSData::calculateMedian(bool refresh)
+void FITSData::readStatsFromHeader(FITSImage::Statistic &stats, bool &haveMinMax, bool &haveMedian, bool &haveMeanStdDev)
 {
-    int status, nfound = 0;
+    int status = 0, nfound = 0;
 
-    status = 0;
+    if (fits_read_key_dbl(fptr, "DATAMIN", &(stats.min[0]), nullptr, &status) == 0)
+        nfound++;
+    else if (fits_read_key_dbl(fptr, "MIN1", &(stats.min[0]), nullptr, &status) == 0)
+        nfound++;
 
-    // Only fetch from header if we have a single channel
-    // Otherwise, calculate manually.
-    if (fptr != nullptr && !refresh)
-    {
-        status = 0;
-        if (fits_read_key_dbl(fptr, "MEDIAN1", &m_Statistics.median[0], nullptr, &status) == 0)
-            nfound++;
+    // NB. These could fail if missing, which is OK.
+    fits_read_key_dbl(fptr, "MIN2", &stats.min[1], nullptr, &status);
+    fits_read_key_dbl(fptr, "MIN3", &stats.min[2], nullptr, &status);
 
-        // NB. These could fail if missing, which is OK.
-        fits_read_key_dbl(fptr, "MEDIAN2", &m_Statistics.median[1], nullptr, &status);
-        fits_read_key_dbl(fptr, "MEDIAN3", &m_Statistics.median[2], nullptr, &status);
-
-        if (nfound == 1)
-            return;
-    }
+    status = 0;
 
-    m_Statistics.median[RED_CHANNEL] = 0;
-    m_Statistics.median[GREEN_CHANNEL] = 0;
-    m_Statistics.median[BLUE_CHANNEL] = 0;
+    if (fits_read_key_dbl(fptr, "DATAMAX", &(stats.max[0]), nullptr, &status) == 0)
+        nfound++;
+    else if (fits_read_key_dbl(fptr, "MAX1", &(stats.max[0]), nullptr, &status) == 0)
+        nfound++;
 
-    switch (m_Statistics.dataType)
-    {
-        case TBYTE:
-            calculateMedian<uint8_t>();
-            break;
+    // NB. These could fail if missing, which is OK.
+    fits_read_key_dbl(fptr, "MAX2", &stats.max[1], nullptr, &status);
+    fits_read_key_dbl(fptr, "MAX3", &stats.max[2], nullptr, &status);
 
-        case TSHORT:
-            calculateMedian<int16_t>();
-            break;
+    // If we found both keywords, no need to calculate them, unless they are both zeros
+    haveMinMax = (nfound == 2 && !(stats.min[0] == 0 && stats.max[0] == 0));
 
-        case TUSHORT:
-            calculateMedian<uint16_t>();
-            break;
-
-        case TLONG:
-            calculateMedian<int32_t>();
-            break;
-
-        case TULONG:
-            calculateMedian<uint32_t>();
-            break;
+    status = 0;
+    haveMedian = (fits_read_key_dbl(fptr, "MEDIAN1", &stats.median[0], nullptr, &status) == 0);
 
-        case TFLOAT:
-            calculateMedian<float>();
-            break;
+    // NB. These could fail if missing, which is OK.
+    fits_read_key_dbl(fptr, "MEDIAN2", &stats.median[1], nullptr, &status);
+    fits_read_key_dbl(fptr, "MEDIAN3", &stats.median[2], nullptr, &status);
 
-        case TLONGLONG:
-            calculateMedian<int64_t>();
-            break;
+    status = 0;
+    nfound = 0;
+    if (fits_read_key_dbl(fptr, "MEAN1", &stats.mean[0], nullptr, &status) == 0)
+        nfound++;
+    // NB. These could fail if missing, which is OK.
+    fits_read_key_dbl(fptr, "MEAN2", & stats.mean[1], nullptr, &status);
+    fits_read_key_dbl(fptr, "MEAN3", &stats.mean[2], nullptr, &status);
 
-        case TDOUBLE:
-            calculateMedian<double>();
-            break;
+    status = 0;
+    if (fits_read_key_dbl(fptr, "STDDEV1", &stats.stddev[0], nullptr, &status) == 0)
+        nfound++;
+    // NB. These could fail if missing, which is OK.
+    fits_read_key_dbl(fptr, "STDDEV2", &stats.stddev[1], nullptr, &status);
+    fits_read_key_dbl(fptr, "STDDEV3", &stats.stddev[2], nullptr, &status);
 
-        default:
-            break;
-    }
+    haveMeanStdDev = (nfound == 2);
 }
 
+namespace
+{
+// Partial statistics of one partition of a channel.
+// The sums are taken relative to the first sample of the partition to limit cancellation.
 template <typename T>
-void FITSData::calculateMedian()
+struct PartitionStats
 {
-    auto * buffer = reinterpret_cast<T *>(m_ImageBuffer);
-    const uint32_t maxMedianSize = 500000;
-    uint32_t medianSize = m_Statistics.samples_per_channel;
-    uint8_t downsample = 1;
-    if (medianSize > maxMedianSize)
-    {
-        downsample = (static_cast<double>(medianSize) / maxMedianSize) + 0.999;
-        medianSize /= downsample;
-    }
-    std::vector<T> samples;
-    samples.reserve(medianSize);
-
-    for (uint8_t n = 0; n < m_Statistics.channels; n++)
-    {
-        auto *oneChannel = buffer + n * m_Statistics.samples_per_channel;
-        for (uint32_t upto = 0; upto < m_Statistics.samples_per_channel; upto += downsample)
-            samples.push_back(oneChannel[upto]);
-        const uint32_t middle = samples.size() / 2;
-        std::nth_element(samples.begin(), samples.begin() + middle, samples.end());
-        m_Statistics.median[n] = samples[middle];
-    }
+    T min { std::numeric_limits<T>::max() };
+    T max { std::numeric_limits<T>::lowest() };
+    double shift { 0 };
+    double sum { 0 };
+    double squaredSum { 0 };
+    uint32_t count { 0 };
+};
 }
 
 template <typename T>
-QPair<T, T> FITSData::getParitionMinMax(uint32_t start, uint32_t stride)
+void FITSData::calculateROIStatsInternal(const QRect &roi)
 {
-    auto * buffer = reinterpret_cast<T *>(m_ImageBuffer);
-    T min = std::numeric_limits<T>::max();
-    T max = std::numeric_limits<T>::min();
-
-    uint32_t end = start + stride;
+    auto * const buffer = reinterpret_cast<T const *>(m_ImageBuffer);
+    const uint32_t width = m_Statistics.width;
+    // Regions are small, so the exact median is affordable.
+    std::vector<T> values(roi.width() * roi.height());
 
-    for (uint32_t i = start; i < end; i++)
+    for (int n = 0; n < m_Statistics.channels; n++)
     {
-        min = qMin(buffer[i], min);
-        max = qMax(buffer[i], max);
-        //        if (buffer[i] < min)
-        //            min = buffer[i];
-        //        else if (buffer[i] > max)
-        //            max = buffer[i];
-    }
+        T const * const channel = buffer + n * m_Statistics.samples_per_channel;
+        PartitionStats<T> result;
+        result.shift = channel[roi.y() * width + roi.x()];
+        result.count = values.size();
+        T * out = values.data();
+
+        for (int y = roi.top(); y <= roi.bottom(); y++)
+        {
+            T const * const row = channel + y * width;
+            for (int x = roi.left(); x <= roi.right(); x++)
+            {
+                const T value = row[x];
+                *out++ = value;
+                result.min = qMin(value, result.min);
+                result.max = qMax(value, result.max);
+                const double delta = value - result.shift;
+                result.sum += delta;
+                result.squaredSum += delta * delta;
+            }
+        }
 
-    return qMakePair(min, max);
+        const double count = result.count;
+        m_Statistics.min[n]    = result.min;
+        m_Statistics.max[n]    = result.max;
+        m_Statistics.mean[n]   = result.shift + result.sum / count;
+        m_Statistics.stddev[n] = sqrt(qMax(0.0, result.squaredSum - result.sum * result.sum / count) / count);
+
+        const auto middle = values.begin() + values.size() / 2;
+        std::nth_element(values.begin(), middle, values.end());
+        m_Statistics.median[n] = *middle;
+    }
 }
 
 template <typename T>
-void FITSData::calculateMinMax()
+void FITSData::calculateStatsInternal(FITSImage::Statistic &stats, bool minMax, bool median, bool meanStdDev)
 {
-    T min = std::numeric_limits<T>::max();
-    T max = std::numeric_limits<T>::min();
+    auto * const buffer = reinterpret_cast<T const *>(m_ImageBuffer);
+    const uint32_t samples = stats.samples_per_channel;
+    if (samples == 0)
+        return;
 
+    // Retain every sampleBy-th sample: these are exactly the samples the histogram uses,
+    // and they also give the median without another pass over the image.
+    const uint32_t sampleBy = samples > 500000 ? samples / 500000 : 1;
+    const uint32_t sampledCount = (samples + sampleBy - 1) / sampleBy;
 
-    // Create N threads
-    const uint8_t nThreads = 16;
+    // Partitions start on a multiple of sampleBy so they pick the same samples a single sweep would.
+    const int nThreads = QThread::idealThreadCount();
+    uint32_t tStride = (samples / nThreads) / sampleBy * sampleBy;
+    const int nPartitions = tStride == 0 ? 1 : nThreads;
+    if (tStride == 0)
+        tStride = samples;
+    // The final stride takes what is left over due to division above
+    const uint32_t fStride = samples - tStride * (nPartitions - 1);
 
-    for (int n = 0; n < m_Statistics.channels; n++)
+    QVector<std::vector<T>> sampled(stats.channels);
+
+    for (int n = 0; n < stats.channels; n++)
     {
-        uint32_t cStart = n * m_Statistics.samples_per_channel;
+        T const * const channel = buffer + n * samples;
+        sampled[n].resize(sampledCount);
+        T * const sampledChannel = sampled[n].data();
 
-        // Calculate how many elements we process per thread
-        uint32_t tStride = m_Statistics.samples_per_channel / nThreads;
+        QList<QFuture<PartitionStats<T>>> futures;
 
-        // Calculate the final stride since we can have some left over due to division above
-        uint32_t fStride = tStride + (m_Statistics.samples_per_channel - (tStride * nThreads));
+        for (int i = 0; i < nPartitions; i++)
+        {
+            const uint32_t cStart = i * tStride;
+            const uint32_t cEnd = cStart + ((i == (nPartitions - 1)) ? fStride : tStride);
 
-        // Start location for inspecting elements
-        uint32_t tStart = cStart;
+            futures.append(QtConcurrent::run([ = ]()
+            {
+                PartitionStats<T> result;
+                result.shift = channel[cStart];
+                result.count = cEnd - cStart;
+                T * out = sampledChannel + cStart / sampleBy;
 
-        // List of futures
-        QList<QFuture<QPair<T, T>>> futures;
+                for (uint32_t j = cStart; j < cEnd; j += sampleBy)
+                {
+                    *out++ = channel[j];
 
-        for (int i = 0; i < nThreads; i++)
+                    const uint32_t blockEnd = qMin(j + sampleBy, cEnd);
+                    for (uint32_t k = j; k < blockEnd; k++)
+                    {
+                        const T value = channel[k];
+                        result.min = qMin(value, result.min);
+                        result.max = qMax(value, result.max);
+                        const double delta = value - result.shift;
+                        result.sum += delta;
+                        result.squaredSum += delta * delta;
+                    }
+                }
+                return result;
+            }));
+        }
+
+        // Now merge the partitions (Chan et al. parallel variance)
+        T min = std::numeric_limits<T>::max();
+        T max = std::numeric_limits<T>::lowest();
+        double mean = 0, m2 = 0, count = 0;
+        for (int i = 0; i < nPartitions; i++)
         {
-            // Run threads
-            futures.append(QtConcurrent::run(this, &FITSData::getParitionMinMax<T>, tStart, (i == (nThreads - 1)) ? fStride : tStride));
-            tStart += tStride;
+            const PartitionStats<T> result = futures[i].result();
+            min = qMin(result.min, min);
+            max = qMax(result.max, max);
+
+            const double partCount = result.count;
+            const double partMean = result.shift + result.sum / partCount;
+            const double partM2 = result.squaredSum - result.sum * result.sum / partCount;
+            const double delta = partMean - mean;
+            const double total = count + partCount;
+            mean += delta * partCount / total;
+            m2 += partM2 + delta * delta * count * partCount / total;
+            count = total;
         }
 
-        // Now wait for results
-        for (int i = 0; i < nThreads; i++)
+        if (minMax)
+        {
+            stats.min[n] = min;
+            stats.max[n] = max;
+        }
+
+        if (meanStdDev)
         {
-            QPair<T, T> result = futures[i].result();
-            min = qMin(result.first, min);
-            max = qMax(result.second, max);
+            stats.mean[n]   = mean;
+            stats.stddev[n] = sqrt(qMax(0.0, m2) / samples);
         }
 
-        m_Statistics.min[n] = min;
-        m_Statistics.max[n] = max;
+        if (median)
+        {
+            // The histogram below is order independent, so partially sorting the samples is fine.
+            std::vector<T> &values = sampled[n];
+            const uint32_t middle = values.size() / 2;
+            std::nth_element(values.begin(), values.begin() + middle, values.end());
+            stats.median[n] = values[middle];
+        }
+    }
+
+    // Bin the retained samples now that min and max are final, so constructHistogram()
+    // does not need to sweep the image again.
+    initHistogramBins(stats);
+
+    QVector<QFuture<void>> futures;
+    for (int n = 0; n < stats.channels; n++)
+    {
+        futures.append(QtConcurrent::run([ =, &stats, &sampled]()
+        {
+            binHistogram<T>(stats, sampled[n].data(), sampledCount, 1, sampleBy, n);
+        }));
     }
+
+    for (QFuture<void> future : futures)
+        future.waitForFinished();
+
+    m_HistogramPrebinned = true;
 }
 
 template <typename T>
@@ -1326,8 +1434,8 @@ void FITSData::runningAverageStdDev()
 
         double variance = squared_sum / m_Statistics.samples_per_channel;
 
-        m_Statistics.mean[n]   = mean / nThreads;
-        m_Statistics.stddev[n] = sqrt(variance);
+        fullStatistics().mean[n]   = mean / nThreads;
+        fullStatistics().stddev[n] = sqrt(variance);
     }
 }
 
@@ -1427,8 +1535,9 @@ void FITSData::gaussianBlur(int kernelSize, double sigma)
 
 void FITSData::setMinMax(double newMin, double newMax, uint8_t channel)
 {
-    m_Statistics.min[channel] = newMin;
-    m_Statistics.max[channel] = newMax;
+    m_HistogramPrebinned = false;
+    fullStatistics().min[channel] = newMin;
+    fullStatistics().max[channel] = newMax;
 }
 
 bool FITSData::parseHeader()
@@ -1436,7 +1545,7 @@ bool FITSData::parseHeader()
     char * header = nullptr;
     int status = 0, nkeys = 0;
 
-    if (fits_hdr2str(fptr, 0, nullptr, 0, &header, &nkeys, &status))
+    if (readHeaderString(fptr, 0, &header, &nkeys, &status))
     {
         fits_report_error(stderr, status);
         free(header);
@@ -1850,6 +1959,10 @@ void FITSData::applyFilter(FITSScale type, uint8_t * image, QVector<double> * mi
     if (type == FITS_NONE)
         return;
 
+    FITSImage::Statistic const &stats = fullStatistics();
+
+    m_HistogramPrebinned = false;
+
     QVector<double> dataMin(3);
     QVector<double> dataMax(3);
 
@@ -1864,8 +1977,8 @@ void FITSData::applyFilter(FITSScale type, uint8_t * image, QVector<double> * mi
         {
             for (int i = 0; i < 3; i++)
             {
-                dataMin[i] = m_Statistics.mean[i] - m_Statistics.stddev[i];
-                dataMax[i] = m_Statistics.mean[i] + m_Statistics.stddev[i] * 3;
+                dataMin[i] = stats.mean[i] - stats.stddev[i];
+                dataMax[i] = stats.mean[i] + stats.stddev[i] * 3;
             }
         }
         break;
@@ -1874,8 +1987,8 @@ void FITSData::applyFilter(FITSScale type, uint8_t * image, QVector<double> * mi
         {
             for (int i = 0; i < 3; i++)
             {
-                dataMin[i] = m_Statistics.mean[i] + m_Statistics.stddev[i];
-                dataMax[i] = m_Statistics.mean[i] + m_Statistics.stddev[i] * 3;
+                dataMin[i] = stats.mean[i] + stats.stddev[i];
+                dataMax[i] = stats.mean[i] + stats.stddev[i] * 3;
             }
         }
         break;
@@ -1884,7 +1997,7 @@ void FITSData::applyFilter(FITSScale type, uint8_t * image, QVector<double> * mi
         {
             for (int i = 0; i < 3; i++)
             {
-                dataMin[i] = m_Statistics.mean[i];
+                dataMin[i] = stats.mean[i];
             }
         }
         break;
@@ -2056,7 +2169,7 @@ void FITSData::applyFilter(FITSScale type, uint8_t * targetImage, QVector<double
             for (int n = 0; n < m_Statistics.channels; n++)
             {
                 if (type == FITS_HIGH_PASS)
-                    min[n] = m_Statistics.mean[n];
+                    min[n] = fullStatistics().mean[n];
 
                 uint32_t cStart = n * m_Statistics.samples_per_channel;
 
@@ -2118,8 +2231,8 @@ void FITSData::applyFilter(FITSScale type, uint8_t * targetImage, QVector<double
             {
                 for (int i = 0; i < 3; i++)
                 {
-                    m_Statistics.min[i] = min[i];
-                    m_Statistics.max[i] = max[i];
+                    fullStatistics().min[i] = min[i];
+                    fullStatistics().max[i] = max[i];
                 }
                 //if (type != FITS_AUTO && type != FITS_LINEAR)
                 runningAverageStdDev<T>();
@@ -2293,7 +2406,7 @@ bool FITSData::checkForWCS()
         m_WCSHandle = nullptr;
     }
 
-    if (fits_hdr2str(fptr, 1, nullptr, 0, &header, &nkeyrec, &status))
+    if (readHeaderString(fptr, 1, &header, &nkeyrec, &status))
     {
         char errmsg[512];
         fits_get_errstatus(status, errmsg);
@@ -2359,13 +2472,16 @@ bool FITSData::loadWCS(bool extras)
 
     qCDebug(KSTARS_FITS) << "Started WCS Data Processing...";
 
+    m_WCSGrid.clear();
+    m_WCSGridStep = 0;
+
     int status = 0;
     char * header;
     int nkeyrec, nreject, nwcs;
     int w  = width();
     int h = height();
 
-    if (fits_hdr2str(fptr, 1, nullptr, 0, &header, &nkeyrec, &status))
+    if (readHeaderString(fptr, 1, &header, &nkeyrec, &status))
     {
         char errmsg[512];
         fits_get_errstatus(status, errmsg);
@@ -2413,61 +2529,24 @@ bool FITSData::loadWCS(bool extras)
         return false;
     }
 
-    delete[] m_WCSCoordinates;
-
-    m_WCSCoordinates = new FITSImage::wcs_point[w * h];
-
-    if (m_WCSCoordinates == nullptr)
-    {
-        wcsvfree(&m_nwcs, &m_WCSHandle);
-        m_WCSHandle = nullptr;
-        m_LastError = "Not enough memory for WCS data!";
-        m_WCSState = Failure;
-        return false;
-    }
-
     m_WCSState = Busy;
 
     if (extras)
     {
-        const int nThreads = QThread::idealThreadCount();
-        QList<QFuture<void>> futures;
-        // Calculate how many elements we process per thread
-        uint32_t tStride = m_Statistics.samples_per_channel / nThreads;
-        // Calculate the final stride since we can have some left over due to division above
-        uint32_t fStride = tStride + (m_Statistics.samples_per_channel - (tStride * nThreads));
-
-        for (int i = 0; i < nThreads; i++)
-        {
-            uint32_t cStart = i * tStride;
-            uint32_t cEnd = cStart + ((i == (nThreads - 1)) ? fStride : tStride);
-            // Run threads
-            futures.append(QtConcurrent::run([ = ]()
-            {
-                double phi = 0, theta = 0, world[2], pixcrd[2], imgcrd[2];
-                int stat[2];
-                FITSImage::wcs_point *wcsPointer = m_WCSCoordinates + cStart;
-                for (uint32_t i = cStart; i < cEnd; i++)
-                {
-                    uint32_t x = i % w;
-                    uint32_t y = i / w;
-                    pixcrd[0] = x;
-                    pixcrd[1] = y;
-                    if (wcsp2s(m_WCSHandle, 1, 2, &pixcrd[0], &imgcrd[0], &phi, &theta, &world[0], &stat[0]) == 0)
-                    {
-                        wcsPointer->ra  = world[0];
-                        wcsPointer->dec = world[1];
-                    }
-                    wcsPointer++;
-                }
-            }));
-        }
+        // Sample the exact positions on a coarse grid, refined until interpolating it is accurate enough.
+        // A 60 MP frame needs about 60k samples instead of one per pixel.
+        int step = WCS_GRID_STEP;
+        double error = 0;
+        while ((error = buildWCSGrid(step)) > WCS_GRID_MAX_ERROR && step > 1)
+            step /= 2;
 
-        for (auto &oneFuture : futures)
-            oneFuture.waitForFinished();
+        qCDebug(KSTARS_FITS) << "WCS grid step" << step << "pixels, interpolation error" << error << "pixels";
 
-        SkyPoint startPoint(m_WCSCoordinates->ra / 15.0, m_WCSCoordinates->dec);
-        SkyPoint endPoint( (m_WCSCoordinates + w * h - 1)->ra / 15.0, (m_WCSCoordinates + w * h - 1)->dec);
+        FITSImage::wcs_point start, end;
+        getWCSCoord(0, 0, start);
+        getWCSCoord(w - 1, h - 1, end);
+        SkyPoint startPoint(start.ra / 15.0, start.dec);
+        SkyPoint endPoint(end.ra / 15.0, end.dec);
         findObjectsInImage(startPoint, endPoint);
     }
     m_WCSState = Success;
@@ -2482,6 +2561,212 @@ bool FITSData::loadWCS(bool extras)
 #endif
 }
 
+double FITSData::buildWCSGrid(int step)
+{
+#if !defined(KSTARS_LITE) && defined(HAVE_WCSLIB)
+    const int w = width();
+    const int h = height();
+
+    // Nodes are every step pixels, plus the last column and row so the whole image is covered
+    const int columns = (w - 2) / step + 2;
+    const int rows    = (h - 2) / step + 2;
+
+    m_WCSGridStep    = step;
+    m_WCSGridColumns = columns;
+    m_WCSGridRows    = rows;
+    m_WCSGrid.fill(std::numeric_limits<double>::quiet_NaN(), columns * rows * 3);
+
+    double *grid = m_WCSGrid.data();
+
+    auto nodeX = [w, step](int i)
+    {
+        return std::min(i * step, w - 1);
+    };
+    auto nodeY = [h, step](int j)
+    {
+        return std::min(j * step, h - 1);
+    };
+
+    const int nThreads = std::min(QThread::idealThreadCount(), rows);
+    QList<QFuture<void>> futures;
+    QVector<double> bounds(nThreads * 4);
+    QVector<double> errors(nThreads, 0);
+    // Calculate how many rows we process per thread
+    const int tStride = rows / nThreads;
+    // Calculate the final stride since we can have some left over due to division above
+    const int fStride = tStride + (rows - (tStride * nThreads));
+
+    // First pass: exact positions at the nodes
+    for (int i = 0; i < nThreads; i++)
+    {
+        const int cStart = i * tStride;
+        const int cEnd = cStart + ((i == (nThreads - 1)) ? fStride : tStride);
+        futures.append(QtConcurrent::run([ =, &bounds]()
+        {
+            double phi = 0, theta = 0, world[2], pixcrd[2], imgcrd[2];
+            int stat[2];
+            double minRA = 1000, maxRA = -1000, minDec = 1000, maxDec = -1000;
+            for (int row = cStart; row < cEnd; row++)
+            {
+                double *node = grid + row * columns * 3;
+                for (int column = 0; column < columns; column++, node += 3)
+                {
+                    pixcrd[0] = nodeX(column);
+                    pixcrd[1] = nodeY(row);
+                    if (wcsp2s(m_WCSHandle, 1, 2, &pixcrd[0], &imgcrd[0], &phi, &theta, &world[0], &stat[0]) != 0)
+                        continue;
+
+                    minRA  = std::min(minRA, world[0]);
+                    maxRA  = std::max(maxRA, world[0]);
+                    minDec = std::min(minDec, world[1]);
+                    maxDec = std::max(maxDec, world[1]);
+
+                    const double ra = world[0] * dms::DegToRad, dec = world[1] * dms::DegToRad;
+                    node[0] = cos(dec) * cos(ra);
+                    node[1] = cos(dec) * sin(ra);
+                    node[2] = sin(dec);
+                }
+            }
+            bounds[i * 4 + 0] = minRA;
+            bounds[i * 4 + 1] = maxRA;
+            bounds[i * 4 + 2] = minDec;
+            bounds[i * 4 + 3] = maxDec;
+        }));
+    }
+
+    for (auto &oneFuture : futures)
+        oneFuture.waitForFinished();
+    futures.clear();
+
+    m_WCSMinRA = m_WCSMinDec = 1000;
+    m_WCSMaxRA = m_WCSMaxDec = -1000;
+    for (int i = 0; i < nThreads; i++)
+    {
+        m_WCSMinRA  = std::min(m_WCSMinRA, bounds[i * 4 + 0]);
+        m_WCSMaxRA  = std::max(m_WCSMaxRA, bounds[i * 4 + 1]);
+        m_WCSMinDec = std::min(m_WCSMinDec, bounds[i * 4 + 2]);
+        m_WCSMaxDec = std::max(m_WCSMaxDec, bounds[i * 4 + 3]);
+    }
+
+    // Second pass: compare the interpolation with the exact position at the centre of each cell.
+    // The error is converted to pixels with the pixel scale measured along the top of the cell.
+    const int cellRows = rows - 1;
+    const int nCellThreads = std::max(1, std::min(nThreads, cellRows));
+    const int cStride = cellRows / nCellThreads;
+    const int cfStride = cStride + (cellRows - (cStride * nCellThreads));
+    for (int i = 0; i < nCellThreads; i++)
+    {
+        const int cStart = i * cStride;
+        const int cEnd = cStart + ((i == (nCellThreads - 1)) ? cfStride : cStride);
+        futures.append(QtConcurrent::run([ =, &errors]()
+        {
+            double phi = 0, theta = 0, world[2], pixcrd[2], imgcrd[2];
+            int stat[2];
+            double maxError = 0, interpolated[3];
+            for (int row = cStart; row < cEnd; row++)
+            {
+                for (int column = 0; column < columns - 1; column++)
+                {
+                    const int x0 = nodeX(column), x1 = nodeX(column + 1);
+                    const int y0 = nodeY(row), y1 = nodeY(row + 1);
+                    if (x1 - x0 < 2 && y1 - y0 < 2)
+                        continue;
+
+                    pixcrd[0] = (x0 + x1) / 2.0;
+                    pixcrd[1] = (y0 + y1) / 2.0;
+                    if (wcsp2s(m_WCSHandle, 1, 2, &pixcrd[0], &imgcrd[0], &phi, &theta, &world[0], &stat[0]) != 0 ||
+                            interpolateWCS(pixcrd[0], pixcrd[1], interpolated) == false)
+                        continue;
+
+                    const double *a = grid + (row * columns + column) * 3;
+                    const double *b = a + 3;
+                    const double pixelAngle = acos(std::min(1.0, a[0] * b[0] + a[1] * b[1] + a[2] * b[2])) /
+                                              std::max(1, x1 - x0);
+                    if (pixelAngle <= 0)
+                        continue;
+
+                    // Chord between the exact and interpolated unit vectors, converted to an angle
+                    const double ra = world[0] * dms::DegToRad, dec = world[1] * dms::DegToRad;
+                    const double dx = cos(dec) * cos(ra) - interpolated[0];
+                    const double dy = cos(dec) * sin(ra) - interpolated[1];
+                    const double dz = sin(dec) - interpolated[2];
+                    const double angle = 2 * asin(std::min(1.0, sqrt(dx * dx + dy * dy + dz * dz) / 2));
+                    maxError = std::max(maxError, angle / pixelAngle);
+                }
+            }
+            errors[i] = maxError;
+        }));
+    }
+
+    for (auto &oneFuture : futures)
+        oneFuture.waitForFinished();
+
+    return *std::max_element(errors.constBegin(), errors.constEnd());
+#else
+    Q_UNUSED(step);
+    return 0;
+#endif
+}
+
+bool FITSData::interpolateWCS(double x, double y, double v[3]) const
+{
+    if (m_WCSGrid.isEmpty() || x < 0 || y < 0 || x > width() - 1 || y > height() - 1)
+        return false;
+
+    const int step = m_WCSGridStep;
+    const int column = std::min(static_cast<int>(x) / step, m_WCSGridColumns - 2);
+    const int row = std::min(static_cast<int>(y) / step, m_WCSGridRows - 2);
+
+    const double x0 = column * step, x1 = std::min((column + 1) * step, width() - 1);
+    const double y0 = row * step, y1 = std::min((row + 1) * step, height() - 1);
+    const double tx = x1 > x0 ? (x - x0) / (x1 - x0) : 0;
+    const double ty = y1 > y0 ? (y - y0) / (y1 - y0) : 0;
+
+    // Bilinear interpolation of the unit vectors, which has no issue with the RA wrap or the poles
+    const double *n00 = m_WCSGrid.constData() + (row * m_WCSGridColumns + column) * 3;
+    const double *n10 = n00 + 3;
+    const double *n01 = n00 + m_WCSGridColumns * 3;
+    const double *n11 = n01 + 3;
+
+    for (int i = 0; i < 3; i++)
+        v[i] = (1 - ty) * ((1 - tx) * n00[i] + tx * n10[i]) + ty * ((1 - tx) * n01[i] + tx * n11[i]);
+
+    // NaN if one of the nodes could not be computed
+    const double norm = sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+    if (!(norm > 0))
+        return false;
+
+    for (int i = 0; i < 3; i++)
+        v[i] /= norm;
+    return true;
+}
+
+bool FITSData::getWCSCoord(double x, double y, FITSImage::wcs_point &coord) const
+{
+    double v[3];
+    if (interpolateWCS(x, y, v) == false)
+        return false;
+
+    double ra = atan2(v[1], v[0]) / dms::DegToRad;
+    if (ra < 0)
+        ra += 360;
+    coord.ra  = ra;
+    coord.dec = asin(v[2]) / dms::DegToRad;
+    return true;
+}
+
+bool FITSData::getWCSRange(double &minRA, double &maxRA, double &minDec, double &maxDec) const
+{
+    if (m_WCSGrid.isEmpty())
+        return false;
+
+    minRA  = m_WCSMinRA;
+    maxRA  = m_WCSMaxRA;
+    minDec = m_WCSMinDec;
+    maxDec = m_WCSMaxDec;
+    return true;
+}
+
 bool FITSData::wcsToPixel(const SkyPoint &wcsCoord, QPointF &wcsPixelPoint, QPointF &wcsImagePoint)
 {
 #if !defined(KSTARS_LITE) && defined(HAVE_WCSLIB)
@@ -3508,7 +3793,7 @@ double FITSData::getADU() const
 {
     double adu = 0;
     for (int i = 0; i < m_Statistics.channels; i++)
-        adu += m_Statistics.mean[i];
+        adu += fullStatistics().mean[i];
 
     return (adu / static_cast<double>(m_Statistics.channels));
 }
@@ -3603,8 +3888,8 @@ QImage FITSData::FITSToImage(const QString &filename)
         fitsImage = QImage(data.width(), data.height(), QImage::Format_RGB32);
     }
 
-    double dataMin = data.m_Statistics.mean[0] - data.m_Statistics.stddev[0];
-    double dataMax = data.m_Statistics.mean[0] + data.m_Statistics.stddev[0] * 3;
+    double dataMin = data.fullStatistics().mean[0] - data.fullStatistics().stddev[0];
+    double dataMax = data.fullStatistics().mean[0] + data.fullStatistics().stddev[0] * 3;
 
     double bscale = 255. / (dataMax - dataMin);
     double bzero  = (-dataMin) * (255. / (dataMax - dataMin));
@@ -3833,12 +4118,20 @@ bool FITSData::contains(const QPointF &point) const
 
 void FITSData::saveStatistics(FITSImage::Statistic &other)
 {
-    other = m_Statistics;
+    other = fullStatistics();
 }
 
 void FITSData::restoreStatistics(FITSImage::Statistic &other)
 {
-    m_Statistics = other;
+    // The ROI statistics of the detectors are kept, the restored statistics are those of the full frame.
+    QMutexLocker locker(&m_FullStatisticsMutex);
+    if (m_ROIStatistics)
+        m_FullStatistics = other;
+    else
+        m_Statistics = other;
+    m_FullStatisticsPending = false;
+    locker.unlock();
+    m_HistogramPrebinned = false;
 
     emit dataChanged();
 }
@@ -3884,13 +4177,9 @@ void FITSData::constructHistogram()
     }
 }
 
-template <typename T> void FITSData::constructHistogramInternal()
+void FITSData::initHistogramBins(FITSImage::Statistic const &stats)
 {
-    auto * const buffer = reinterpret_cast<T const *>(m_ImageBuffer);
-    uint32_t samples = m_Statistics.width * m_Statistics.height;
-    const uint32_t sampleBy = samples > 500000 ? samples / 500000 : 1;
-
-    m_HistogramBinCount = qMax(0., qMin(m_Statistics.max[0] - m_Statistics.min[0], 256.0));
+    m_HistogramBinCount = qMax(0., qMin(stats.max[0] - stats.min[0], 256.0));
     if (m_HistogramBinCount <= 0)
         m_HistogramBinCount = 256;
 
@@ -3899,32 +4188,51 @@ template <typename T> void FITSData::constructHistogramInternal()
         m_HistogramIntensity[n].fill(0, m_HistogramBinCount + 1);
         m_HistogramFrequency[n].fill(0, m_HistogramBinCount + 1);
         m_CumulativeFrequency[n].fill(0, m_HistogramBinCount + 1);
-        m_HistogramBinWidth[n] = (m_Statistics.max[n] - m_Statistics.min[n]) / (m_HistogramBinCount - 1);
+        m_HistogramBinWidth[n] = (stats.max[n] - stats.min[n]) / (m_HistogramBinCount - 1);
+    }
+}
+
+template <typename T>
+void FITSData::binHistogram(FITSImage::Statistic const &stats, T const *values, uint32_t count, uint32_t stride,
+                            uint32_t weight, int n)
+{
+    for (uint32_t i = 0; i < count; i += stride)
+    {
+        int32_t id = qMax(static_cast<T>(0), qMin(static_cast<T>(m_HistogramBinCount),
+                          static_cast<T>(rint((values[i] - stats.min[n]) / m_HistogramBinWidth[n]))));
+        m_HistogramFrequency[n][id] += weight;
     }
+}
 
+template <typename T> void FITSData::constructHistogramInternal()
+{
+    FITSImage::Statistic const &stats = fullStatistics();
     QVector<QFuture<void>> futures;
 
-    for (int n = 0; n < m_Statistics.channels; n++)
+    // Frequencies are normally binned by calculateStats() from its retained samples.
+    if (!m_HistogramPrebinned)
     {
-        futures.append(QtConcurrent::run([ = ]()
+        auto * const buffer = reinterpret_cast<T const *>(m_ImageBuffer);
+        uint32_t samples = m_Statistics.width * m_Statistics.height;
+        const uint32_t sampleBy = samples > 500000 ? samples / 500000 : 1;
+
+        initHistogramBins(stats);
+
+        for (int n = 0; n < m_Statistics.channels; n++)
         {
-            for (int i = 0; i < m_HistogramBinCount; i++)
-                m_HistogramIntensity[n][i] = m_Statistics.min[n] + (m_HistogramBinWidth[n] * i);
-        }));
+            futures.append(QtConcurrent::run([ =, &stats]()
+            {
+                binHistogram<T>(stats, buffer + n * samples, samples, sampleBy, sampleBy, n);
+            }));
+        }
     }
 
     for (int n = 0; n < m_Statistics.channels; n++)
     {
-        futures.append(QtConcurrent::run([ = ]()
+        futures.append(QtConcurrent::run([ =, &stats]()
         {
-            uint32_t offset = n * samples;
-
-            for (uint32_t i = 0; i < samples; i += sampleBy)
-            {
-                int32_t id = qMax(static_cast<T>(0), qMin(static_cast<T>(m_HistogramBinCount),
-                                  static_cast<T>(rint((buffer[i + offset] - m_Statistics.min[n]) / m_HistogramBinWidth[n]))));
-                m_HistogramFrequency[n][id] += sampleBy;
-            }
+            for (int i = 0; i < m_HistogramBinCount; i++)
+                m_HistogramIntensity[n][i] = stats.min[n] + (m_HistogramBinWidth[n] * i);
         }));
     }
 
@@ -4040,24 +4348,27 @@ void FITSData::recordLastError(int errorCode)
 
 double FITSData::getAverageMean() const
 {
-    if (m_Statistics.channels == 1)
-        return m_Statistics.mean[0];
+    FITSImage::Statistic const &stats = fullStatistics();
+    if (stats.channels == 1)
+        return stats.mean[0];
     else
-        return (m_Statistics.mean[0] + m_Statistics.mean[1] + m_Statistics.mean[2]) / 3.0;
+        return (stats.mean[0] + stats.mean[1] + stats.mean[2]) / 3.0;
 }
 
 double FITSData::getAverageMedian() const
 {
-    if (m_Statistics.channels == 1)
-        return m_Statistics.median[0];
+    FITSImage::Statistic const &stats = fullStatistics();
+    if (stats.channels == 1)
+        return stats.median[0];
     else
-        return (m_Statistics.median[0] + m_Statistics.median[1] + m_Statistics.median[2]) / 3.0;
+        return (stats.median[0] + stats.median[1] + stats.median[2]) / 3.0;
 }
 
 double FITSData::getAverageStdDev() const
 {
-    if (m_Statistics.channels == 1)
-        return m_Statistics.stddev[0];
+    FITSImage::Statistic const &stats = fullStatistics();
+    if (stats.channels == 1)
+        return stats.stddev[0];
     else
-        return (m_Statistics.stddev[0] + m_Statistics.stddev[1] + m_Statistics.stddev[2]) / 3.0;
+        return (stats.stddev[0] + stats.stddev[1] + stats.stddev[2]) / 3.0;
 }
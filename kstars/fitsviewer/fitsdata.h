@@ -42,11 +42,14 @@
 #include <fitsio.h>
 
 #include <QFuture>
+#include <QMutex>
 #include <QObject>
 #include <QRect>
 #include <QVariant>
 #include <QTemporaryFile>
 
+#include <atomic>
+
 #ifndef KSTARS_LITE
 #include <kxmlguiwindow.h>
 #ifdef HAVE_WCSLIB
@@ -155,11 +158,35 @@ class FITSData : public QObject
         void calculateStats(bool refresh = false);
         void saveStatistics(FITSImage::Statistic &other);
         void restoreStatistics(FITSImage::Statistic &other);
+        /**
+         * @brief getStatistics Statistics of the image, as the star detectors use them. If the frame was loaded
+         * with a statistics ROI, min, max, mean, median, stddev and SNR only cover that region. They do not change
+         * when the full-frame statistics, which the value getters below, the histogram and the filters use, are
+         * computed on first use.
+         */
         FITSImage::Statistic const &getStatistics() const
         {
             return m_Statistics;
         };
 
+        /**
+         * @brief setStatisticsROI Only compute the statistics of a region when a focus or guide frame is loaded,
+         * so that the cost of loading a frame is bounded by the region its module uses.
+         * @param roi Region in image pixels, clipped to the image. A null region selects the whole frame.
+         * It is ignored in the other modes.
+         */
+        void setStatisticsROI(const QRect &roi)
+        {
+            m_StatisticsROI = roi;
+        }
+        /**
+         * @brief hasROIStatistics True if getStatistics() only covers the statistics ROI.
+         */
+        bool hasROIStatistics() const
+        {
+            return m_ROIStatistics;
+        }
+
         uint16_t width() const
         {
             return m_Statistics.width;
@@ -186,48 +213,48 @@ class FITSData : public QObject
         }
         double getMin(uint8_t channel = 0) const
         {
-            return m_Statistics.min[channel];
+            return fullStatistics().min[channel];
         }
         double getMax(uint8_t channel = 0) const
         {
-            return m_Statistics.max[channel];
+            return fullStatistics().max[channel];
         }
         void setMinMax(double newMin, double newMax, uint8_t channel = 0);
         void getMinMax(double *min, double *max, uint8_t channel = 0) const
         {
-            *min = m_Statistics.min[channel];
-            *max = m_Statistics.max[channel];
+            *min = fullStatistics().min[channel];
+            *max = fullStatistics().max[channel];
         }
         void setStdDev(double value, uint8_t channel = 0)
         {
-            m_Statistics.stddev[channel] = value;
+            fullStatistics().stddev[channel] = value;
         }
         double getStdDev(uint8_t channel = 0) const
         {
-            return m_Statistics.stddev[channel];
+            return fullStatistics().stddev[channel];
         }
         double getAverageStdDev() const;
         void setMean(double value, uint8_t channel = 0)
         {
-            m_Statistics.mean[channel] = value;
+            fullStatistics().mean[channel] = value;
         }
         double getMean(uint8_t channel = 0) const
         {
-            return m_Statistics.mean[channel];
+            return fullStatistics().mean[channel];
         }
         // for single channel, just return the mean for channel zero
         // for color, return the average
         double getAverageMean() const;
         void setMedian(double val, uint8_t channel = 0)
         {
-            m_Statistics.median[channel] = val;
+            fullStatistics().median[channel] = val;
         }
         // for single channel, just return the median for channel zero
         // for color, return the average
         double getAverageMedian() const;
         double getMedian(uint8_t channel = 0) const
         {
-            return m_Statistics.median[channel];
+            return fullStatistics().median[channel];
         }
 
         int getBytesPerPixel() const
@@ -236,11 +263,11 @@ class FITSData : public QObject
         }
         void setSNR(double val)
         {
-            m_Statistics.SNR = val;
+            fullStatistics().SNR = val;
         }
         double getSNR() const
         {
-            return m_Statistics.SNR;
+            return fullStatistics().SNR;
         }
         uint32_t bpp() const
         {
@@ -394,11 +421,22 @@ class FITSData : public QObject
         {
             return m_WCSState;
         }
-        // Get WCS Coordinates
-        FITSImage::wcs_point *getWCSCoord() const
-        {
-            return m_WCSCoordinates;
-        }
+        /**
+         * @brief getWCSCoord Get the J2000 coordinates of a pixel when the full WCS is loaded.
+         * Exact positions are only computed on a coarse grid, other pixels are interpolated from it.
+         * The grid is refined until the interpolation error is below 0.1 pixel at the centre of each
+         * grid cell, where it is the largest.
+         * @param x X pixel coordinate, between 0 and width() - 1.
+         * @param y Y pixel coordinate, between 0 and height() - 1.
+         * @param coord Store back the RA and DE of the pixel in degrees.
+         * @return True if the pixel position is known, false otherwise.
+         */
+        bool getWCSCoord(double x, double y, FITSImage::wcs_point &coord) const;
+        /**
+         * @brief getWCSRange Get the range of J2000 coordinates covered by the image when the full WCS is loaded.
+         * @return True if the range is known, false otherwise.
+         */
+        bool getWCSRange(double &minRA, double &maxRA, double &minDec, double &maxDec) const;
 
         /**
              * @brief wcsToPixel Given J2000 (RA0,DE0) coordinates. Find in the image the corresponding pixel coordinates.
@@ -589,15 +627,19 @@ class FITSData : public QObject
         // Load Qt-supported images.
         bool loadCanonicalImage(const QByteArray &buffer, const QString &extension, bool silent);
         // Load FITS images.
-        bool loadFITSImage(const QByteArray &buffer, const QString &extension, bool silent);
+        bool loadFITSImage(const QByteArray &buffer, bool silent);
         // Load RAW images.
         bool loadRAWImage(const QByteArray &buffer, const QString &extension, bool silent);
 
         void rotWCSFITS(int angle, int mirror);
-        void calculateMinMax(bool refresh = false);
-        void calculateMedian(bool refresh = false);
+        // Read statistics previously saved in the FITS header, reporting which groups were found.
+        void readStatsFromHeader(FITSImage::Statistic &stats, bool &haveMinMax, bool &haveMedian, bool &haveMeanStdDev);
         bool checkDebayer();
         void readWCSKeys();
+        // Compute the WCS grid with nodes every step pixels, return the largest interpolation error in pixels.
+        double buildWCSGrid(int step);
+        // Interpolate the WCS grid at a pixel, as a unit vector.
+        bool interpolateWCS(double x, double y, double v[3]) const;
 
         // Record last FITS error
         void recordLastError(int errorCode);
@@ -617,13 +659,25 @@ class FITSData : public QObject
         template <typename T>
         void applyFilter(FITSScale type, uint8_t *targetImage, QVector<double> * min = nullptr, QVector<double> * max = nullptr);
 
+        /* Calculate min/max, mean/stddev and the median in a single sweep over each channel.
+         * Mean and standard deviation are exact. The median is taken over every Nth sample
+         * (N = samples / 500000), the same samples the histogram uses, so it may differ from
+         * the exact median by the sampling error of a 500k-sample subset. The histogram
+         * frequencies are binned from those samples as well. */
         template <typename T>
-        void calculateMinMax();
+        void calculateStatsInternal(FITSImage::Statistic &stats, bool minMax, bool median, bool meanStdDev);
+
+        // Full-frame statistics into stats, reading them from the header unless refresh is set.
+        void calculateFullStats(FITSImage::Statistic &stats, bool refresh);
+        // Compute the full-frame statistics if only the statistics ROI was evaluated so far.
+        void ensureFullStatistics() const;
+        // The full-frame statistics: m_Statistics, or m_FullStatistics once computed if m_Statistics covers the ROI.
+        FITSImage::Statistic const &fullStatistics() const;
+        FITSImage::Statistic &fullStatistics();
+        // Statistics of m_StatisticsROI only. Returns false if the region is empty or outside the image.
+        bool calculateROIStats();
         template <typename T>
-        void calculateMedian();
-
-        template <typename T>
-        QPair<T, T> getParitionMinMax(uint32_t start, uint32_t stride);
+        void calculateROIStatsInternal(const QRect &roi);
 
         /* Calculate the Gaussian blur matrix and apply it to the image using the convolution filter */
         QVector<double> createGaussianKernel(int size, double sigma);
@@ -647,6 +701,10 @@ class FITSData : public QObject
         ////////////////////////////////////////////////////////////////////////////////////////
         ////////////////////////////////////////////////////////////////////////////////////////
         template <typename T>  void constructHistogramInternal();
+        void initHistogramBins(FITSImage::Statistic const &stats);
+        template <typename T>
+        void binHistogram(FITSImage::Statistic const &stats, T const *values, uint32_t count, uint32_t stride, uint32_t weight,
+                          int n);
 
         /// Pointer to CFITSIO FITS file struct
         fitsfile *fptr { nullptr };
@@ -683,8 +741,13 @@ class FITSData : public QObject
         /// How many times the image was flipped vertically?
         int flipVCounter { 0 };
 
-        /// Pointer to WCS coordinate data, if any.
-        FITSImage::wcs_point *m_WCSCoordinates { nullptr };
+        /// WCS positions sampled every m_WCSGridStep pixels as unit vectors (x, y, z), row by row.
+        QVector<double> m_WCSGrid;
+        int m_WCSGridStep { 0 };
+        int m_WCSGridColumns { 0 };
+        int m_WCSGridRows { 0 };
+        /// Range of the WCS positions sampled in the grid, in degrees.
+        double m_WCSMinRA { 0 }, m_WCSMaxRA { 0 }, m_WCSMinDec { 0 }, m_WCSMaxDec { 0 };
         /// WCS Struct
         struct wcsprm *m_WCSHandle
         {
@@ -708,6 +771,16 @@ class FITSData : public QObject
         /// 16bit can be either SHORT_IMG or USHORT_IMG, so m_FITSBITPIX specifies which is
         int m_FITSBITPIX {USHORT_IMG};
         FITSImage::Statistic m_Statistics;
+        // Region evaluated when loading focus and guide frames.
+        QRect m_StatisticsROI;
+        // m_Statistics only covers m_StatisticsROI. It is not changed afterwards, as the detectors read it unlocked.
+        bool m_ROIStatistics { false };
+        // Full-frame statistics of a frame with ROI statistics, computed on first use by ensureFullStatistics().
+        mutable FITSImage::Statistic m_FullStatistics;
+        // m_FullStatistics was not computed yet.
+        mutable std::atomic<bool> m_FullStatisticsPending { false };
+        // Serializes the computation of m_FullStatistics.
+        mutable QMutex m_FullStatisticsMutex;
 
         // A list of header records
         QList<Record> m_HeaderRecords;
@@ -736,6 +809,8 @@ class FITSData : public QObject
         uint16_t m_HistogramBinCount { 0 };
         double m_JMIndex { 1 };
         bool m_HistogramConstructed { false };
+        // Frequencies were already binned by calculateStats() for the current buffer and range.
+        bool m_HistogramPrebinned { false };
 
         static const QString m_TemporaryPath;
 };
@@ -167,17 +167,12 @@ void FITSLabel::mouseMoveEvent(QMouseEvent *e)
 
     if (view_data->hasWCS() && view->getCursorMode() != FITSView::selectCursor)
     {
-        int index = x + y * m_Width;
+        FITSImage::wcs_point wcs_coord;
 
-        FITSImage::wcs_point *wcs_coord = view_data->getWCSCoord();
-
-        if (wcs_coord)
+        if (view_data->getWCSCoord(x, y, wcs_coord))
         {
-            if (index > m_Size)
-                return;
-
-            m_RA.setD(wcs_coord[index].ra);
-            m_DE.setD(wcs_coord[index].dec);
+            m_RA.setD(wcs_coord.ra);
+            m_DE.setD(wcs_coord.dec);
 
             emit newStatus(QString("%1 , %2").arg(m_RA.toHMSString(), m_DE.toDMSString()), FITS_WCS);
         }
@@ -231,24 +226,23 @@ void FITSLabel::mousePressEvent(QMouseEvent *e)
         const QSharedPointer<FITSData> &view_data = view->imageData();
         if (view_data->hasWCS())
         {
-            FITSImage::wcs_point *wcs_coord = view_data->getWCSCoord();
-            if (wcs_coord)
+            double x, y;
+            x = round(e->x() / scale);
+            y = round(e->y() / scale);
+
+            x = KSUtils::clamp(x, 0.0, m_Width - 1);
+            y = KSUtils::clamp(y, 0.0, m_Height - 1);
+            FITSImage::wcs_point wcs_coord;
+            if (view_data->getWCSCoord(x, y, wcs_coord))
             {
-                double x, y;
-                x = round(e->x() / scale);
-                y = round(e->y() / scale);
-
-                x         = KSUtils::clamp(x, 1.0, m_Width);
-                y         = KSUtils::clamp(y, 1.0, m_Height);
-                int index = x + y * m_Width;
                 if (KMessageBox::Continue == KMessageBox::warningContinueCancel(
                             nullptr,
-                            "Slewing to Coordinates: \nRA: " + dms(wcs_coord[index].ra).toHMSString() +
-                            "\nDec: " + dms(wcs_coord[index].dec).toDMSString(),
+                            "Slewing to Coordinates: \nRA: " + dms(wcs_coord.ra).toHMSString() +
+                            "\nDec: " + dms(wcs_coord.dec).toDMSString(),
                             i18n("Continue Slew"), KStandardGuiItem::cont(),
                             KStandardGuiItem::cancel(), "continue_slew_warning"))
                 {
-                    centerTelescope(wcs_coord[index].ra / 15.0, wcs_coord[index].dec);
+                    centerTelescope(wcs_coord.ra / 15.0, wcs_coord.dec);
                     view->setCursorMode(view->lastMouseMode);
                     view->updateScopeButton();
                 }
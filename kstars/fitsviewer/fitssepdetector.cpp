@@ -25,16 +25,24 @@
 #include "kspaths.h"
 
 #include <math.h>
-#include <QPointer>
 #include <QtConcurrent>
 
 #ifdef HAVE_STELLARSOLVER
 #include "ekos/auxiliary/stellarsolverprofileeditor.h"
 #include <stellarsolver.h>
-#else
+
+#include <QDateTime>
+#include <QFileInfo>
+#include <QMutex>
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <memory>
+#endif
+
 #include <cstring>
 #include "sep/sep.h"
-#endif
 
 //void FITSSEPDetector::configure(const QString &param, const QVariant &value)
 //{
@@ -60,21 +68,21 @@
 // (e.g. unfiltered number of stars detected,background sky level). Waiting on rlancaste's
 // investigations into SEP before doing this.
 
-QFuture<bool> FITSSEPDetector::findSources(QRect const &boundary)
+#ifdef HAVE_STELLARSOLVER
+namespace
 {
-    return QtConcurrent::run(this, &FITSSEPDetector::findSourcesAndBackground, boundary);
-}
-
-bool FITSSEPDetector::findSourcesAndBackground(QRect const &boundary)
+// Reading the saved option profiles parses an INI file, which is too slow to do for every guide frame.
+// The profiles are kept per group and reloaded only when the file is modified.
+QList<SSolver::Parameters> getOptionsProfiles(Ekos::ProfileGroup group)
 {
-    QList<Edge*> starCenters;
-    SkyBackground skyBG;
-    int maxStarsCount = getValue("maxStarsCount", 100000).toInt();
-#ifdef HAVE_STELLARSOLVER
-    int optionsProfileIndex = getValue("optionsProfileIndex", -1).toInt();
-    Ekos::ProfileGroup group = static_cast<Ekos::ProfileGroup>(getValue("optionsProfileGroup", 1).toInt());
+    struct CachedProfiles
+    {
+        QDateTime lastModified;
+        QList<SSolver::Parameters> profiles;
+    };
+    static QMutex cacheMutex;
+    static QMap<int, CachedProfiles> cache;
 
-    QPointer<StellarSolver> solver = new StellarSolver(m_ImageData->getStatistics(), m_ImageData->getImageBuffer());
     QString filename = "";
     switch(group)
     {
@@ -93,8 +101,17 @@ bool FITSSEPDetector::findSourcesAndBackground(QRect const &boundary)
     }
 
     QString savedOptionsProfiles = KSPaths::writableLocation(QStandardPaths::GenericDataLocation) + filename;
+    QFileInfo savedInfo(savedOptionsProfiles);
+    // Default profiles are cached with an invalid date
+    QDateTime lastModified = savedInfo.exists() ? savedInfo.lastModified() : QDateTime();
+
+    QMutexLocker locker(&cacheMutex);
+    auto cached = cache.constFind(group);
+    if (cached != cache.constEnd() && cached->lastModified == lastModified)
+        return cached->profiles;
+
     QList<SSolver::Parameters> optionsList;
-    if(QFile(savedOptionsProfiles).exists())
+    if(savedInfo.exists())
         optionsList = StellarSolver::loadSavedOptionsProfiles(savedOptionsProfiles);
     else
     {
@@ -114,45 +131,141 @@ bool FITSSEPDetector::findSourcesAndBackground(QRect const &boundary)
                 break;
         }
     }
-    if (optionsProfileIndex >= 0 && optionsList.count() > optionsProfileIndex)
+
+    cache[group] = { lastModified, optionsList };
+    return optionsList;
+}
+
+// Largest value of a FITS data type, used for the saturation filter, or 0 if there is no fixed limit.
+double maxDataTypeValue(uint32_t dataType)
+{
+    switch (dataType)
     {
-        solver->setParameters(optionsList[optionsProfileIndex]);
-        qCDebug(KSTARS_FITS) << "Sextract with: " << optionsList[optionsProfileIndex].listName;
+        case TBYTE:
+            return std::numeric_limits<uint8_t>::max();
+        case TSHORT:
+            return std::numeric_limits<int16_t>::max();
+        case TUSHORT:
+            return std::numeric_limits<uint16_t>::max();
+        case TLONG:
+            return std::numeric_limits<int32_t>::max();
+        case TULONG:
+            return std::numeric_limits<uint32_t>::max();
+        case TLONGLONG:
+            return std::numeric_limits<int64_t>::max();
+        default:
+            return 0;
     }
-    else
-        solver->setParameters(SSolver::Parameters()); // This is default
-    //connect(solver, &StellarSolver::logOutput, Ekos::Manager::Instance()->focusModule(), &Ekos::Focus::appendLogText);
-    //    if(Options::focusLogging())
-    //        solver->setSSLogLevel(SSolver::LOG_NORMAL);
-    //    else
-    //        solver->setSSLogLevel(SSolver::LOG_OFF);
+}
 
-    // Wait synchronously
+// Filter extracted stars with the profile parameters, in the order StellarSolver applies them.
+void applyStarFilters(QList<FITSImage::Star> &stars, SSolver::Parameters const &params, uint32_t dataType)
+{
+    if (params.resort)
+        std::sort(stars.begin(), stars.end(), [](const FITSImage::Star & star1, const FITSImage::Star & star2) -> bool { return star1.mag < star2.mag;});
 
-    QEventLoop loop;
-    connect(solver, &StellarSolver::finished, &loop, &QEventLoop::quit);
-    QList<FITSImage::Star> stars;
-    //    if (!boundary.isNull())
-    //    {
+    if (params.initialKeep > 0 && stars.count() > params.initialKeep)
+        stars.erase(stars.begin() + params.initialKeep, stars.end());
+
+    auto removeIf = [&stars](std::function<bool(FITSImage::Star const &)> predicate)
+    {
+        stars.erase(std::remove_if(stars.begin(), stars.end(), predicate), stars.end());
+    };
+
+    if (params.maxSize > 0)
+        removeIf([&params](FITSImage::Star const & star) { return star.a > params.maxSize || star.b > params.maxSize; });
+    if (params.minSize > 0)
+        removeIf([&params](FITSImage::Star const & star) { return star.a < params.minSize || star.b < params.minSize; });
+    if (params.maxEllipse > 1)
+        removeIf([&params](FITSImage::Star const & star) { return star.b > 0 && star.a / star.b > params.maxEllipse; });
+
+    const double maxValue = maxDataTypeValue(dataType);
+    if (params.saturationLimit > 0 && params.saturationLimit < 100 && maxValue > 0)
+    {
+        const double saturation = maxValue * params.saturationLimit / 100.0;
+        removeIf([saturation](FITSImage::Star const & star) { return star.peak > saturation; });
+    }
+
+    if (params.removeBrightest > 0 && params.removeBrightest < 100)
+        stars.erase(stars.begin(), stars.begin() + static_cast<int>(stars.count() * params.removeBrightest / 100.0));
+    if (params.removeDimmest > 0 && params.removeDimmest < 100)
+        stars.erase(stars.end() - static_cast<int>(stars.count() * params.removeDimmest / 100.0), stars.end());
+
+    if (params.keepNum > 0 && stars.count() > params.keepNum)
+        stars.erase(stars.begin() + params.keepNum, stars.end());
+}
+}
+#endif
+
+QFuture<bool> FITSSEPDetector::findSources(QRect const &boundary)
+{
+    return QtConcurrent::run(this, &FITSSEPDetector::findSourcesAndBackground, boundary);
+}
+
+bool FITSSEPDetector::findSourcesAndBackground(QRect const &boundary)
+{
+    QList<Edge*> starCenters;
+    SkyBackground skyBG;
+    int maxStarsCount = getValue("maxStarsCount", 100000).toInt();
+#ifdef HAVE_STELLARSOLVER
+    int optionsProfileIndex = getValue("optionsProfileIndex", -1).toInt();
+    Ekos::ProfileGroup group = static_cast<Ekos::ProfileGroup>(getValue("optionsProfileGroup", 1).toInt());
+
+    SSolver::Parameters params; // This is default
+    const QList<SSolver::Parameters> optionsList = getOptionsProfiles(group);
+    if (optionsProfileIndex >= 0 && optionsList.count() > optionsProfileIndex)
+    {
+        params = optionsList[optionsProfileIndex];
+        qCDebug(KSTARS_FITS) << "Sextract with: " << params.listName;
+    }
 
     const bool runHFR = group != Ekos::AlignProfiles;
-    solver->extract(runHFR, boundary);
-    loop.exec(QEventLoop::ExcludeUserInputEvents);
-    stars = solver->getStarList();
-    //    }
-
-    //    if (stars.empty())
-    //    {
-    //        solver->extract(true);
-    //        loop.exec();
-    //        stars = solver->getStarList();
-    //    }
+    QList<FITSImage::Star> stars;
+    FITSImage::Background bg;
+
+    if (group == Ekos::GuideProfiles && !boundary.isNull())
+    {
+        // The guider extracts the small tracking box of every guide frame. The bundled SEP does that directly with
+        // the guide profile, instead of building a StellarSolver for each frame and waiting for it in a nested event loop.
+        if (!extractWithProfile(params, boundary, runHFR, stars, bg))
+            return false;
+    }
+    else
+    {
+        // The solver is only needed for this extraction
+        std::unique_ptr<StellarSolver> solver(new StellarSolver(m_ImageData->getStatistics(), m_ImageData->getImageBuffer()));
+        solver->setParameters(params);
+        //connect(solver, &StellarSolver::logOutput, Ekos::Manager::Instance()->focusModule(), &Ekos::Focus::appendLogText);
+        //    if(Options::focusLogging())
+        //        solver->setSSLogLevel(SSolver::LOG_NORMAL);
+        //    else
+        //        solver->setSSLogLevel(SSolver::LOG_OFF);
+
+        // Wait synchronously
+
+        QEventLoop loop;
+        connect(solver.get(), &StellarSolver::finished, &loop, &QEventLoop::quit);
+        //    if (!boundary.isNull())
+        //    {
+
+        solver->extract(runHFR, boundary);
+        loop.exec(QEventLoop::ExcludeUserInputEvents);
+        stars = solver->getStarList();
+        //    }
+
+        //    if (stars.empty())
+        //    {
+        //        solver->extract(true);
+        //        loop.exec();
+        //        stars = solver->getStarList();
+        //    }
+
+        bg = solver->getBackground();
+    }
 
     if (stars.empty())
         return false;
 
-    auto bg = solver->getBackground();
-
     skyBG.mean = bg.global;
     skyBG.sigma = bg.globalrms;
     skyBG.numPixelsInSkyEstimate = bg.bw * bg.bh;
@@ -192,8 +305,20 @@ bool FITSSEPDetector::findSourcesAndBackground(QRect const &boundary)
         starCenters.append(oneEdge);
     }
     m_ImageData->setStarCenters(starCenters);
-
+    return true;
 #else
+    Q_UNUSED(starCenters);
+    Q_UNUSED(skyBG);
+    Q_UNUSED(maxStarsCount);
+    return findSourcesWithSEP(boundary);
+#endif
+}
+
+bool FITSSEPDetector::findSourcesWithSEP(QRect const &boundary)
+{
+    QList<Edge*> starCenters;
+    SkyBackground skyBG;
+    int maxStarsCount = getValue("maxStarsCount", 100000).toInt();
 
     FITSImage::Statistic const &stats = m_ImageData->getStatistics();
 
@@ -215,41 +340,9 @@ bool FITSSEPDetector::findSourcesAndBackground(QRect const &boundary)
             maxRadius = w;
     }
 
-    auto * data = new float[w * h];
-
-    switch (stats.dataType)
-    {
-        case TBYTE:
-            getFloatBuffer<uint8_t>(data, x, y, w, h, m_ImageData);
-            break;
-        case TSHORT:
-            getFloatBuffer<int16_t>(data, x, y, w, h, m_ImageData);
-            break;
-        case TUSHORT:
-            getFloatBuffer<uint16_t>(data, x, y, w, h, m_ImageData);
-            break;
-        case TLONG:
-            getFloatBuffer<int32_t>(data, x, y, w, h, m_ImageData);
-            break;
-        case TULONG:
-            getFloatBuffer<uint32_t>(data, x, y, w, h, m_ImageData);
-            break;
-        case TFLOAT:
-            if (boundary.isNull())
-                memcpy(data, m_ImageData->getImageBuffer(), sizeof(float)*w * h);
-            else
-                getFloatBuffer<float>(data, x, y, w, h, m_ImageData);
-            break;
-        case TLONGLONG:
-            getFloatBuffer<int64_t>(data, x, y, w, h, m_ImageData);
-            break;
-        case TDOUBLE:
-            getFloatBuffer<double>(data, x, y, w, h, m_ImageData);
-            break;
-        default:
-            delete [] data;
-            return -1;
-    }
+    auto * data = createFloatBuffer(x, y, w, h);
+    if (data == nullptr)
+        return false;
 
     float * imback = nullptr;
     double * flux = nullptr, *fluxerr = nullptr, *area = nullptr;
@@ -388,10 +481,108 @@ bool FITSSEPDetector::findSourcesAndBackground(QRect const &boundary)
     m_ImageData->setSkyBackground(skyBG);
 
     cleanup();
-#endif
     return true;
 }
 
+#ifdef HAVE_STELLARSOLVER
+bool FITSSEPDetector::extractWithProfile(SSolver::Parameters const &params, QRect const &boundary, bool calculateHFR,
+        QList<FITSImage::Star> &stars, FITSImage::Background &background)
+{
+    const int x = boundary.x(), y = boundary.y(), w = boundary.width(), h = boundary.height();
+    const int maxRadius = getValue("radiusIsBoundary", true).toBool() ? w : 50;
+
+    auto * data = createFloatBuffer(x, y, w, h);
+    if (data == nullptr)
+        return false;
+
+    int status = 0;
+    sep_bkg * bkg = nullptr;
+    sep_catalog * catalog = nullptr;
+    std::vector<float> conv(params.convFilter.begin(), params.convFilter.end());
+    const int convSize = static_cast<int>(sqrt(conv.size()));
+
+    auto cleanup = [ & ]()
+    {
+        delete[] data;
+        sep_bkg_free(bkg);
+        sep_catalog_free(catalog);
+
+        if (status != 0)
+        {
+            char errorMessage[512];
+            sep_get_errmsg(status, errorMessage);
+            qCritical(KSTARS_FITS) << errorMessage;
+        }
+    };
+
+    sep_image im = {data, nullptr, nullptr, SEP_TFLOAT, 0, 0, w, h, 0.0, SEP_NOISE_NONE, 1.0, 0.0};
+
+    status = sep_background(&im, 64, 64, 3, 3, 0.0, &bkg);
+    if (status == 0)
+        status = sep_bkg_subarray(bkg, im.data, im.dtype);
+    // StellarSolver detects at twice the global background RMS
+    if (status == 0)
+        status = sep_extract(&im, 2 * bkg->globalrms, SEP_THRESH_ABS, static_cast<int>(params.minarea), conv.empty() ? nullptr : conv.data(),
+                             convSize, convSize, SEP_FILTER_CONV, params.deblend_thresh, params.deblend_contrast,
+                             params.clean, params.clean_param, &catalog);
+    if (status != 0)
+    {
+        cleanup();
+        return false;
+    }
+
+    background.bw = bkg->bw;
+    background.bh = bkg->bh;
+    background.global = bkg->global;
+    background.globalrms = bkg->globalrms;
+    background.num_stars_detected = catalog->nobj;
+
+    stars.clear();
+    stars.reserve(catalog->nobj);
+    for (int i = 0; i < catalog->nobj; i++)
+    {
+        const double xPos = catalog->x[i], yPos = catalog->y[i];
+        const double a = catalog->a[i], b = catalog->b[i], theta = catalog->theta[i];
+        double kronrad = 0, sum = 0, sumerr = 0, area = 0;
+        short flag = 0;
+
+        // Photometry follows the aperture shape of the profile, with a circle of r_min for small Kron apertures
+        sep_kron_radius(&im, xPos, yPos, catalog->cxx[i], catalog->cyy[i], catalog->cxy[i], 6, &kronrad, &flag);
+        bool useCircle = params.apertureShape == SSolver::SHAPE_CIRCLE;
+        if (params.apertureShape == SSolver::SHAPE_AUTO)
+            useCircle = kronrad * sqrt(a * b) < params.r_min;
+        if (useCircle)
+            sep_sum_circle(&im, xPos, yPos, params.r_min, params.subpix, params.inflags, &sum, &sumerr, &area, &flag);
+        else
+            sep_sum_ellipse(&im, xPos, yPos, a, b, theta, params.kron_fact * kronrad, params.subpix, params.inflags,
+                            &sum, &sumerr, &area, &flag);
+        if (sum <= 0)
+            continue;
+
+        double hfr = 0;
+        if (calculateHFR)
+        {
+            double requested_frac = 0.5;
+            short flux_flag = 0;
+            sep_flux_radius(&im, xPos, yPos, maxRadius, params.subpix, 0, &sum, &requested_frac, 1, &hfr, &flux_flag);
+        }
+
+        FITSImage::Star star = { static_cast<float>(xPos + x), static_cast<float>(yPos + y),
+                                 static_cast<float>(params.magzero - 2.5 * log10(sum)), static_cast<float>(sum),
+                                 catalog->peak[i], static_cast<float>(hfr), static_cast<float>(a), static_cast<float>(b),
+                                 static_cast<float>(theta * 180.0 / M_PI), 0, 0, catalog->npix[i]
+                               };
+        stars.append(star);
+    }
+
+    applyStarFilters(stars, params, m_ImageData->getStatistics().dataType);
+
+    qCDebug(KSTARS_FITS) << "SEP detected" << catalog->nobj << "stars, kept" << stars.count() << "with" << params.listName;
+    cleanup();
+    return true;
+}
+#endif
+
 template <typename T>
 void FITSSEPDetector::getFloatBuffer(float * buffer, int x, int y, int w, int h, FITSData const *data) const
 {
@@ -417,6 +608,48 @@ void FITSSEPDetector::getFloatBuffer(float * buffer, int x, int y, int w, int h,
     }
 }
 
+float * FITSSEPDetector::createFloatBuffer(int x, int y, int w, int h) const
+{
+    FITSImage::Statistic const &stats = m_ImageData->getStatistics();
+    auto * data = new float[w * h];
+
+    switch (stats.dataType)
+    {
+        case TBYTE:
+            getFloatBuffer<uint8_t>(data, x, y, w, h, m_ImageData);
+            break;
+        case TSHORT:
+            getFloatBuffer<int16_t>(data, x, y, w, h, m_ImageData);
+            break;
+        case TUSHORT:
+            getFloatBuffer<uint16_t>(data, x, y, w, h, m_ImageData);
+            break;
+        case TLONG:
+            getFloatBuffer<int32_t>(data, x, y, w, h, m_ImageData);
+            break;
+        case TULONG:
+            getFloatBuffer<uint32_t>(data, x, y, w, h, m_ImageData);
+            break;
+        case TFLOAT:
+            if (w == stats.width && h == stats.height)
+                memcpy(data, m_ImageData->getImageBuffer(), sizeof(float)*w * h);
+            else
+                getFloatBuffer<float>(data, x, y, w, h, m_ImageData);
+            break;
+        case TLONGLONG:
+            getFloatBuffer<int64_t>(data, x, y, w, h, m_ImageData);
+            break;
+        case TDOUBLE:
+            getFloatBuffer<double>(data, x, y, w, h, m_ImageData);
+            break;
+        default:
+            delete [] data;
+            return nullptr;
+    }
+
+    return data;
+}
+
 SkyBackground::SkyBackground(double mean_, double sigma_, double numPixels_)
 {
     initialize(mean_, sigma_, numPixels_);
@@ -19,9 +19,14 @@
 
 #pragma once
 
+#include "config-kstars.h"
 #include "fitsstardetector.h"
 #include "skybackground.h"
 
+#ifdef HAVE_STELLARSOLVER
+#include <parameters.h>
+#endif
+
 class FITSSEPDetector : public FITSStarDetector
 {
         Q_OBJECT
@@ -48,6 +53,24 @@ class FITSSEPDetector : public FITSStarDetector
         void getFloatBuffer(float * buffer, int x, int y, int w, int h, FITSData const * image_data) const;
 
     private:
+        /** @internal Find sources with the bundled SEP library, in the calling thread.
+         * This is used for guide tracking boxes, and for all extractions when StellarSolver is not available.
+         */
+        bool findSourcesWithSEP(QRect const &boundary);
+
+#ifdef HAVE_STELLARSOLVER
+        /** @internal Extract sources in the calling thread with the bundled SEP library, using the extraction
+         * and filter parameters of a StellarSolver profile the same way StellarSolver does.
+         * This is used for guide tracking boxes, to avoid building a StellarSolver for every guide frame.
+         */
+        bool extractWithProfile(SSolver::Parameters const &params, QRect const &boundary, bool calculateHFR,
+                                QList<FITSImage::Star> &stars, FITSImage::Background &background);
+#endif
+
+        /** @internal Copy the (x,y)-(x+w,y+h) sub-frame of the FITS data to a new float block.
+         * @return the block, to be deleted by the caller, or nullptr if the data type is not supported.
+         */
+        float * createFloatBuffer(int x, int y, int w, int h) const;
 
         void clearSolver();
 
@@ -1373,33 +1373,11 @@ to draw gridlines at those specific RA and Dec values.
 
 void FITSView::drawEQGrid(QPainter * painter, double scale)
 {
-    const int image_width = m_ImageData->width();
-    const int image_height = m_ImageData->height();
-
     if (m_ImageData->hasWCS() && m_ImageData->fullWCS())
     {
-        FITSImage::wcs_point * wcs_coord = m_ImageData->getWCSCoord();
-        if (wcs_coord != nullptr)
+        double maxRA, minRA, maxDec, minDec;
+        if (m_ImageData->getWCSRange(minRA, maxRA, minDec, maxDec))
         {
-            const int size      = image_width * image_height;
-            double maxRA  = -1000;
-            double minRA  = 1000;
-            double maxDec = -1000;
-            double minDec = 1000;
-
-            for (int i = 0; i < (size); i++)
-            {
-                double ra  = wcs_coord[i].ra;
-                double dec = wcs_coord[i].dec;
-                if (ra > maxRA)
-                    maxRA = ra;
-                if (ra < minRA)
-                    minRA = ra;
-                if (dec > maxDec)
-                    maxDec = dec;
-                if (dec < minDec)
-                    minDec = dec;
-            }
             auto minDecMinutes = (int)(minDec * 12); //This will force the Dec Scale to 5 arc minutes in the loop
             auto maxDecMinutes = (int)(maxDec * 12);
 
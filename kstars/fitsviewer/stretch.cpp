@@ -10,6 +10,9 @@
 
 #include <fitsio.h>
 #include <math.h>
+#include <algorithm>
+#include <limits>
+#include <type_traits>
 #include <QtConcurrent>
 
 namespace
@@ -48,6 +51,108 @@ T median(T const *values, int size, int sampleBy)
     return median(samples);
 }
 
+// Runs processRows(startRow, endRow) over contiguous bands of output rows, one band per
+// thread, and blocks until all bands are done. Submitting one task per row spends a
+// measurable share of the stretch in thread-pool overhead on large frames.
+template <typename Function>
+void runOnRowBands(int outputHeight, Function processRows)
+{
+    const int nThreads = std::max(1, std::min(QThread::idealThreadCount(), outputHeight));
+    QVector<QFuture<void>> futures;
+    // Calculate how many rows we process per thread
+    const int tStride = outputHeight / nThreads;
+    // Calculate the final stride since we can have some left over due to division above
+    const int fStride = tStride + (outputHeight - (tStride * nThreads));
+
+    for (int i = 0; i < nThreads; i++)
+    {
+        const int cStart = i * tStride;
+        const int cEnd = cStart + ((i == (nThreads - 1)) ? fStride : tStride);
+        futures.append(QtConcurrent::run([ = ]()
+        {
+            processRows(cStart, cEnd);
+        }));
+    }
+    for (auto &oneFuture : futures)
+        oneFuture.waitForFinished();
+}
+
+// Per-channel stretch constants, precomputed once per run.
+template <typename T>
+struct ChannelStretch
+{
+    ChannelStretch(const StretchParams1Channel &params, float maxInput)
+    {
+        midtones = params.midtones;
+        // highlights - shadows, protecting for divide-by-0, in a 0->1.0 scale.
+        const float hsRangeFactor = params.highlights == params.shadows ?
+                                    1.0f : 1.0f / (params.highlights - params.shadows);
+        // Shadow and highlight values translated to the ADU scale.
+        nativeShadows = params.shadows * maxInput;
+        nativeHighlights = params.highlights * maxInput;
+        // Constants based on above needed for the stretch calculations.
+        k1 = (midtones - 1) * hsRangeFactor * maxOutput / maxInput;
+        k2 = ((2 * midtones) - 1) * hsRangeFactor / maxInput;
+    }
+
+    // Based on the spec in section 8.5.6
+    // https://pixinsight.com/doc/docs/XISF-1.0-spec/XISF-1.0-spec.html
+    inline uint8_t apply(T input) const
+    {
+        if (input < nativeShadows) return 0;
+        else if (input >= nativeHighlights) return maxOutput;
+        const T inputFloored = (input - nativeShadows);
+        return (inputFloored * k1) / (inputFloored * k2 - midtones);
+    }
+
+    // We're outputting uint8, so the max output is 255.
+    static constexpr int maxOutput = 255;
+    float midtones;
+    T nativeShadows;
+    T nativeHighlights;
+    float k1;
+    float k2;
+};
+
+// For 8 and 16-bit integer samples there are at most 64K distinct inputs, so the stretch
+// is tabulated once and every pixel becomes a single lookup. The table is filled with the
+// same expression as ChannelStretch::apply(), so the output is identical.
+template <typename T, bool useTable = std::is_integral<T>::value && (sizeof(T) <= 2)>
+class ChannelLookup
+{
+    public:
+        explicit ChannelLookup(const ChannelStretch<T> &stretch) : m_Stretch(stretch) {}
+        inline uint8_t operator()(T input) const
+        {
+            return m_Stretch.apply(input);
+        }
+    private:
+        ChannelStretch<T> m_Stretch;
+};
+
+template <typename T>
+class ChannelLookup<T, true>
+{
+    public:
+        typedef typename std::make_unsigned<T>::type Index;
+
+        explicit ChannelLookup(const ChannelStretch<T> &stretch)
+            : m_Table(std::numeric_limits<Index>::max() + 1)
+        {
+            for (uint32_t i = 0; i < m_Table.size(); i++)
+            {
+                const T input = static_cast<T>(static_cast<Index>(i));
+                m_Table[i] = stretch.apply(input);
+            }
+        }
+        inline uint8_t operator()(T input) const
+        {
+            return m_Table[static_cast<Index>(input)];
+        }
+    private:
+        std::vector<uint8_t> m_Table;
+};
+
 // This stretches one channel given the input parameters.
 // Based on the spec in section 8.5.6
 // https://pixinsight.com/doc/docs/XISF-1.0-spec/XISF-1.0-spec.html
@@ -60,57 +165,40 @@ void stretchOneChannel(T *input_buffer, QImage *output_image,
                        const StretchParams &stretch_params,
                        int input_range, int image_height, int image_width, int sampling)
 {
-    QVector<QFuture<void>> futures;
-
-    // We're outputting uint8, so the max output is 255.
-    constexpr int maxOutput = 255;
+    typedef typename std::remove_const<T>::type Sample;
 
     // Maximum possible input value (e.g. 1024*64 - 1 for a 16 bit unsigned int).
     const float maxInput = input_range > 1 ? input_range - 1 : input_range;
 
-    const float midtones   = stretch_params.grey_red.midtones;
-    const float highlights = stretch_params.grey_red.highlights;
-    const float shadows    = stretch_params.grey_red.shadows;
-
-    // Precomputed expressions moved out of the loop.
-    // highlights - shadows, protecting for divide-by-0, in a 0->1.0 scale.
-    const float hsRangeFactor = highlights == shadows ? 1.0f : 1.0f / (highlights - shadows);
-    // Shadow and highlight values translated to the ADU scale.
-    const T nativeShadows = shadows * maxInput;
-    const T nativeHighlights = highlights * maxInput;
-    // Constants based on above needed for the stretch calculations.
-    const float k1 = (midtones - 1) * hsRangeFactor * maxOutput / maxInput;
-    const float k2 = ((2 * midtones) - 1) * hsRangeFactor / maxInput;
-
-    // Increment the input index by the sampling, the output index increments by 1.
-    for (int j = 0, jout = 0; j < image_height; j += sampling, jout++)
+    const ChannelLookup<Sample> stretch(ChannelStretch<Sample>(stretch_params.grey_red, maxInput));
+
+    const int outputHeight = (image_height + sampling - 1) / sampling;
+
+    runOnRowBands(outputHeight, [&](int startRow, int endRow)
     {
-        futures.append(QtConcurrent::run([ = ]()
+        // Increment the input index by the sampling, the output index increments by 1.
+        for (int jout = startRow, j = startRow * sampling; jout < endRow; j += sampling, jout++)
         {
             T * inputLine  = input_buffer + j * image_width;
             auto * scanLine = output_image->scanLine(jout);
 
-            for (int i = 0, iout = 0; i < image_width; i += sampling, iout++)
+            if (sampling == 1)
             {
-                const T input = inputLine[i];
-                if (input < nativeShadows) scanLine[iout] = 0;
-                else if (input >= nativeHighlights) scanLine[iout] = maxOutput;
-                else
-                {
-                    const T inputFloored = (input - nativeShadows);
-                    scanLine[iout] = (inputFloored * k1) / (inputFloored * k2 - midtones);
-                }
+                for (int i = 0; i < image_width; i++)
+                    scanLine[i] = stretch(inputLine[i]);
             }
-        }));
-    }
-    for(QFuture<void> future : futures)
-        future.waitForFinished();
+            else
+            {
+                for (int i = 0, iout = 0; i < image_width; i += sampling, iout++)
+                    scanLine[iout] = stretch(inputLine[i]);
+            }
+        }
+    });
 }
 
 // This is like the above 1-channel stretch, but extended for 3 channels.
-// This could have been more modular, but the three channels are combined
-// into a single qRgb value at the end, so it seems the simplest thing is to
-// replicate the code. It is assume the colors are not interleaved--the red image
+// The three channels are combined into a single qRgb value at the end.
+// It is assume the colors are not interleaved--the red image
 // is stored fully, then the green, then the blue.
 // Sampling is applied to the output (that is, with sampling=2, we compute every other output
 // sample both in width and height, so the output would have about 4X fewer pixels.
@@ -119,49 +207,21 @@ void stretchThreeChannels(T *inputBuffer, QImage *outputImage,
                           const StretchParams &stretchParams,
                           int inputRange, int imageHeight, int imageWidth, int sampling)
 {
-    QVector<QFuture<void>> futures;
-
-    // We're outputting uint8, so the max output is 255.
-    constexpr int maxOutput = 255;
+    typedef typename std::remove_const<T>::type Sample;
 
     // Maximum possible input value (e.g. 1024*64 - 1 for a 16 bit unsigned int).
     const float maxInput = inputRange > 1 ? inputRange - 1 : inputRange;
 
-    const float midtonesR   = stretchParams.grey_red.midtones;
-    const float highlightsR = stretchParams.grey_red.highlights;
-    const float shadowsR    = stretchParams.grey_red.shadows;
-    const float midtonesG   = stretchParams.green.midtones;
-    const float highlightsG = stretchParams.green.highlights;
-    const float shadowsG    = stretchParams.green.shadows;
-    const float midtonesB   = stretchParams.blue.midtones;
-    const float highlightsB = stretchParams.blue.highlights;
-    const float shadowsB    = stretchParams.blue.shadows;
-
-    // Precomputed expressions moved out of the loop.
-    // highlights - shadows, protecting for divide-by-0, in a 0->1.0 scale.
-    const float hsRangeFactorR = highlightsR == shadowsR ? 1.0f : 1.0f / (highlightsR - shadowsR);
-    const float hsRangeFactorG = highlightsG == shadowsG ? 1.0f : 1.0f / (highlightsG - shadowsG);
-    const float hsRangeFactorB = highlightsB == shadowsB ? 1.0f : 1.0f / (highlightsB - shadowsB);
-    // Shadow and highlight values translated to the ADU scale.
-    const T nativeShadowsR = shadowsR * maxInput;
-    const T nativeShadowsG = shadowsG * maxInput;
-    const T nativeShadowsB = shadowsB * maxInput;
-    const T nativeHighlightsR = highlightsR * maxInput;
-    const T nativeHighlightsG = highlightsG * maxInput;
-    const T nativeHighlightsB = highlightsB * maxInput;
-    // Constants based on above needed for the stretch calculations.
-    const float k1R = (midtonesR - 1) * hsRangeFactorR * maxOutput / maxInput;
-    const float k1G = (midtonesG - 1) * hsRangeFactorG * maxOutput / maxInput;
-    const float k1B = (midtonesB - 1) * hsRangeFactorB * maxOutput / maxInput;
-    const float k2R = ((2 * midtonesR) - 1) * hsRangeFactorR / maxInput;
-    const float k2G = ((2 * midtonesG) - 1) * hsRangeFactorG / maxInput;
-    const float k2B = ((2 * midtonesB) - 1) * hsRangeFactorB / maxInput;
+    const ChannelLookup<Sample> stretchR(ChannelStretch<Sample>(stretchParams.grey_red, maxInput));
+    const ChannelLookup<Sample> stretchG(ChannelStretch<Sample>(stretchParams.green, maxInput));
+    const ChannelLookup<Sample> stretchB(ChannelStretch<Sample>(stretchParams.blue, maxInput));
 
     const int size = imageWidth * imageHeight;
+    const int outputHeight = (imageHeight + sampling - 1) / sampling;
 
-    for (int j = 0, jout = 0; j < imageHeight; j += sampling, jout++)
+    runOnRowBands(outputHeight, [&](int startRow, int endRow)
     {
-        futures.append(QtConcurrent::run([ = ]()
+        for (int jout = startRow, j = startRow * sampling; jout < endRow; j += sampling, jout++)
         {
             // R, G, B input images are stored one after another.
             T * inputLineR  = inputBuffer + j * imageWidth;
@@ -171,42 +231,9 @@ void stretchThreeChannels(T *inputBuffer, QImage *outputImage,
             auto * scanLine = reinterpret_cast<QRgb*>(outputImage->scanLine(jout));
 
             for (int i = 0, iout = 0; i < imageWidth; i += sampling, iout++)
-            {
-                const T inputR = inputLineR[i];
-                const T inputG = inputLineG[i];
-                const T inputB = inputLineB[i];
-
-                uint8_t red, green, blue;
-
-                if (inputR < nativeShadowsR) red = 0;
-                else if (inputR >= nativeHighlightsR) red = maxOutput;
-                else
-                {
-                    const T inputFloored = (inputR - nativeShadowsR);
-                    red = (inputFloored * k1R) / (inputFloored * k2R - midtonesR);
-                }
-
-                if (inputG < nativeShadowsG) green = 0;
-                else if (inputG >= nativeHighlightsG) green = maxOutput;
-                else
-                {
-                    const T inputFloored = (inputG - nativeShadowsG);
-                    green = (inputFloored * k1G) / (inputFloored * k2G - midtonesG);
-                }
-
-                if (inputB < nativeShadowsB) blue = 0;
-                else if (inputB >= nativeHighlightsB) blue = maxOutput;
-                else
-                {
-                    const T inputFloored = (inputB - nativeShadowsB);
-                    blue = (inputFloored * k1B) / (inputFloored * k2B - midtonesB);
-                }
-                scanLine[iout] = qRgb(red, green, blue);
-            }
-        }));
-    }
-    for(QFuture<void> future : futures)
-        future.waitForFinished();
+                scanLine[iout] = qRgb(stretchR(inputLineR[i]), stretchG(inputLineG[i]), stretchB(inputLineB[i]));
+        }
+    });
 }
 
 template <typename T>
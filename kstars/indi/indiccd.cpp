@@ -21,6 +21,7 @@
 #include "kstarsdata.h"
 #include "Options.h"
 #include "streamwg.h"
+#include "ekos/capture/capturefileindex.h"
 //#include "ekos/manager.h"
 #ifdef HAVE_CFITSIO
 #include "fitsviewer/fitsdata.h"
@@ -44,8 +45,10 @@ const QString &getFITSModeStringString(FITSMode mode)
 namespace
 {
 // Internal function to write an image blob to disk.
-bool WriteImageFileInternal(const QString &filename, char *buffer, const size_t size)
+bool WriteImageFileInternal(const QString &filename, const QByteArray &buffer)
 {
+    const char *data = buffer.constData();
+    const size_t size = buffer.size();
     QFile file(filename);
     if (!file.open(QIODevice::WriteOnly))
     {
@@ -56,7 +59,7 @@ bool WriteImageFileInternal(const QString &filename, char *buffer, const size_t
     size_t n = 0;
     QDataStream out(&file);
     for (size_t nr = 0; nr < size; nr += n)
-        n = out.writeRawData(buffer + nr, size - nr);
+        n = out.writeRawData(data + nr, size - nr);
     file.flush();
     file.close();
     file.setPermissions(QFileDevice::ReadUser |
@@ -65,6 +68,66 @@ bool WriteImageFileInternal(const QString &filename, char *buffer, const size_t
                         QFileDevice::ReadOther);
     return true;
 }
+
+// Internal function to write a FITS blob to disk as a tile compressed image (.fits.fz).
+// Integer images are compressed losslessly with Rice, floating point images with GZIP without quantization.
+// If compression fails, the blob is written uncompressed without the .fz extension so the frame is not lost.
+// Returns the name of the file written, or an empty string if nothing could be written.
+QString WriteCompressedImageFileInternal(const QString &filename, const QByteArray &buffer)
+{
+    int status = 0, bitpix = 0;
+    fitsfile *inputFITS = nullptr, *outputFITS = nullptr;
+    void *data = const_cast<char *>(buffer.constData());
+    size_t size = buffer.size();
+
+    // The file was already created by generateFilename()
+    const QString directory = QFileInfo(filename).absolutePath();
+    const QDateTime directoryModified = QFileInfo(directory).lastModified();
+    QFile::remove(filename);
+
+    if (fits_open_memfile(&inputFITS, "", READONLY, &data, &size, 0, nullptr, &status) == 0 &&
+            fits_get_img_type(inputFITS, &bitpix, &status) == 0 &&
+            fits_create_diskfile(&outputFITS, filename.toLocal8Bit().data(), &status) == 0)
+    {
+        if (bitpix < 0)
+        {
+            fits_set_compression_type(outputFITS, GZIP_2, &status);
+            fits_set_quantize_level(outputFITS, 0, &status);
+        }
+        else
+            fits_set_compression_type(outputFITS, RICE_1, &status);
+
+        fits_img_compress(inputFITS, outputFITS, &status);
+    }
+
+    // Closing flushes the compressed image, so its status is part of the result
+    if (outputFITS)
+        fits_close_file(outputFITS, &status);
+    int inputStatus = 0;
+    if (inputFITS)
+        fits_close_file(inputFITS, &inputStatus);
+
+    if (status)
+    {
+        char errorMessage[512];
+        fits_get_errstatus(status, errorMessage);
+        qCCritical(KSTARS_INDI) << "ISD:CCD Error: Unable to compress" << filename << ":" << errorMessage;
+        QFile::remove(filename);
+        QString uncompressedFilename = filename;
+        uncompressedFilename.chop(3);
+        Ekos::CaptureFileIndex::Instance()->invalidate(directory);
+        return WriteImageFileInternal(uncompressedFilename, buffer) ? uncompressedFilename : QString();
+    }
+
+    // Recreating the file changed the directory, let the capture file index know it was only this file
+    Ekos::CaptureFileIndex::Instance()->add(filename, directoryModified);
+
+    QFile::setPermissions(filename, QFileDevice::ReadUser |
+                          QFileDevice::WriteUser |
+                          QFileDevice::ReadGroup |
+                          QFileDevice::ReadOther);
+    return filename;
+}
 }
 
 namespace ISD
@@ -867,6 +930,8 @@ CCD::CCD(GDInterface *iPtr) : DeviceDecorator(iPtr)
 
     connect(clientManager, &ClientManager::newBLOBManager, this, &CCD::setBLOBManager, Qt::UniqueConnection);
     m_LastNotificationTS = QDateTime::currentDateTime();
+
+    connect(&m_ImageLoadWatcher, &QFutureWatcher<bool>::finished, this, &CCD::processLoadedImage);
 }
 
 CCD::~CCD()
@@ -875,8 +940,9 @@ CCD::~CCD()
         m_ImageViewerWindow->close();
     if (fileWriteThread.isRunning())
         fileWriteThread.waitForFinished();
-    if (fileWriteBuffer != nullptr)
-        delete [] fileWriteBuffer;
+    // Pending images refer to our chips, finish decoding but drop them
+    m_PendingImages.clear();
+    m_ImageLoadWatcher.waitForFinished();
 }
 
 void CCD::setBLOBManager(const char *device, INDI::Property prop)
@@ -1388,6 +1454,7 @@ bool CCD::generateFilename(const QString &format, bool batch_mode, QString *file
         *filename = currentDir + seqPrefix + (seqPrefix.isEmpty() ? "" : "_") +
                     QString("%1%2").arg(QString().asprintf("%03d", nextSequenceID), format);
 
+    const QDateTime directoryModified = QFileInfo(currentDir).lastModified();
     QFile test_file(*filename);
     if (!test_file.open(QIODevice::WriteOnly))
     {
@@ -1396,17 +1463,19 @@ bool CCD::generateFilename(const QString &format, bool batch_mode, QString *file
     }
     test_file.flush();
     test_file.close();
+
+    // Counting captures does not need to list the whole directory again for the file we just created
+    Ekos::CaptureFileIndex::Instance()->add(*filename, directoryModified);
     return true;
 }
 
-bool CCD::writeImageFile(const QString &filename, IBLOB *bp, bool is_fits)
+bool CCD::writeImageFile(const QString &filename, const QByteArray &buffer, bool is_fits)
 {
     // TODO: Not yet threading the writes for non-fits files.
     // Would need to deal with the raw conversion, etc.
     if (is_fits)
     {
         // Check if the last write is still ongoing, and if so wait.
-        // It is using the fileWriteBuffer.
         if (fileWriteThread.isRunning())
         {
             fileWriteThread.waitForFinished();
@@ -1415,32 +1484,32 @@ bool CCD::writeImageFile(const QString &filename, IBLOB *bp, bool is_fits)
         // Wait until the file is written before overwritting the filename.
         fileWriteFilename = filename;
 
-        // Will write blob data in a separate thread, and can't depend on the blob
-        // memory, so copy it first.
-
-        // Check buffer size.
-        if (fileWriteBufferSize != bp->size)
-        {
-            if (fileWriteBuffer != nullptr)
-                delete [] fileWriteBuffer;
-            fileWriteBufferSize = bp->size;
-            fileWriteBuffer = new char[fileWriteBufferSize];
-        }
-
-        // Copy memory, and write file on a separate thread.
+        // The buffer is our own copy of the blob, so it is shared with the writing thread without copying.
+        // Compression is done on that thread as well, so it does not hold up the capture.
         // Probably too late to return an error if the file couldn't write.
-        memcpy(fileWriteBuffer, bp->blob, bp->size);
-        fileWriteThread = QtConcurrent::run(WriteImageFileInternal, fileWriteFilename, fileWriteBuffer, bp->size);
+        if (filename.endsWith(".fz"))
+            fileWriteThread = QtConcurrent::run(WriteCompressedImageFileInternal, filename, buffer);
+        else
+            fileWriteThread = QtConcurrent::run([filename, buffer]()
+        {
+            return WriteImageFileInternal(filename, buffer) ? filename : QString();
+        });
         //filter = "";
     }
     else
     {
-        if (!WriteImageFileInternal(filename, static_cast<char*>(bp->blob), bp->size))
+        if (!WriteImageFileInternal(filename, buffer))
             return false;
     }
     return true;
 }
 
+void CCD::reportSavedFile(const QString &format, const QString &filename)
+{
+    KStars::Instance()->statusBar()->showMessage(i18n("%1 file saved to %2", format.toUpper(), filename), 0);
+    qCInfo(KSTARS_INDI) << format.toUpper() << "file saved to" << filename;
+}
+
 void CCD::setupFITSViewerWindows()
 {
     normalTabID = calibrationTabID = focusTabID = guideTabID = alignTabID = -1;
@@ -1507,6 +1576,10 @@ void CCD::processBLOB(IBLOB *bp)
                              bp->size;
     }
 
+    // The INDI client reuses the blob memory for the next frame, so take our own copy once.
+    // It is shared by the file writing and image decoding threads.
+    const QByteArray buffer(static_cast<const char *>(bp->blob), bp->size);
+
     // Create temporary name if ANY of the following conditions are met:
     // 1. file is preview or batch mode is not enabled
     // 2. file type is not FITS_NORMAL (focus, guide..etc)
@@ -1528,10 +1601,13 @@ void CCD::processBLOB(IBLOB *bp)
     // Create file name for sequences.
     if (targetChip->isBatchMode())
     {
+        // Only the file on disk is compressed, the image is still decoded from the uncompressed blob.
+        const QString fileFormat = (format == ".fits" && Options::compressCapturedFITS()) ? ".fits.fz" : format;
+
         // If either generating file name or writing the image file fails
         // then return
-        if (!generateFilename(format, targetChip->isBatchMode(), &filename) ||
-                !writeImageFile(filename, bp, BType == BLOB_FITS))
+        if (!generateFilename(fileFormat, targetChip->isBatchMode(), &filename) ||
+                !writeImageFile(filename, buffer, BType == BLOB_FITS))
         {
             emit BLOBUpdated(nullptr);
             return;
@@ -1546,11 +1622,10 @@ void CCD::processBLOB(IBLOB *bp)
     //    bp->aux1 = &BType;
     //    bp->aux2 = BLOBFilename;
 
-    if (targetChip->getCaptureMode() == FITS_NORMAL && targetChip->isBatchMode() == true)
-    {
-        KStars::Instance()->statusBar()->showMessage(i18n("%1 file saved to %2", shortFormat.toUpper(), filename), 0);
-        qCInfo(KSTARS_INDI) << shortFormat.toUpper() << "file saved to" << filename;
-    }
+    // The name of a compressed file is reported once it is written, see processLoadedImage()
+    const bool compressed = targetChip->isBatchMode() && filename.endsWith(".fz");
+    if (targetChip->getCaptureMode() == FITS_NORMAL && targetChip->isBatchMode() == true && !compressed)
+        reportSavedFile(shortFormat, filename);
 
     // Don't spam, just one notification per 3 seconds
     if (QDateTime::currentDateTime().secsTo(m_LastNotificationTS) <= -3)
@@ -1647,31 +1722,111 @@ void CCD::processBLOB(IBLOB *bp)
     // 2. FITS Viewer is disabled; and
     // 3. Batch mode is enabled.
     // 4. Summary view is false.
-    if ((targetChip->getCaptureMode() == FITS_NORMAL || targetChip->getCaptureMode() == FITS_CALIBRATE) &&
-            Options::useFITSViewer() == false &&
-            Options::useSummaryPreview() == false &&
-            targetChip->isBatchMode())
+    const bool loadImage = !((targetChip->getCaptureMode() == FITS_NORMAL || targetChip->getCaptureMode() == FITS_CALIBRATE) &&
+                             Options::useFITSViewer() == false &&
+                             Options::useSummaryPreview() == false &&
+                             targetChip->isBatchMode());
+
+    // Decoding and statistics are done on a worker thread. Images are delivered in the order they
+    // were received, so an image that is not loaded still waits for the ones before it.
+    PendingImage image;
+    image.targetChip = targetChip;
+    image.filename   = filename;
+    image.format     = shortFormat;
+    image.buffer     = buffer;
+    image.blob       = *bp;
+    image.blob.blob  = const_cast<char *>(image.buffer.constData());
+    image.compressed = compressed;
+    if (compressed)
+        image.compressedFileWrite = fileWriteThread;
+    if (loadImage)
     {
-        emit BLOBUpdated(bp);
-        emit newImage(nullptr);
+        image.data.reset(new FITSData(targetChip->getCaptureMode()), &QObject::deleteLater);
+
+        // Focus and guide frames are only analyzed in their tracking box, only evaluate that region when loading
+        const FITSMode mode = targetChip->getCaptureMode();
+        FITSView *view = targetChip->getImageView(mode);
+        if ((mode == FITS_FOCUS || mode == FITS_GUIDE) && view && view->isTrackingBoxEnabled())
+            image.data->setStatisticsROI(view->getTrackingBox());
+    }
+
+    m_PendingImages.enqueue(image);
+    if (m_ImageLoadWatcher.isRunning() == false)
+        loadNextImage();
+}
+
+void CCD::loadNextImage()
+{
+    while (m_PendingImages.isEmpty() == false)
+    {
+        PendingImage &image = m_PendingImages.head();
+
+        if (image.data.isNull() && image.compressed == false)
+        {
+            PendingImage done = m_PendingImages.dequeue();
+            emit BLOBUpdated(&done.blob);
+            emit newImage(nullptr);
+            continue;
+        }
+
+        // Errors cannot be reported with a message box from the worker thread, they are logged in processLoadedImage()
+        // The image takes the name of the file actually written, so compressed frames wait for their file first.
+        QSharedPointer<FITSData> data = image.data;
+        const QByteArray buffer = image.buffer;
+        const QString format = image.format, filename = image.filename;
+        const bool compressed = image.compressed;
+        const QFuture<QString> fileWrite = image.compressedFileWrite;
+        m_ImageLoadWatcher.setFuture(QtConcurrent::run([data, buffer, format, filename, compressed, fileWrite]()
+        {
+            QString writtenFilename = compressed ? fileWrite.result() : filename;
+            if (writtenFilename.isEmpty())
+                writtenFilename = filename;
+            return data.isNull() || data->loadFromBuffer(buffer, format, writtenFilename, true);
+        }));
+        return;
+    }
+}
+
+void CCD::processLoadedImage()
+{
+    if (m_PendingImages.isEmpty())
         return;
+
+    PendingImage image = m_PendingImages.dequeue();
+
+    if (image.compressed)
+    {
+        // The write finished before the image was loaded
+        const QString writtenFilename = image.compressedFileWrite.result();
+        if (writtenFilename.isEmpty())
+            qCCritical(KSTARS_INDI) << "ISD:CCD Error: Unable to write" << image.filename;
+        else
+        {
+            image.filename = writtenFilename;
+            if (image.targetChip->getCaptureMode() == FITS_NORMAL)
+                reportSavedFile(image.format, image.filename);
+        }
+
+        if (image.data.isNull())
+        {
+            emit BLOBUpdated(&image.blob);
+            emit newImage(nullptr);
+            loadNextImage();
+            return;
+        }
     }
 
-    QSharedPointer<FITSData> blob_data;
-    QByteArray buffer = QByteArray::fromRawData(reinterpret_cast<char *>(bp->blob), bp->size);
-    blob_data.reset(new FITSData(targetChip->getCaptureMode()), &QObject::deleteLater);
-    if (!blob_data->loadFromBuffer(buffer, shortFormat, filename, false))
+    if (m_ImageLoadWatcher.result())
+        handleImage(image.targetChip, image.filename, &image.blob, image.data);
+    else
     {
         // If reading the blob fails, we treat it the same as exposure failure
         // and recapture again if possible
-        qCCritical(KSTARS_INDI) << "failed reading FITS memory buffer";
-        emit newExposureValue(targetChip, 0, IPS_ALERT);
-        return;
+        qCCritical(KSTARS_INDI) << "failed reading FITS memory buffer" << image.data->getLastError();
+        emit newExposureValue(image.targetChip, 0, IPS_ALERT);
     }
 
-    handleImage(targetChip, filename, bp, blob_data);
-    //    else
-    //        emit BLOBUpdated(bp);
+    loadNextImage();
 }
 
 void CCD::handleImage(CCDChip *targetChip, const QString &filename, IBLOB *bp, QSharedPointer<FITSData> data)
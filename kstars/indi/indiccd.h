@@ -16,6 +16,8 @@
 #include "fitsviewer/fitsview.h"
 #include "fitsviewer/fitsviewer.h"
 
+#include <QFutureWatcher>
+#include <QQueue>
 #include <QStringList>
 #include <QPointer>
 #include <QtConcurrent>
@@ -370,7 +372,13 @@ class CCD : public DeviceDecorator
         void loadImageInView(IBLOB *bp, ISD::CCDChip *targetChip, const QSharedPointer<FITSData> &data);
         bool generateFilename(const QString &format, bool batch_mode, QString *filename);
         // Saves an image to disk on a separate thread.
-        bool writeImageFile(const QString &filename, IBLOB *bp, bool is_fits);
+        bool writeImageFile(const QString &filename, const QByteArray &buffer, bool is_fits);
+        // Reports a captured image saved to disk in the status bar and the log.
+        void reportSavedFile(const QString &format, const QString &filename);
+        // Starts decoding the oldest pending image on a separate thread.
+        void loadNextImage();
+        // Delivers the image decoded by loadNextImage() and starts the next one.
+        void processLoadedImage();
         // Creates or finds the FITSViewer.
         void setupFITSViewerWindows();
         void handleImage(CCDChip *targetChip, const QString &filename, IBLOB *bp, QSharedPointer<FITSData> data);
@@ -423,9 +431,25 @@ class CCD : public DeviceDecorator
         QPair<double, double> m_ExposurePresetsMinMax;
 
         // Used when writing the image fits file to disk in a separate thread.
-        char *fileWriteBuffer { nullptr };
-        int fileWriteBufferSize { 0 };
+        // Its result is the name of the file actually written, or empty if writing failed.
         QString fileWriteFilename;
-        QFuture<void> fileWriteThread;
+        QFuture<QString> fileWriteThread;
+
+        // A received image waiting to be decoded and delivered. The blob points to our own copy of the data.
+        struct PendingImage
+        {
+            CCDChip *targetChip { nullptr };
+            QString filename;
+            QString format;
+            QByteArray buffer;
+            IBLOB blob {};
+            // Null if the image is only saved and not loaded
+            QSharedPointer<FITSData> data;
+            // A compressed file may be written uncompressed instead, so its name is only known once written
+            bool compressed { false };
+            QFuture<QString> compressedFileWrite;
+        };
+        QQueue<PendingImage> m_PendingImages;
+        QFutureWatcher<bool> m_ImageLoadWatcher;
 };
 }
@@ -290,13 +290,17 @@ void StreamWG::enableStream(bool enable)
     if (enable)
     {
         processStream = true;
+        videoFrame->resetDroppedFrames();
         show();
     }
     else
     {
         processStream = false;
+        if (videoFrame->droppedFrames() > 0)
+            qCInfo(KSTARS) << "Video preview skipped" << videoFrame->droppedFrames() << "frames.";
         //instFPS->setText("--");
         avgFPS->setText("--");
+        droppedFrames->setText("--");
         hide();
     }
 }
@@ -425,4 +429,5 @@ void StreamWG::updateFPS(double instantFPS, double averageFPS)
     Q_UNUSED(instantFPS)
     //instFPS->setText(QString::number(instantFPS, 'f', 1));
     avgFPS->setText(QString::number(averageFPS, 'f', 1));
+    droppedFrames->setText(QString::number(videoFrame->droppedFrames()));
 }
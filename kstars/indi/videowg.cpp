@@ -16,6 +16,56 @@
 #include <QMouseEvent>
 #include <QResizeEvent>
 #include <QRubberBand>
+#include <QtConcurrent>
+
+#include <cstring>
+
+namespace
+{
+// The INDI client reuses the blob memory for the next frame, so each displayed frame is copied once
+uint8_t *copyBlob(const IBLOB *bp)
+{
+    auto *buffer = new uint8_t[bp->size];
+    memcpy(buffer, bp->blob, bp->size);
+    return buffer;
+}
+
+// Wrap a buffer allocated with new[] in an image that takes ownership of it
+QImage *wrapBuffer(uint8_t *buffer, int width, int height, int bytesPerLine, QImage::Format format)
+{
+    return new QImage(buffer, width, height, bytesPerLine, format, [](void *data)
+    {
+        delete[] static_cast<uint8_t *>(data);
+    }, buffer);
+}
+
+QImage *debayer(const uint8_t *source, int width, int height, const BayerParams &params)
+{
+    auto *destinationBuffer = new uint8_t[width * height * 3];
+    int ds1394_height = height;
+
+    if (params.offsetY == 1)
+    {
+        source += width;
+        ds1394_height--;
+    }
+    if (params.offsetX == 1)
+    {
+        source++;
+    }
+    dc1394error_t error_code = dc1394_bayer_decoding_8bit(source, destinationBuffer, width, ds1394_height,
+                               params.filter, params.method);
+
+    if (error_code != DC1394_SUCCESS)
+    {
+        qCCritical(KSTARS) << "Debayer failed" << error_code;
+        delete[] destinationBuffer;
+        return nullptr;
+    }
+
+    return wrapBuffer(destinationBuffer, width, height, width * 3, QImage::Format_RGB888);
+}
+}
 
 VideoWG::VideoWG(QWidget *parent) : QLabel(parent)
 {
@@ -25,11 +75,45 @@ VideoWG::VideoWG(QWidget *parent) : QLabel(parent)
 
     for (int i = 0; i < 256; i++)
         grayTable[i] = qRgb(i, i, i);
+
+    connect(&m_PreviewWatcher, &QFutureWatcher<PreviewFrame>::finished, this, &VideoWG::processPreviewFrame);
+}
+
+template <typename Decoder>
+void VideoWG::startPreview(Decoder decoder)
+{
+    const QSize previewSize = size();
+    m_PreviewBusy = true;
+    m_PreviewWatcher.setFuture(QtConcurrent::run([decoder, previewSize]()
+    {
+        PreviewFrame frame;
+        frame.image.reset(decoder());
+        if (frame.image && !frame.image->isNull())
+            frame.scaled = frame.image->scaled(previewSize, Qt::KeepAspectRatio);
+        return frame;
+    }));
 }
 
 bool VideoWG::newBayerFrame(IBLOB *bp, const BayerParams &params)
 {
-    return debayer(bp, params);
+    // Frames arriving while the previous one is still being decoded are skipped without being copied
+    if (m_PreviewBusy)
+    {
+        m_DroppedFrames++;
+        return true;
+    }
+
+    if (static_cast<uint32_t>(bp->size) < totalBaseCount)
+        return false;
+
+    uint8_t *source = copyBlob(bp);
+    const int w = streamW, h = streamH;
+    startPreview([source, w, h, params]()
+    {
+        std::unique_ptr<uint8_t[]> bayer(source);
+        return debayer(bayer.get(), w, h, params);
+    });
+    return true;
 }
 
 bool VideoWG::newFrame(IBLOB *bp)
@@ -37,39 +121,73 @@ bool VideoWG::newFrame(IBLOB *bp)
     if (bp->size <= 0)
         return false;
 
-    bool rc = false;
-    QString format(bp->format);
-    if (m_RawFormat != format)
+    if (m_RawFormat != QLatin1String(bp->format))
     {
+        m_RawFormat = QLatin1String(bp->format);
+        QString format = m_RawFormat;
         format.remove('.');
         format.remove("stream_");
         m_RawFormatSupported = QImageReader::supportedImageFormats().contains(format.toLatin1());
-        m_RawFormat = format;
     }
 
+    // Frames arriving while the previous one is still being decoded are skipped without being copied
+    if (m_PreviewBusy)
+    {
+        m_DroppedFrames++;
+        return true;
+    }
+
+    const int w = streamW, h = streamH;
     if (m_RawFormatSupported)
-        rc = streamImage->loadFromData(static_cast<uchar *>(bp->blob), bp->size);
+    {
+        const QByteArray data(static_cast<const char *>(bp->blob), bp->size);
+        startPreview([data]()
+        {
+            auto *image = new QImage();
+            image->loadFromData(data);
+            return image;
+        });
+    }
     else if (static_cast<uint32_t>(bp->size) == totalBaseCount)
     {
-        streamImage.reset(new QImage(static_cast<uchar *>(bp->blob), streamW, streamH, QImage::Format_Indexed8));
-        streamImage->setColorTable(grayTable);
-        rc = !streamImage->isNull();
+        uint8_t *buffer = copyBlob(bp);
+        const QVector<QRgb> colors = grayTable;
+        startPreview([buffer, w, h, colors]()
+        {
+            QImage *image = wrapBuffer(buffer, w, h, w, QImage::Format_Indexed8);
+            image->setColorTable(colors);
+            return image;
+        });
     }
     else if (static_cast<uint32_t>(bp->size) == totalBaseCount * 3)
     {
-        streamImage.reset(new QImage(static_cast<uchar *>(bp->blob), streamW, streamH, QImage::Format_RGB888));
-        rc = !streamImage->isNull();
+        uint8_t *buffer = copyBlob(bp);
+        startPreview([buffer, w, h]()
+        {
+            return wrapBuffer(buffer, w, h, w * 3, QImage::Format_RGB888);
+        });
     }
+    else
+        return false;
+
+    return true;
+}
 
-    if (rc)
+void VideoWG::processPreviewFrame()
+{
+    PreviewFrame frame = m_PreviewWatcher.result();
+    m_PreviewBusy = false;
+    if (frame.image.isNull() || frame.image->isNull())
     {
-        kPix = QPixmap::fromImage(streamImage->scaled(size(), Qt::KeepAspectRatio));
-        setPixmap(kPix);
+        qCWarning(KSTARS) << "Failed to load video frame.";
+        return;
     }
 
-    emit imageChanged(streamImage);
+    streamImage = frame.image;
+    kPix = QPixmap::fromImage(frame.scaled);
+    setPixmap(kPix);
 
-    return rc;
+    emit imageChanged(streamImage);
 }
 
 bool VideoWG::save(const QString &filename, const char *format)
@@ -132,52 +250,3 @@ void VideoWG::mouseReleaseEvent(QMouseEvent *event)
     // determine selection, for example using QRect::intersects()
     // and QRect::contains().
 }
-
-bool VideoWG::debayer(const IBLOB *bp, const BayerParams &params)
-{
-    uint32_t rgb_size = streamW * streamH * 3;
-    auto * destinationBuffer = new uint8_t[rgb_size];
-
-    if (destinationBuffer == nullptr)
-    {
-        qCCritical(KSTARS) << "Unable to allocate memory for temporary bayer buffer.";
-        return false;
-    }
-
-    int ds1394_height = streamH;
-
-    uint8_t * dc1394_source = reinterpret_cast<uint8_t*>(bp->blob);
-    if (params.offsetY == 1)
-    {
-        dc1394_source += streamW;
-        ds1394_height--;
-    }
-    if (params.offsetX == 1)
-    {
-        dc1394_source++;
-    }
-    dc1394error_t error_code = dc1394_bayer_decoding_8bit(dc1394_source, destinationBuffer, streamW, ds1394_height,
-                               params.filter, params.method);
-
-    if (error_code != DC1394_SUCCESS)
-    {
-        qCCritical(KSTARS) << "Debayer failed" << error_code;
-        delete[] destinationBuffer;
-        return false;
-    }
-
-    streamImage.reset(new QImage(destinationBuffer, streamW, streamH, QImage::Format_RGB888));
-    bool rc = !streamImage->isNull();
-
-    if (rc)
-    {
-        kPix = QPixmap::fromImage(streamImage->scaled(size(), Qt::KeepAspectRatio));
-        setPixmap(kPix);
-    }
-
-    emit imageChanged(streamImage);
-
-    delete[] destinationBuffer;
-    return rc;
-}
-
@@ -17,6 +17,7 @@
 #include <QPixmap>
 #include <QVector>
 #include <QColor>
+#include <QFutureWatcher>
 #include <QLabel>
 
 #include <memory>
@@ -33,6 +34,12 @@ class VideoWG : public QLabel
         explicit VideoWG(QWidget *parent = nullptr);
         virtual ~VideoWG() override = default;
 
+        /**
+         * @brief newFrame Decode and display a stream frame.
+         * Frames are decoded and scaled on a worker thread. Frames arriving while the previous one is
+         * still being decoded are skipped and counted, so the preview never holds up the stream.
+         * @return False if the frame cannot be decoded.
+         */
         bool newFrame(IBLOB *bp);
         bool newBayerFrame(IBLOB *bp, const BayerParams &params);
 
@@ -40,6 +47,16 @@ class VideoWG : public QLabel
 
         void setSize(uint16_t w, uint16_t h);
 
+        /// Number of frames skipped by the preview since the last reset
+        uint32_t droppedFrames() const
+        {
+            return m_DroppedFrames;
+        }
+        void resetDroppedFrames()
+        {
+            m_DroppedFrames = 0;
+        }
+
     protected:
         //virtual void resizeEvent(QResizeEvent *ev) override;
         void mousePressEvent(QMouseEvent *event) override;
@@ -51,7 +68,24 @@ class VideoWG : public QLabel
         void imageChanged(const QSharedPointer<QImage> &frame);
 
     private:
-        bool debayer(const IBLOB *bp, const BayerParams &params);
+        struct PreviewFrame
+        {
+            /// Decoded frame at full resolution
+            QSharedPointer<QImage> image;
+            /// Frame scaled to the widget size
+            QImage scaled;
+        };
+
+        // Start decoding a frame unless the previous one is still being decoded
+        template <typename Decoder>
+        void startPreview(Decoder decoder);
+        void processPreviewFrame();
+
+        QFutureWatcher<PreviewFrame> m_PreviewWatcher;
+        // Set from startPreview() until processPreviewFrame() took the frame. The watcher stops running
+        // before it delivers the result, so it cannot tell by itself whether a frame is pending.
+        bool m_PreviewBusy { false };
+        uint32_t m_DroppedFrames { 0 };
 
         uint16_t streamW { 0 };
         uint16_t streamH { 0 };
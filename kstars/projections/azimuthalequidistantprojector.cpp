@@ -44,6 +44,12 @@ double AzimuthalEquidistantProjector::projectionK(double x) const
     return ((crad != 0) ? crad / sin(crad) : 1); // This handles the 0/0 case. The limit of x / sin(x) is 1 as x -> 0.
 }
 
+void AzimuthalEquidistantProjector::projectionK(double *x, int count) const
+{
+    for (int i = 0; i < count; ++i)
+        x[i] = AzimuthalEquidistantProjector::projectionK(x[i]);
+}
+
 double AzimuthalEquidistantProjector::projectionL(double x) const
 {
     return x;
@@ -70,6 +70,15 @@ Vector2f EquirectangularProjector::toScreenVec(const SkyPoint *o, bool oRefract,
     return p;
 }
 
+void EquirectangularProjector::toScreenVecs(const SkyPoint *const *points, int count, Vector2f *screen,
+                                            bool oRefract, bool *onVisibleHemisphere) const
+{
+    // No projection-specific code to batch here, just avoid the virtual call per point
+    for (int i = 0; i < count; ++i)
+        screen[i] = EquirectangularProjector::toScreenVec(points[i], oRefract,
+                    onVisibleHemisphere ? onVisibleHemisphere + i : nullptr);
+}
+
 SkyPoint EquirectangularProjector::fromScreen(const QPointF &p, dms *LST, const dms *lat, bool onlyAltAz) const
 {
     SkyPoint result;
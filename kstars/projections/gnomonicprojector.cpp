@@ -39,6 +39,12 @@ double GnomonicProjector::projectionK(double x) const
     return 1.0 / x;
 }
 
+void GnomonicProjector::projectionK(double *x, int count) const
+{
+    for (int i = 0; i < count; ++i)
+        x[i] = GnomonicProjector::projectionK(x[i]);
+}
+
 double GnomonicProjector::projectionL(double x) const
 {
     return atan(x);
@@ -36,6 +36,7 @@ class LambertProjector : public Projector
     Projection type() const override;
     double radius() const override;
     double projectionK(double x) const override;
+    void projectionK(double *x, int count) const override;
     double projectionL(double x) const override;
 };
 
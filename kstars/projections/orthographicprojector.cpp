@@ -19,6 +19,8 @@
 
 #include "orthographicprojector.h"
 
+#include <algorithm>
+
 OrthographicProjector::OrthographicProjector(const ViewParams &p) : Projector(p)
 {
     updateClipPoly();
@@ -40,6 +42,11 @@ double OrthographicProjector::projectionK(double x) const
     return 1.0;
 }
 
+void OrthographicProjector::projectionK(double *x, int count) const
+{
+    std::fill(x, x + count, 1.0);
+}
+
 double OrthographicProjector::projectionL(double x) const
 {
     return asin(x);
@@ -25,6 +25,8 @@
 #endif
 #include "skycomponents/skylabeler.h"
 
+#include <vector>
+
 namespace
 {
 void toXYZ(const SkyPoint *p, double *x, double *y, double *z)
@@ -473,27 +475,55 @@ SkyPoint Projector::fromScreen(const QPointF &p, dms *LST, const dms *lat, bool
     return result;
 }
 
-Vector2f Projector::toScreenVec(const SkyPoint *o, bool oRefract, bool *onVisibleHemisphere) const
+bool Projector::focusSinCos(const SkyPoint *o, bool oRefract, double &sindX, double &cosdX, double &sinY,
+                            double &cosY) const
 {
-    double Y, dX;
-    double sindX, cosdX, sinY, cosY;
-
-    oRefract &= m_vp.useRefraction;
     if (m_vp.useAltAz)
     {
+        double Y, dX;
         if (oRefract)
             Y = SkyPoint::refract(o->alt()).radians(); //account for atmospheric refraction
         else
             Y = o->alt().radians();
         dX = m_vp.focus->az().radians() - o->az().radians();
+
+        if (!(std::isfinite(Y) && std::isfinite(dX)))
+            return false;
+
+        //Convert dX, Y coords to screen pixel coords, using GNU extension if available
+#if (__GLIBC__ >= 2 && __GLIBC_MINOR__ >= 1)
+        sincos(dX, &sindX, &cosdX);
+        sincos(Y, &sinY, &cosY);
+#else
+        sindX = sin(dX);
+        cosdX = cos(dX);
+        sinY  = sin(Y);
+        cosY  = cos(Y);
+#endif
+        return true;
     }
-    else
-    {
-        dX = o->ra().radians() - m_vp.focus->ra().radians();
-        Y  = o->dec().radians();
-    }
 
-    if (!(std::isfinite(Y) && std::isfinite(dX)))
+    if (!(std::isfinite(o->dec().radians()) && std::isfinite(o->ra().radians()) &&
+            std::isfinite(m_vp.focus->ra().radians())))
+        return false;
+
+    // RA and Dec cache their sines and cosines, the ones of dX = RA - RA0 follow from them
+    double sinX, cosX, sinX0, cosX0;
+    o->ra().SinCos(sinX, cosX);
+    m_vp.focus->ra().SinCos(sinX0, cosX0);
+    sindX = sinX * cosX0 - cosX * sinX0;
+    cosdX = cosX * cosX0 + sinX * sinX0;
+    o->dec().SinCos(sinY, cosY);
+    return true;
+}
+
+Vector2f Projector::toScreenVec(const SkyPoint *o, bool oRefract, bool *onVisibleHemisphere) const
+{
+    // NOTE: toScreenVecs() must give exactly the same results, keep the two in sync.
+    double sindX, cosdX, sinY, cosY;
+
+    oRefract &= m_vp.useRefraction;
+    if (!focusSinCos(o, oRefract, sindX, cosdX, sinY, cosY))
     {
         return Vector2f(0, 0);
 
@@ -507,26 +537,10 @@ Vector2f Projector::toScreenVec(const SkyPoint *o, bool oRefract, bool *onVisibl
         if ( (obj = dynamic_cast<const SkyObject *>(o) ) ) {
             qDebug() << "Point is object with name = " << obj->name() << " longname = " << obj->longname();
         }
-        qDebug() << "dX = " << dX << " and isfinite(dX) is" << std::isfinite(dX);
-        qDebug() << "Y = " << Y << " and isfinite(Y) is" << std::isfinite(Y);
-
         //Q_ASSERT( false );
         */
     }
 
-    dX = KSUtils::reduceAngle(dX, -dms::PI, dms::PI);
-
-    //Convert dX, Y coords to screen pixel coords, using GNU extension if available
-#if (__GLIBC__ >= 2 && __GLIBC_MINOR__ >= 1)
-    sincos(dX, &sindX, &cosdX);
-    sincos(Y, &sinY, &cosY);
-#else
-    sindX = sin(dX);
-    cosdX = cos(dX);
-    sinY  = sin(Y);
-    cosY  = cos(Y);
-#endif
-
     //c is the cosine of the angular distance from the center
     double c = m_sinY0 * sinY + m_cosY0 * cosY * cosdX;
 
@@ -563,3 +577,137 @@ Vector2f Projector::toScreenVec(const SkyPoint *o, bool oRefract, bool *onVisibl
 #endif
     return Vector2f(x, y);
 }
+
+void Projector::toScreenVecs(const SkyPoint *const *points, int count, Vector2f *screen, bool oRefract,
+                             bool *onVisibleHemisphere) const
+{
+    // NOTE: This must give exactly the same results as toScreenVec(), keep the two in sync.
+    // The sines and cosines are those of focusSinCos(), but the mode is chosen once for all the points.
+    if (count <= 0)
+        return;
+
+    oRefract &= m_vp.useRefraction;
+    const double cosMax = cosMaxFieldAngle();
+
+    // One array per value so that the loops stay simple, c and dY are only needed after the sines and cosines
+    std::vector<double> values(6 * static_cast<size_t>(count));
+    double *c     = values.data();
+    double *cosY  = c + count;
+    double *sindX = cosY + count;
+    double *dY    = sindX + count;
+    double *sinY  = dY + count;
+    double *cosdX = sinY + count;
+    std::vector<bool> finite(count);
+
+    if (m_vp.useAltAz)
+    {
+        // Gather the angles first, into the arrays of their sines, so that the trigonometry runs in one tight loop
+        const double az0 = m_vp.focus->az().radians();
+        if (oRefract)
+        {
+            for (int i = 0; i < count; ++i)
+            {
+                sinY[i]  = SkyPoint::refract(points[i]->alt()).radians();
+                sindX[i] = az0 - points[i]->az().radians();
+            }
+        }
+        else
+        {
+            for (int i = 0; i < count; ++i)
+            {
+                sinY[i]  = points[i]->alt().radians();
+                sindX[i] = az0 - points[i]->az().radians();
+            }
+        }
+
+        for (int i = 0; i < count; ++i)
+        {
+            const double Y = sinY[i], dX = sindX[i];
+
+            finite[i] = std::isfinite(Y) && std::isfinite(dX);
+            if (!finite[i])
+                continue;
+#if (__GLIBC__ >= 2 && __GLIBC_MINOR__ >= 1)
+            sincos(dX, &sindX[i], &cosdX[i]);
+            sincos(Y, &sinY[i], &cosY[i]);
+#else
+            sindX[i] = sin(dX);
+            cosdX[i] = cos(dX);
+            sinY[i]  = sin(Y);
+            cosY[i]  = cos(Y);
+#endif
+        }
+    }
+    else
+    {
+        const bool focusFinite = std::isfinite(m_vp.focus->ra().radians());
+        double sinX0, cosX0;
+        m_vp.focus->ra().SinCos(sinX0, cosX0);
+
+        for (int i = 0; i < count; ++i)
+        {
+            const SkyPoint *o = points[i];
+
+            finite[i] = focusFinite && std::isfinite(o->dec().radians()) && std::isfinite(o->ra().radians());
+            if (!finite[i])
+                continue;
+
+            double sinX, cosX;
+            o->ra().SinCos(sinX, cosX);
+            sindX[i] = sinX * cosX0 - cosX * sinX0;
+            cosdX[i] = cosX * cosX0 + sinX * sinX0;
+            o->dec().SinCos(sinY[i], cosY[i]);
+        }
+    }
+
+    for (int i = 0; i < count; ++i)
+    {
+        if (!finite[i])
+        {
+            c[i] = cosY[i] = sindX[i] = dY[i] = 0;
+            continue;
+        }
+
+        c[i]  = m_sinY0 * sinY[i] + m_cosY0 * cosY[i] * cosdX[i];
+        dY[i] = m_cosY0 * sinY[i] - m_sinY0 * cosY[i] * cosdX[i];
+
+        if (onVisibleHemisphere)
+            onVisibleHemisphere[i] = (c[i] > cosMax);
+    }
+
+    // c is replaced by k
+    projectionK(c, count);
+
+    const double origX = m_vp.width / 2;
+    const double origY = m_vp.height / 2;
+#ifdef KSTARS_LITE
+    double skyRotation = SkyMapLite::Instance()->getSkyRotation();
+    double cosT = 1, sinT = 0;
+    if (skyRotation != 0)
+        dms(skyRotation).SinCos(sinT, cosT);
+#endif
+
+    for (int i = 0; i < count; ++i)
+    {
+        if (!finite[i])
+        {
+            // As toScreenVec() does, onVisibleHemisphere is left alone
+            screen[i] = Vector2f(0, 0);
+            continue;
+        }
+
+        double x = origX - m_vp.zoomFactor * c[i] * cosY[i] * sindX[i];
+        double y = origY - m_vp.zoomFactor * c[i] * dY[i];
+#ifdef KSTARS_LITE
+        if (skyRotation != 0)
+        {
+            double newX = origX + (x - origX) * cosT - (y - origY) * sinT;
+            double newY = origY + (x - origX) * sinT + (y - origY) * cosT;
+
+            x = newX;
+            y = newY;
+        }
+#endif
+        screen[i] = Vector2f(x, y);
+    }
+}
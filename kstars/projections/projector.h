@@ -146,6 +146,27 @@ class Projector
          */
         QPointF toScreen(const SkyPoint *o, bool oRefract = true, bool *onVisibleHemisphere = nullptr) const;
 
+        /**
+         * @short Determine the pixel coordinates in the SkyMap of many SkyPoints at once.
+         *
+         * The result for each point is exactly that of toScreenVec(), but the focus trigonometry,
+         * the coordinate system and refraction settings and the projection-specific code are
+         * handled once for all the points instead of once per point. Prefer this function when
+         * projecting large sets of points.
+         *
+         * @param points array of count pointers to the SkyPoints to project.
+         * @param count number of points.
+         * @param screen array of count Vector2f receiving the screen pixel x, y coordinates.
+         * @param oRefract true = use Options::useRefraction() value.
+         *   false = do not use refraction.
+         * @param onVisibleHemisphere optional array of count bools receiving whether each point is
+         *   on the visible part of the Celestial Sphere. As with toScreenVec(), it is not set for
+         *   points with invalid coordinates, which are projected to (0, 0).
+         * @see toScreenVec()
+         */
+        virtual void toScreenVecs(const SkyPoint *const *points, int count, Vector2f *screen, bool oRefract = true,
+                                  bool *onVisibleHemisphere = nullptr) const;
+
         /**
          * @short Determine RA, Dec coordinates of the pixel at (dx, dy), which are the
          * screen pixel coordinate offsets from the center of the Sky pixmap.
@@ -278,6 +299,16 @@ class Projector
             return x;
         }
 
+        /**
+         * Replaces each of the count values of x by projectionK() of it, for toScreenVecs().
+         * Reimplement it with a non-virtual call to projectionK() in the loop.
+         */
+        virtual void projectionK(double *x, int count) const
+        {
+            for (int i = 0; i < count; ++i)
+                x[i] = projectionK(x[i]);
+        }
+
         /**
          * This function handles some of the projection-specific code.
          * @see toScreen()
@@ -311,6 +342,17 @@ class Projector
         QPolygonF m_clipPolygon;
 
     private:
+        /**
+         * Finds the sine and cosine of the angle between o and the focus along the horizon or the
+         * equator, and of the altitude or declination of o, for toScreenVec(). toScreenVecs() computes
+         * the same values in loops specialized for each mode, keep the two in sync.
+         * In equatorial mode they come from the sines and cosines cached by the coordinates.
+         * @param oRefract whether to refract the altitude, already combined with useRefraction.
+         * @return false if the coordinates of o are not finite.
+         */
+        bool focusSinCos(const SkyPoint *o, bool oRefract, double &sindX, double &cosdX, double &sinY,
+                         double &cosY) const;
+
         //Used by CheckVisibility
         double m_xrange { 0 };
         bool m_isPoleVisible { false };
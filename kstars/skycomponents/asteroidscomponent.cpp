@@ -123,49 +123,61 @@ void AsteroidsComponent::loadDataFromText()
     sequence.append(qMakePair(QString("moid"), KSParser::D_DOUBLE));
     sequence.append(qMakePair(QString("class"), KSParser::D_QSTRING));
 
+    // Field positions in the sequence above
+    enum
+    {
+        F_FULL_NAME, F_EPOCH_MJD, F_Q, F_A, F_E, F_I, F_W, F_OM, F_MA, F_TP_CALC, F_ORBIT_ID, F_H, F_G, F_NEO, F_M1, F_M2,
+        F_DIAMETER, F_EXTENT, F_ALBEDO, F_ROT_PERIOD, F_PER_Y, F_MOID, F_CLASS
+    };
+
     KSParser asteroid_parser(filepath_txt, '#', sequence);
 
-    QHash<QString, QVariant> row_content;
-    while (asteroid_parser.HasNextRow())
+    // Translations are looked up once, not for every asteroid
+    QString const europa   = i18nc("Asteroid name (optional)", "Europa");
+    QString const io       = i18nc("Asteroid name (optional)", "Io");
+    QString const asterope = i18nc("Asteroid name (optional)", "Asterope");
+    QString const pluto    = i18nc("Asteroid name (optional)", "Pluto");
+    QString const suffix   = i18n(" (Asteroid)");
+
+    // Fields are converted straight from the line read, without going through a QHash of QVariants
+    QVector<QStringRef> fields;
+    while (asteroid_parser.ReadNextCSVFields(fields))
     {
-        row_content = asteroid_parser.ReadNextRow();
-        full_name   = row_content["full name"].toString();
-        full_name   = full_name.trimmed();
+        full_name   = fields[F_FULL_NAME].trimmed().toString();
         int catN    = full_name.section(' ', 0, 0).toInt();
 
         name = full_name.section(' ', 1, -1);
 
         //JM temporary hack to avoid Europa,Io, and Asterope duplication
-        if (name == i18nc("Asteroid name (optional)", "Europa") || name == i18nc("Asteroid name (optional)", "Io") ||
-                name == i18nc("Asteroid name (optional)", "Asterope"))
-            name += i18n(" (Asteroid)");
-
-        mJD         = row_content["epoch_mjd"].toInt();
-        q           = row_content["q"].toDouble();
-        a           = row_content["a"].toDouble();
-        e           = row_content["e"].toDouble();
-        dble_i      = row_content["i"].toDouble();
-        dble_w      = row_content["w"].toDouble();
-        dble_N      = row_content["om"].toDouble();
-        dble_M      = row_content["ma"].toDouble();
-        orbit_id    = row_content["orbit_id"].toString();
-        H           = row_content["H"].toDouble();
-        G           = row_content["G"].toDouble();
-        neo         = row_content["neo"].toString() == "Y";
-        diameter    = row_content["diameter"].toFloat();
-        dimensions  = row_content["extent"].toString();
-        albedo      = row_content["albedo"].toFloat();
-        rot_period  = row_content["rot_period"].toFloat();
-        period      = row_content["per_y"].toFloat();
-        earth_moid  = row_content["moid"].toDouble();
-        orbit_class = row_content["class"].toString();
+        if (name == europa || name == io || name == asterope)
+            name += suffix;
+
+        mJD         = fields[F_EPOCH_MJD].trimmed().toInt();
+        q           = fields[F_Q].trimmed().toDouble();
+        a           = fields[F_A].trimmed().toDouble();
+        e           = fields[F_E].trimmed().toDouble();
+        dble_i      = fields[F_I].trimmed().toDouble();
+        dble_w      = fields[F_W].trimmed().toDouble();
+        dble_N      = fields[F_OM].trimmed().toDouble();
+        dble_M      = fields[F_MA].trimmed().toDouble();
+        orbit_id    = fields[F_ORBIT_ID].toString();
+        H           = fields[F_H].trimmed().toDouble();
+        G           = fields[F_G].trimmed().toDouble();
+        neo         = fields[F_NEO] == QLatin1String("Y");
+        diameter    = fields[F_DIAMETER].trimmed().toFloat();
+        dimensions  = fields[F_EXTENT].toString();
+        albedo      = fields[F_ALBEDO].trimmed().toFloat();
+        rot_period  = fields[F_ROT_PERIOD].trimmed().toFloat();
+        period      = fields[F_PER_Y].trimmed().toFloat();
+        earth_moid  = fields[F_MOID].trimmed().toDouble();
+        orbit_class = fields[F_CLASS].toString();
 
         JD = static_cast<double>(mJD) + 2400000.5;
 
         KSAsteroid *new_asteroid = nullptr;
 
         // Diameter is missing from JPL data
-        if (name == i18nc("Asteroid name (optional)", "Pluto"))
+        if (name == pluto)
             diameter = 2390;
 
         new_asteroid = new KSAsteroid(catN, name, QString(), JD, a, e, dms(dble_i), dms(dble_w), dms(dble_N), dms(dble_M), H, G);
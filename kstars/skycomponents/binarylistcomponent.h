@@ -18,6 +18,7 @@
 #pragma once
 
 #include <QDataStream>
+#include <QFileInfo>
 
 #include "listcomponent.h"
 #include "binarylistcomponent.h"
@@ -179,6 +180,11 @@ void  BinaryListComponent<T, Component>::loadData(bool dropBinaryFile)
     if(dropBinaryFile)
         dropBinary();
 
+    // The binary is a cache of the text file, so rebuild it if the text file was changed since
+    QFileInfo const txtinfo(filepath_txt), bininfo(filepath_bin);
+    if (bininfo.exists() && txtinfo.exists() && bininfo.lastModified() < txtinfo.lastModified())
+        dropBinary();
+
     QFile binfile(filepath_bin);
     if (binfile.exists()) {
         loadDataFromBinary(binfile);
@@ -33,8 +33,12 @@ CatalogsComponent::CatalogsComponent(SkyComposite *parent, const QString &db_fil
                                      bool load_default)
     : SkyComponent(parent), m_db_manager(db_filename), m_skyMesh{ SkyMesh::Create(
                                                            m_db_manager.htmesh_level()) },
-      m_cache(m_skyMesh->size(), calculateCacheSize(Options::dSOCachePercentage()))
+      m_cache(m_skyMesh->size(), calculateCacheSize(Options::dSOCachePercentage())),
+      m_loader{ m_db_manager.db_file_name() }
 {
+    QObject::connect(&m_load_watcher, &QFutureWatcherBase::finished,
+                     [this]() { insertLoadedObjects(); });
+
     if (load_default)
     {
         const auto &default_file = KSPaths::locate(QStandardPaths::GenericDataLocation,
@@ -49,6 +53,11 @@ CatalogsComponent::CatalogsComponent(SkyComposite *parent, const QString &db_fil
     qCInfo(KSTARS) << "Loaded DSO catalogs.";
 }
 
+CatalogsComponent::~CatalogsComponent()
+{
+    m_load_watcher.waitForFinished();
+}
+
 double compute_maglim()
 {
     double maglim = Options::magLimitDrawDeepSky();
@@ -94,6 +103,7 @@ void CatalogsComponent::draw(SkyPainter *skyp)
     MeshIterator region(m_skyMesh, DRAW_BUF);
 
     size_t num_trixels{ 0 };
+    std::vector<Trixel> missing_trixels;
 
     while (region.hasNext())
     {
@@ -103,22 +113,9 @@ void CatalogsComponent::draw(SkyPainter *skyp)
         auto &objects = m_cache[trixel];
         if (!objects.is_set())
         {
-            try
-            {
-                objects = m_db_manager.get_objects_in_trixel(trixel);
-            }
-            catch (const CatalogsDB::DatabaseError &e)
-            {
-                qCCritical(KSTARS)
-                    << "Could not load catalog objects in trixel: " << trixel << ", "
-                    << e.what();
-
-                KMessageBox::detailedError(
-                    nullptr, i18n("Could not load catalog objects in trixel: %1", trixel),
-                    e.what());
-
-                throw; // do not silently fail
-            }
+            // drawn as soon as they are loaded
+            missing_trixels.push_back(trixel);
+            continue;
         }
 
         for (auto &object : objects.data())
@@ -141,17 +138,7 @@ void CatalogsComponent::draw(SkyPainter *skyp)
             if (sizeCriterion)
             {
                 object.JITupdate();
-                auto &color = m_catalog_colors[object.catalogId()];
-                if (!color.isValid())
-                {
-                    const auto &catalog_color = object.getCatalog().color;
-                    if (catalog_color == "")
-                        color = default_color;
-                    else
-                        color = QColor(catalog_color);
-                }
-
-                skyp->setPen(color);
+                skyp->setPen(catalogColor(object.catalogId(), default_color));
 
                 if (Options::showInlineImages())
                     object.load_image();
@@ -167,8 +154,77 @@ void CatalogsComponent::draw(SkyPainter *skyp)
     // prune only if the to-be-pruned trixels are likely not visible
     // and we are not zooming
     m_cache.prune(num_trixels * 1.2);
+
+    // trixels missed while a load is running are requested again by
+    // the redraw that follows it
+    if (!missing_trixels.empty() && !m_load_watcher.isRunning())
+        loadTrixels(missing_trixels);
 };
 
+void CatalogsComponent::loadTrixels(const std::vector<Trixel> &trixels)
+{
+    m_load_generation = m_cache_generation;
+
+    m_load_watcher.setFuture(m_loader.run([trixels](CatalogsDB::DBManager &db) {
+        TrixelObjects loaded;
+        for (const auto trixel : trixels)
+        {
+            try
+            {
+                loaded.emplace_back(trixel, db.get_objects_in_trixel(trixel));
+            }
+            catch (const CatalogsDB::DatabaseError &e)
+            {
+                // left out of the cache, so that a later redraw tries it again
+                qCCritical(KSTARS) << "Could not load catalog objects in trixel: "
+                                   << trixel << ", " << e.what();
+            }
+        }
+
+        return loaded;
+    }));
+}
+
+void CatalogsComponent::insertLoadedObjects()
+{
+    // the cache was dropped while loading, the redraw loads the
+    // trixels again
+    if (m_load_generation != m_cache_generation)
+    {
+        SkyMap::Instance()->forceUpdate();
+        return;
+    }
+
+    // nothing to draw if all the trixels failed to load, they are
+    // retried by the next redraw, whenever it happens
+    auto loaded = m_load_watcher.result();
+    if (loaded.empty())
+        return;
+
+    for (auto &trixel_objects : loaded)
+        m_cache[trixel_objects.first] = std::move(trixel_objects.second);
+
+    SkyMap::Instance()->forceUpdate();
+}
+
+const QColor &CatalogsComponent::catalogColor(const int catalog_id,
+                                              const QColor &default_color)
+{
+    if (m_catalog_colors.empty())
+    {
+        // one query for all catalogs, on the already open connection
+        for (const auto &catalog : m_db_manager.get_catalogs(true))
+            m_catalog_colors[catalog.id] =
+                (catalog.color == "") ? QColor() : QColor(catalog.color);
+    }
+
+    const auto color = m_catalog_colors.find(catalog_id);
+    if (color == m_catalog_colors.end() || !color->second.isValid())
+        return default_color;
+
+    return color->second;
+}
+
 void CatalogsComponent::updateSkyMesh(SkyMap &map, MeshBufNum_t buf)
 {
     SkyPoint *focus = map.focus();
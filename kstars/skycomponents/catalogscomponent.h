@@ -21,6 +21,7 @@
 #include "skymesh.h"
 #include "trixelcache.h"
 #include "Options.h"
+#include <QFutureWatcher>
 #include <unordered_map>
 
 class SkyMesh;
@@ -61,11 +62,15 @@ class CatalogsComponent : public SkyComponent
     explicit CatalogsComponent(SkyComposite *parent, const QString &db_filename,
                                bool load_default = false);
 
-    ~CatalogsComponent() override = default;
+    ~CatalogsComponent() override;
 
     /**
      * Draws the objects in the currently visible trixels by
      * dynamically loading them from the database.
+     *
+     * Trixels that are not cached yet are loaded in the background and
+     * drawn as soon as they are available, so that drawing never waits
+     * for the database.
      */
     void draw(SkyPainter *skyp) override;
 
@@ -118,6 +123,7 @@ class CatalogsComponent : public SkyComponent
     {
         m_cache.clear();
         m_catalog_colors = {};
+        m_cache_generation++;
     };
 
     /**
@@ -170,14 +176,47 @@ class CatalogsComponent : public SkyComponent
     std::unordered_map<Trixel, std::list<CatalogObject>> m_static_objects;
 
     /**
-     * A cache for catalog colors.
+     * A cache for catalog colors, filled with the colors of all catalogs
+     * at once.
      */
     std::unordered_map<int, QColor> m_catalog_colors;
 
+    /**
+     * The objects of some trixels, as loaded in the background.
+     * Trixels that could not be loaded are left out.
+     */
+    using TrixelObjects = std::vector<std::pair<Trixel, ObjectList>>;
+
+    /**
+     * The database connection of the background loads.
+     */
+    CatalogsDB::BackgroundConnection m_loader;
+    QFutureWatcher<TrixelObjects> m_load_watcher;
+
+    /**
+     * Incremented by `dropCache` so that loads started before are
+     * discarded.
+     */
+    int m_cache_generation{ 0 };
+    int m_load_generation{ 0 };
+
     //@{
     /** Helpers */
 
     void updateSkyMesh(SkyMap &map, MeshBufNum_t buf = DRAW_BUF);
+
+    /**
+     * Load the objects of the \p trixels in the background. The
+     * objects are put in the cache by `insertLoadedObjects`.
+     */
+    void loadTrixels(const std::vector<Trixel> &trixels);
+    void insertLoadedObjects();
+
+    /**
+     * \return the color of the catalog with the id \p catalog_id, or
+     * \p default_color if the catalog doesn't define one.
+     */
+    const QColor &catalogColor(const int catalog_id, const QColor &default_color);
     size_t calculateCacheSize(const int percentage)
     {
         return m_skyMesh->size() * percentage / 100;
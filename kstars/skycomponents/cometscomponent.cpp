@@ -122,47 +122,51 @@ void CometsComponent::loadData()
     sequence.append(qMakePair(QString("H"), KSParser::D_SKIP));
     sequence.append(qMakePair(QString("G"), KSParser::D_SKIP));
 
+    // Field positions in the sequence above
+    enum
+    {
+        F_FULL_NAME, F_EPOCH_MJD, F_Q, F_E, F_I, F_W, F_OM, F_TP_CALC, F_ORBIT_ID, F_NEO, F_M1, F_M2, F_DIAMETER, F_EXTENT,
+        F_ALBEDO, F_ROT_PERIOD, F_PER_Y, F_MOID, F_CLASS, F_H, F_G
+    };
+
     QString file_name = KSPaths::locate(QStandardPaths::GenericDataLocation, QString("comets.dat"));
     KSParser cometParser(file_name, '#', sequence);
 
-    QHash<QString, QVariant> row_content;
-    while (cometParser.HasNextRow())
+    // Fields are converted straight from the line read, without going through a QHash of QVariants
+    QVector<QStringRef> fields;
+    while (cometParser.ReadNextCSVFields(fields))
     {
         KSComet *com = nullptr;
-        row_content  = cometParser.ReadNextRow();
-        name         = row_content["full name"].toString();
-        name         = name.trimmed();
+        name         = fields[F_FULL_NAME].trimmed().toString();
         bool neo;
         double q, e, dble_i, dble_w, dble_N, Tp, earth_moid;
         float M1, M2, K1, K2, diameter, albedo, rot_period, period;
-        q            = row_content["q"].toDouble();
-        e            = row_content["e"].toDouble();
-        dble_i       = row_content["i"].toDouble();
-        dble_w       = row_content["w"].toDouble();
-        dble_N       = row_content["om"].toDouble();
-        Tp           = row_content["tp_calc"].toDouble();
-        orbit_id     = row_content["orbit_id"].toString();
-        neo          = row_content["neo"] == "Y";
-
-        if (row_content["M1"].toFloat() == 0.0)
+        q            = fields[F_Q].trimmed().toDouble();
+        e            = fields[F_E].trimmed().toDouble();
+        dble_i       = fields[F_I].trimmed().toDouble();
+        dble_w       = fields[F_W].trimmed().toDouble();
+        dble_N       = fields[F_OM].trimmed().toDouble();
+        Tp           = fields[F_TP_CALC].trimmed().toDouble();
+        orbit_id     = fields[F_ORBIT_ID].toString();
+        neo          = fields[F_NEO] == QLatin1String("Y");
+
+        M1 = fields[F_M1].trimmed().toFloat();
+        if (M1 == 0.0)
             M1 = 101.0;
-        else
-            M1 = row_content["M1"].toFloat();
 
-        if (row_content["M2"].toFloat() == 0.0)
+        M2 = fields[F_M2].trimmed().toFloat();
+        if (M2 == 0.0)
             M2 = 101.0;
-        else
-            M2 = row_content["M2"].toFloat();
-
-        diameter    = row_content["diameter"].toFloat();
-        dimensions  = row_content["extent"].toString();
-        albedo      = row_content["albedo"].toFloat();
-        rot_period  = row_content["rot_period"].toFloat();
-        period      = row_content["per_y"].toFloat();
-        earth_moid  = row_content["moid"].toDouble();
-        orbit_class = row_content["class"].toString();
-        K1          = row_content["H"].toFloat();
-        K2          = row_content["G"].toFloat();
+
+        diameter    = fields[F_DIAMETER].trimmed().toFloat();
+        dimensions  = fields[F_EXTENT].toString();
+        albedo      = fields[F_ALBEDO].trimmed().toFloat();
+        rot_period  = fields[F_ROT_PERIOD].trimmed().toFloat();
+        period      = fields[F_PER_Y].trimmed().toFloat();
+        earth_moid  = fields[F_MOID].trimmed().toDouble();
+        orbit_class = fields[F_CLASS].toString();
+        K1          = fields[F_H].trimmed().toFloat();
+        K2          = fields[F_G].trimmed().toFloat();
 
         com = new KSComet(name, QString(), q, e, dms(dble_i), dms(dble_w), dms(dble_N), Tp, M1, M2, K1, K2);
         com->setOrbitID(orbit_id);
@@ -29,10 +29,12 @@
 #include "starcomponent.h"
 #include "htmesh/MeshIterator.h"
 #include "projections/projector.h"
+#include "auxiliary/kspaths.h"
 
 #include <qplatformdefs.h>
 #include <QtConcurrent>
 #include <QElapsedTimer>
+#include <QFile>
 
 #include <kstars_debug.h>
 
@@ -40,6 +42,12 @@
 #include <windows.h>
 #endif
 
+namespace
+{
+// Number of records read ahead for a trixel at a time, a few star blocks worth
+constexpr quint64 READ_AHEAD_RECORDS = 400;
+}
+
 DeepStarComponent::DeepStarComponent(SkyComposite *parent, QString fileName, float trigMag, bool staticstars)
     : ListComponent(parent), m_reindexNum(J2000), triggerMag(trigMag), m_FaintMagnitude(-5.0), staticStars(staticstars),
       dataFileName(fileName)
@@ -49,10 +57,16 @@ DeepStarComponent::DeepStarComponent(SkyComposite *parent, QString fileName, flo
     if (staticStars)
         loadStaticStars();
     qCInfo(KSTARS) << "Loaded DSO catalog file: " << dataFileName;
+
+    QObject::connect(&m_ReadWatcher, &QFutureWatcherBase::finished, [this]()
+    {
+        processReads();
+    });
 }
 
 DeepStarComponent::~DeepStarComponent()
 {
+    m_ReadWatcher.waitForFinished();
     if (fileOpened)
         starReader.closeFile();
     fileOpened = false;
@@ -139,19 +153,20 @@ bool DeepStarComponent::loadStaticStars()
                     byteSwap(&stardata);
 
                 /* Initialize star with data just read. */
-                StarObject *star;
-#ifdef KSTARS_LITE
-                star = &(SB->addStar(stardata)->star);
-#else
-                star = SB->addStar(stardata);
-#endif
-                if (star)
+                if (SB->addStar(stardata))
                 {
                     //KStarsData* data = KStarsData::Instance();
                     //star->EquatorialToHorizontal( data->lst(), data->geo()->lat() );
                     //if( star->getHDIndex() != 0 )
                     if (stardata.HD)
-                        m_CatalogNumber.insert(stardata.HD, star);
+                    {
+#ifdef KSTARS_LITE
+                        m_CatalogNumber.insert(stardata.HD, &(SB->star(SB->getStarCount() - 1)->star));
+#else
+                        // Only the stars that can be looked up by HD number are built as StarObjects
+                        m_CatalogNumber.insert(stardata.HD, SB->star(SB->getStarCount() - 1));
+#endif
+                    }
                 }
                 else
                 {
@@ -190,22 +205,13 @@ bool DeepStarComponent::loadStaticStars()
                 if (starReader.getByteSwap())
                     byteSwap(&deepstardata);
 
-                /* Initialize star with data just read. */
-                StarObject *star;
+                /* Initialize star with data just read. Deep star records have no HD number. */
 #ifdef KSTARS_LITE
-                star = &(SB->addStar(stardata)->star);
+                bool added = SB->addStar(stardata);
 #else
-                star = SB->addStar(deepstardata);
+                bool added = SB->addStar(deepstardata);
 #endif
-                if (star)
-                {
-                    //KStarsData* data = KStarsData::Instance();
-                    //star->EquatorialToHorizontal( data->lst(), data->geo()->lat() );
-                    //if( star->getHDIndex() != 0 )
-                    if (stardata.HD)
-                        m_CatalogNumber.insert(stardata.HD, star);
-                }
-                else
+                if (!added)
                 {
                     qCCritical(KSTARS) << "CODE ERROR: More unnamed static stars in trixel " << trixel
                                        << " than we allocated space for!";
@@ -256,9 +262,7 @@ void DeepStarComponent::draw(SkyPainter *skyp)
     StarObject::updateCoordsCpuTime = 0.;
     StarObject::starsUpdated        = 0;
 #endif
-    SkyMap *map       = SkyMap::Instance();
-    KStarsData *data  = KStarsData::Instance();
-    UpdateID updateID = data->updateID();
+    SkyMap *map = SkyMap::Instance();
 
     //FIXME_FOV -- maybe not clamp like that...
     float radius = map->projector()->fov();
@@ -311,6 +315,11 @@ void DeepStarComponent::draw(SkyPainter *skyp)
 
     visibleStarCount = 0;
 
+    // Trixels whose stars are still on disk. They are read on a worker thread and drawn in a later frame.
+    QVector<TrixelRead> reads;
+    // Blocks holding the stars to draw
+    QVector<std::shared_ptr<StarBlock>> blocks;
+
     t.start();
 
     // Mark used blocks in the LRU Cache. Not required for static stars
@@ -352,9 +361,14 @@ void DeepStarComponent::draw(SkyPainter *skyp)
         if (currentRegion >= m_starBlockList.size())
             continue;
 
-        if (!staticStars)
+        std::shared_ptr<StarBlockList> sbl = m_starBlockList.at(currentRegion);
+        if (!staticStars && !sbl->fillFromReadAhead(maglim))
         {
-            m_starBlockList.at(currentRegion)->fillToMag(maglim);
+            TrixelRead read;
+            read.trixel = currentRegion;
+            read.offset = sbl->nextReadOffset();
+            read.size   = qMin(sbl->remainingRecords(), READ_AHEAD_RECORDS) * starReader.guessRecordSize();
+            reads.append(read);
         }
 
         //        if (!staticStars && !m_starBlockList.at(currentRegion)->fillToMag(maglim) &&
@@ -365,50 +379,63 @@ void DeepStarComponent::draw(SkyPainter *skyp)
 
         t_dynamicLoad += t.restart();
 
-        //        qDebug() << "Drawing SBL for trixel " << currentRegion << ", SBL has "
-        //                 <<  m_starBlockList[ currentRegion ]->getBlockCount() << " blocks";
-
-        // REMARK: The following should never carry state, except for const parameters like updateID and maglim
-        std::function<void(std::shared_ptr<StarBlock>)> mapFunction = [&updateID, &maglim](std::shared_ptr<StarBlock> myBlock)
-        {
-            for (StarObject &star : myBlock->contents())
-            {
-                if (star.updateID != updateID)
-                    star.JITupdate();
-                if (star.mag() > maglim)
-                    break;
-            }
-        };
-
-        QtConcurrent::blockingMap(m_starBlockList.at(currentRegion)->contents(), mapFunction);
-
-        for (int i = 0; i < m_starBlockList.at(currentRegion)->getBlockCount(); ++i)
+        // Stars are sorted by magnitude, so the blocks after the first one reaching maglim have nothing to draw
+        for (int i = 0; i < sbl->getBlockCount(); ++i)
         {
-            std::shared_ptr<StarBlock> block = m_starBlockList.at(currentRegion)->block(i);
-            //            qDebug() << "---> Drawing stars from block " << i << " of trixel " <<
-            //                currentRegion << ". SB has " << block->getStarCount() << " stars";
-            for (int j = 0; j < block->getStarCount(); j++)
-            {
-                StarObject *curStar = block->star(j);
+            std::shared_ptr<StarBlock> block = sbl->block(i);
+            blocks.append(block);
+            if (block->getFaintMag() > maglim)
+                break;
+        }
+    }
 
-                //                qDebug() << "We claim that he's from trixel " << currentRegion
-                //<< ", and indexStar says he's from " << m_skyMesh->indexStar( curStar );
+    // Update the stars of all the trixels at once, instead of a blockingMap per trixel
+    // REMARK: The following should never carry state, except for const parameters like maglim
+    std::function<void(std::shared_ptr<StarBlock>)> mapFunction = [maglim](std::shared_ptr<StarBlock> myBlock)
+    {
+        myBlock->updateStars(maglim);
+    };
 
-                float mag = curStar->mag();
+    QtConcurrent::blockingMap(blocks, mapFunction);
 
-                if (mag > maglim)
-                    break;
+    // The stars of each block are drawn together, so that they are projected together
+    QVector<SkyPoint> points;
+    QVector<const SkyPoint *> locs;
+    QVector<float> mags;
+    QVector<char> sps;
+    for (const std::shared_ptr<StarBlock> &block : blocks)
+    {
+        int n = 0;
+        while (n < block->getStarCount() && !(block->entry(n).mag > maglim))
+            ++n;
 
-                if (skyp->drawPointSource(curStar, mag, curStar->spchar()))
-                    visibleStarCount++;
-            }
+        if (points.size() < n)
+        {
+            points.resize(n);
+            locs.resize(n);
+            mags.resize(n);
+            sps.resize(n);
+        }
+        for (int j = 0; j < n; j++)
+        {
+            const CompactStar &star = block->entry(j);
+            star.toSkyPoint(points[j]);
+            locs[j] = &points[j];
+            mags[j] = star.mag;
+            sps[j]  = star.spchar;
         }
 
-        // DEBUG: Uncomment to identify problems with Star Block Factory / preservation of Magnitude Order in the LRU Cache
-        //        verifySBLIntegrity();
-        t_drawUnnamed += t.restart();
+        visibleStarCount += skyp->drawPointSources(locs.constData(), mags.constData(), sps.constData(), n);
     }
+
+    // DEBUG: Uncomment to identify problems with Star Block Factory / preservation of Magnitude Order in the LRU Cache
+    //        verifySBLIntegrity();
+    t_drawUnnamed += t.restart();
     m_skyMesh->inDraw(false);
+
+    // Reads requested while others are running are requested again by the redraw that follows them
+    if (!reads.isEmpty() && !m_ReadWatcher.isRunning())
+        startReads(reads);
 #ifdef PROFILE_SINCOS
     trig_calls_here += dms::trig_function_calls;
     trig_redundancy_here += dms::redundant_trig_function_calls;
@@ -433,12 +460,50 @@ void DeepStarComponent::draw(SkyPainter *skyp)
 #endif
 }
 
+void DeepStarComponent::startReads(const QVector<TrixelRead> &reads)
+{
+    const QString path = dataFilePath;
+    m_ReadWatcher.setFuture(QtConcurrent::run([path, reads]()
+    {
+        // The shared FILE handle of starReader is only used from the GUI thread, read through another one
+        QVector<TrixelRead> done = reads;
+        QFile file(path);
+        if (!file.open(QIODevice::ReadOnly))
+            return QVector<TrixelRead>();
+
+        for (TrixelRead &read : done)
+        {
+            if (file.seek(read.offset))
+                read.records = file.read(read.size);
+        }
+        return done;
+    }));
+}
+
+void DeepStarComponent::processReads()
+{
+    const QVector<TrixelRead> reads = m_ReadWatcher.result();
+    for (const TrixelRead &read : reads)
+    {
+        if (static_cast<int>(read.trixel) < m_starBlockList.size())
+            m_starBlockList.at(read.trixel)->setReadAhead(read.offset, read.records);
+    }
+
+#ifndef KSTARS_LITE
+    // Draw the stars just read. Redraw even if none was accepted, as the redraw also requests again
+    // the reads that were dropped while these were running.
+    if (!reads.isEmpty())
+        SkyMap::Instance()->forceUpdate();
+#endif
+}
+
 bool DeepStarComponent::openDataFile()
 {
     if (starReader.getFileHandle())
         return true;
 
     starReader.openFile(dataFileName);
+    dataFilePath = KSPaths::locate(QStandardPaths::GenericDataLocation, dataFileName);
     fileOpened = false;
     if (!starReader.getFileHandle())
         qCWarning(KSTARS) << "Failed to open deep star catalog " << dataFileName << ". Disabling it.";
@@ -516,6 +581,13 @@ SkyObject *DeepStarComponent::objectNearest(SkyPoint *p, double &maxrad)
 
     MeshIterator region(m_skyMesh, OBJ_NEAREST_BUF);
 
+#ifndef KSTARS_LITE
+    // Only the nearest star is built as a StarObject
+    std::shared_ptr<StarBlock> bestBlock;
+    int bestIndex = 0;
+    SkyPoint point;
+#endif
+
     while (region.hasNext())
     {
         Trixel currentRegion = region.next();
@@ -531,9 +603,6 @@ SkyObject *DeepStarComponent::objectNearest(SkyPoint *p, double &maxrad)
             {
 #ifdef KSTARS_LITE
                 StarObject *star = &(block->star(j)->star);
-#else
-                StarObject *star = block->star(j);
-#endif
                 if (!star)
                     continue;
                 if (star->mag() > m_zoomMagLimit)
@@ -545,10 +614,29 @@ SkyObject *DeepStarComponent::objectNearest(SkyPoint *p, double &maxrad)
                     oBest  = star;
                     maxrad = r;
                 }
+#else
+                const CompactStar &star = block->entry(j);
+                if (star.mag > m_zoomMagLimit)
+                    continue;
+
+                star.toSkyPoint(point);
+                double r = point.angularDistanceTo(p).Degrees();
+                if (r < maxrad)
+                {
+                    bestBlock = block;
+                    bestIndex = j;
+                    maxrad    = r;
+                }
+#endif
             }
         }
     }
 
+#ifndef KSTARS_LITE
+    if (bestBlock)
+        oBest = bestBlock->star(bestIndex);
+#endif
+
     // TODO: What if we are looking around a point that's not on
     // screen? objectNearest() will need to keep on filling up all
     // trixels around the SkyPoint to find the best match in case it
@@ -581,6 +669,10 @@ bool DeepStarComponent::starsInAperture(QList<StarObject *> &list, const SkyPoin
     if (maglim < -28)
         maglim = m_FaintMagnitude;
 
+#ifndef KSTARS_LITE
+    SkyPoint point;
+#endif
+
     while (region.hasNext())
     {
         Trixel currentRegion = region.next();
@@ -595,13 +687,19 @@ bool DeepStarComponent::starsInAperture(QList<StarObject *> &list, const SkyPoin
             {
 #ifdef KSTARS_LITE
                 StarObject *star = &(block->star(j)->star);
-#else
-                StarObject *star = block->star(j);
-#endif
                 if (star->mag() > maglim)
                     break; // Stars are organized by magnitude, so this should work
                 if (star->angularDistanceTo(&center).Degrees() <= radius)
                     list.append(star);
+#else
+                // Only the stars in the aperture are built as StarObjects
+                const CompactStar &star = block->entry(j);
+                if (star.mag > maglim)
+                    break; // Stars are organized by magnitude, so this should work
+                star.toSkyPoint(point);
+                if (point.angularDistanceTo(&center).Degrees() <= radius)
+                    list.append(block->star(j));
+#endif
             }
         }
     }
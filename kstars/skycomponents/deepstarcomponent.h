@@ -30,9 +30,12 @@
 #include "ksnumbers.h"
 #include "listcomponent.h"
 #include "starblockfactory.h"
+#include "typedef.h"
 #include "skyobjects/deepstardata.h"
 #include "skyobjects/stardata.h"
 
+#include <QFutureWatcher>
+
 class SkyLabeler;
 class SkyMesh;
 class StarBlockFactory;
@@ -113,6 +116,21 @@ class DeepStarComponent : public ListComponent
     static StarBlockFactory m_StarBlockFactory;
 
   private:
+    /// Records of one trixel to read from the data file
+    struct TrixelRead
+    {
+        Trixel trixel { 0 };
+        long offset { 0 };
+        int size { 0 };
+        QByteArray records;
+    };
+
+    /** @short Reads the records of some trixels from the data file on a worker thread */
+    void startReads(const QVector<TrixelRead> &reads);
+
+    /** @short Hands the records read by startReads() over to their StarBlockLists and redraws the sky map */
+    void processReads();
+
     SkyMesh *m_skyMesh { nullptr };
     KSNumbers m_reindexNum;
 
@@ -142,4 +160,7 @@ class DeepStarComponent : public ListComponent
     StarData stardata;
     BinFileHelper starReader;
     QString dataFileName;
+    /// Full path of the data file, for the reads done on a worker thread
+    QString dataFilePath;
+    QFutureWatcher<QVector<TrixelRead>> m_ReadWatcher;
 };
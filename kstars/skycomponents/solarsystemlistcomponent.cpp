@@ -29,6 +29,7 @@
 #include <KLocalizedString>
 
 #include <QPen>
+#include <QtConcurrent>
 
 SolarSystemListComponent::SolarSystemListComponent(SolarSystemComposite *p) : ListComponent(p), m_Earth(p->earth())
 {
@@ -57,18 +58,66 @@ void SolarSystemListComponent::update(KSNumbers *)
 
 void SolarSystemListComponent::updateSolarSystemBodies(KSNumbers *num)
 {
-    if (selected())
+    if (!selected())
+        return;
+
+    KStarsData *data = KStarsData::Instance();
+    const CachingDms *lat = data->geo()->lat();
+    const CachingDms *LST = data->lst();
+
+    // Small lists (planets, few comets) are not worth spreading over threads
+    if (m_ObjectList.size() < MIN_PARALLEL_BODIES)
     {
-        KStarsData *data = KStarsData::Instance();
-        foreach (SkyObject *o, m_ObjectList)
+        for (SkyObject *o : m_ObjectList)
         {
-            KSPlanetBase *p = (KSPlanetBase *)o;
-            p->findPosition(num, data->geo()->lat(), data->lst(), m_Earth);
-            p->EquatorialToHorizontal(data->lst(), data->geo()->lat());
+            KSPlanetBase *p = static_cast<KSPlanetBase *>(o);
+            p->findPosition(num, lat, LST, m_Earth);
+            p->EquatorialToHorizontal(LST, lat);
 
             if (p->hasTrail())
-                p->updateTrail(data->lst(), data->geo()->lat());
+                p->updateTrail(LST, lat);
         }
+        return;
+    }
+
+    // Bodies without a trail only touch their own state, so the list is split in bands over the
+    // available threads. Bodies with a trail share the trail list and are updated afterwards.
+    const int nThreads = QThread::idealThreadCount();
+    const int tStride  = m_ObjectList.size() / nThreads;
+    const int fStride  = m_ObjectList.size() - tStride * (nThreads - 1);
+
+    QList<QFuture<void>> futures;
+    for (int i = 0; i < nThreads; i++)
+    {
+        const int cStart = i * tStride;
+        const int cEnd   = cStart + ((i == (nThreads - 1)) ? fStride : tStride);
+
+        futures.append(QtConcurrent::run([this, num, lat, LST, cStart, cEnd]()
+        {
+            for (int j = cStart; j < cEnd; j++)
+            {
+                KSPlanetBase *p = static_cast<KSPlanetBase *>(m_ObjectList.at(j));
+                if (p->hasTrail())
+                    continue;
+
+                p->findPosition(num, lat, LST, m_Earth);
+                p->EquatorialToHorizontal(LST, lat);
+            }
+        }));
+    }
+
+    for (QFuture<void> &future : futures)
+        future.waitForFinished();
+
+    for (SkyObject *o : m_ObjectList)
+    {
+        KSPlanetBase *p = static_cast<KSPlanetBase *>(o);
+        if (!p->hasTrail())
+            continue;
+
+        p->findPosition(num, lat, LST, m_Earth);
+        p->EquatorialToHorizontal(LST, lat);
+        p->updateTrail(LST, lat);
     }
 }
 
@@ -41,6 +41,8 @@ class SolarSystemListComponent : public ListComponent
      * @short Update the coordinates of the solar system bodies in this component.
      *
      * This function updates the position of the moving solar system bodies.
+     * Long lists such as the asteroids are updated in parallel, bodies with a trail are
+     * always updated on the calling thread.
      * @p data Pointer to the KStarsData object
      * @p num Pointer to the KSNumbers object
      */
@@ -50,5 +52,8 @@ class SolarSystemListComponent : public ListComponent
     void drawTrails(SkyPainter *skyp) override;
 
   private:
+    /** Lists shorter than this are updated serially */
+    static constexpr int MIN_PARALLEL_BODIES { 1000 };
+
     KSPlanet *m_Earth { nullptr };
 };
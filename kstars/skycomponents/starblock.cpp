@@ -23,6 +23,33 @@
 #include "skyobjects/stardata.h"
 #include "skyobjects/deepstardata.h"
 
+#ifndef KSTARS_LITE
+#include "kstarsdata.h"
+#include "nan.h"
+#include "Options.h"
+
+#include <cmath>
+
+namespace
+{
+// Magnitude as stored by SkyObject::setMag()
+float sortMagnitude(float mag)
+{
+    return mag < 36.0 ? mag : NaN::f;
+}
+
+// Catalog coordinates, as in StarObject::init()
+void setCatalogCoordinates(CompactStar &star, qint32 RA, qint32 Dec)
+{
+    CachingDms ra, dec;
+
+    ra.setH(RA / 1000000.0);
+    dec.setD(Dec / 100000.0);
+    star.setRADec(ra, dec);
+}
+}
+#endif
+
 #ifdef KSTARS_LITE
 #include "skymaplite.h"
 #include "kstarslite/skyitems/skynodes/pointsourcenode.h"
@@ -46,7 +73,7 @@ StarBlock::StarBlock(int nstars)
 #ifdef KSTARS_LITE
       stars(nstars, StarNode())
 #else
-      stars(nstars, StarObject())
+      stars(nstars)
 #endif
 {
 }
@@ -60,6 +87,16 @@ void StarBlock::reset()
     faintMag  = -5.0;
     brightMag = 35.0;
     nStars    = 0;
+#ifndef KSTARS_LITE
+    updateID      = 0;
+    nUpdated      = 0;
+    updateNumID   = 0;
+    nNumUpdated   = 0;
+    lastPrecessJD = J2000;
+    nPrecessed    = 0;
+    // The StarObjects still hold the names, magnitudes and HD numbers of the evicted stars
+    objects.clear();
+#endif
 }
 
 #ifdef KSTARS_LITE
@@ -93,31 +130,172 @@ StarNode *StarBlock::addStar(const DeepStarData &data)
     return &node;
 }
 #else
-StarObject *StarBlock::addStar(const StarData &data)
+CompactStar *StarBlock::addStar(const StarData &data)
 {
     if (isFull())
         return nullptr;
-    StarObject &star = stars[nStars++];
+    if (records.isEmpty())
+        records.resize(stars.size());
+    records[nStars]   = data;
+    CompactStar &star = stars[nStars++];
 
-    star.init(&data);
-    if (star.mag() > faintMag)
-        faintMag = star.mag();
-    if (star.mag() < brightMag)
-        brightMag = star.mag();
+    // As in StarObject::init()
+    setCatalogCoordinates(star, data.RA, data.Dec);
+    star.mag    = sortMagnitude(data.mag / 100.0);
+    star.spchar = data.spec_type[0];
+
+    if (star.mag > faintMag)
+        faintMag = star.mag;
+    if (star.mag < brightMag)
+        brightMag = star.mag;
     return &star;
 }
 
-StarObject *StarBlock::addStar(const DeepStarData &data)
+CompactStar *StarBlock::addStar(const DeepStarData &data)
 {
     if (isFull())
         return nullptr;
-    StarObject &star = stars[nStars++];
+    CompactStar &star = stars[nStars++];
 
-    star.init(&data);
-    if (star.mag() > faintMag)
-        faintMag = star.mag();
-    if (star.mag() < brightMag)
-        brightMag = star.mag();
+    // As in StarObject::init()
+    star.data = data;
+    setCatalogCoordinates(star, data.RA, data.Dec);
+    if (data.V == 30000 && data.B != 30000)
+        star.mag = sortMagnitude((data.B - 1600) / 1000.0);
+    else
+        star.mag = sortMagnitude(data.V / 1000.0);
+
+    star.spchar = 'B';
+    if (data.B == 30000 || data.V == 30000)
+    {
+        star.spchar = '?';
+    }
+    else
+    {
+        double BV_Index = (data.B - data.V) / 1000.0;
+        if (BV_Index > 0.0) star.spchar = 'A';
+        if (BV_Index > 0.325) star.spchar = 'F';
+        if (BV_Index > 0.575) star.spchar = 'G';
+        if (BV_Index > 0.975) star.spchar = 'K';
+        if (BV_Index > 1.6) star.spchar = 'M';
+    }
+
+    if (star.mag > faintMag)
+        faintMag = star.mag;
+    if (star.mag < brightMag)
+        brightMag = star.mag;
     return &star;
 }
+
+void StarBlock::updateStars(float maglim)
+{
+    static KStarsData *data = KStarsData::Instance();
+    const KSNumbers *num    = data->updateNum();
+
+    if (updateNumID != data->updateNumID())
+    {
+        updateNumID = data->updateNumID();
+        nNumUpdated = 0;
+        nUpdated    = 0;
+        // Update is once per solar minute, as in StarObject::JITupdate()
+        if (Options::alwaysRecomputeCoordinates() || std::abs(lastPrecessJD - num->getJD()) >= 0.00069444)
+        {
+            lastPrecessJD = num->getJD();
+            nPrecessed    = 0;
+        }
+    }
+    if (updateID != data->updateID())
+    {
+        updateID = data->updateID();
+        nUpdated = 0;
+    }
+
+    const bool relativistic = Options::useRelativistic();
+    // Scratch objects for the coordinate computations, only constructed when needed
+    std::unique_ptr<StarObject> object;
+    SkyPoint point;
+
+    const int first = nUpdated;
+    int i           = first;
+    for (; i < nStars; ++i)
+    {
+        CompactStar &star = stars[i];
+
+        if (i >= nNumUpdated)
+        {
+            bool recompute = (i >= nPrecessed);
+            if (!recompute && relativistic)
+            {
+                star.toSkyPoint(point);
+                recompute = point.checkBendLight();
+            }
+
+            if (recompute)
+            {
+                if (!object)
+                    object.reset(new StarObject());
+                if (records.isEmpty())
+                    object->init(&star.data);
+                else
+                    object->init(&records[i]);
+                // Light bending is checked on the current coordinates of the star
+                star.toSkyPoint(*object);
+                object->updateCoords(num);
+                star.setRADec(object->ra(), object->dec());
+                if (i == nPrecessed)
+                    ++nPrecessed;
+            }
+        }
+
+        star.toSkyPoint(point);
+        point.EquatorialToHorizontal(data->lst(), data->geo()->lat());
+        star.alt = point.alt().Degrees();
+        star.az  = point.az().Degrees();
+
+        if (star.mag > maglim)
+        {
+            ++i;
+            break;
+        }
+    }
+
+    nUpdated = i;
+    if (nNumUpdated < i)
+        nNumUpdated = i;
+
+    // Keep the StarObjects handed out by star() up to date, as the stars themselves used to be
+    for (int j = first; j < i && j < static_cast<int>(objects.size()); ++j)
+    {
+        if (objects[j])
+            syncObject(j);
+    }
+}
+
+StarObject *StarBlock::star(int i)
+{
+    if (objects.empty())
+        objects.resize(stars.size());
+
+    std::unique_ptr<StarObject> &object = objects[i];
+    if (!object)
+        object.reset(new StarObject());
+
+    if (records.isEmpty())
+        object->init(&stars[i].data);
+    else
+        object->init(&records[i]);
+    syncObject(i);
+
+    return object.get();
+}
+
+void StarBlock::syncObject(int i)
+{
+    StarObject *object = objects[i].get();
+    const CompactStar &star = stars[i];
+
+    star.toSkyPoint(*object);
+    object->updateID    = (i < nUpdated) ? updateID : 0;
+    object->updateNumID = (i < nNumUpdated) ? updateNumID : 0;
+}
 #endif
@@ -19,14 +19,19 @@
 
 #include "typedef.h"
 #include "starblocklist.h"
+#include "skyobjects/deepstardata.h"
+#include "skyobjects/skypoint.h"
+#include "skyobjects/stardata.h"
+#include "nan.h"
 
 #include <QVector>
 
+#include <memory>
+#include <vector>
+
 class StarObject;
 class StarBlockList;
 class PointSourceNode;
-struct StarData;
-struct DeepStarData;
 
 #ifdef KSTARS_LITE
 #include "starobject.h"
@@ -39,6 +44,42 @@ struct StarNode
     StarObject star;
     PointSourceNode *starNode;
 };
+#else
+/**
+ * @short Compact storage of an unnamed star in a StarBlock
+ *
+ * Holds the catalog record of the star and the coordinates needed to draw it, as plain values instead
+ * of the angle objects of a StarObject. StarObjects are only built for the stars that are looked up,
+ * see StarBlock::star().
+ */
+struct CompactStar
+{
+    /** @short Sets the coordinates of point to those of this star */
+    inline void toSkyPoint(SkyPoint &point) const
+    {
+        point.setRA(CachingDms::fromSinCos(ra, sinRA, cosRA));
+        point.setDec(CachingDms::fromSinCos(dec, sinDec, cosDec));
+        point.setAlt(alt);
+        point.setAz(az);
+    }
+
+    /** @short Sets the equatorial coordinates of this star, keeping their sines and cosines */
+    inline void setRADec(const CachingDms &r, const CachingDms &d)
+    {
+        ra = r.Degrees();
+        r.SinCos(sinRA, cosRA);
+        dec = d.Degrees();
+        d.SinCos(sinDec, cosDec);
+    }
+
+    double ra { NaN::d }, dec { NaN::d };       ///< Current true sky coordinates, in degrees
+    double sinRA { NaN::d }, cosRA { NaN::d };   ///< Cached once per coordinate update, as CachingDms does
+    double sinDec { NaN::d }, cosDec { NaN::d };
+    double alt { NaN::d }, az { NaN::d };       ///< Horizontal coordinates at the last update, in degrees
+    DeepStarData data;                          ///< Catalog record of deep star catalogs
+    float mag { 0 };
+    char spchar { 'A' };
+};
 #endif
 
 /**
@@ -57,7 +98,7 @@ class StarBlock
 #ifdef KSTARS_LITE
     typedef StarNode StarBlockEntry;
 #else
-    typedef StarObject StarBlockEntry;
+    typedef CompactStar StarBlockEntry;
 #endif
 
     /**
@@ -84,6 +125,23 @@ class StarBlock
     StarBlockEntry *addStar(const StarData &data);
     StarBlockEntry *addStar(const DeepStarData &data);
 
+#ifndef KSTARS_LITE
+    /**
+     * @short Brings the coordinates of the stars up to the current time and location
+     *
+     * Does what StarObject::JITupdate() does for each star, for the stars up to the first one
+     * fainter than maglim. Stars already updated for the current updateID are skipped.
+     *
+     * @param maglim Magnitude limit of the stars to update
+     */
+    void updateStars(float maglim);
+
+    /**
+     * @short  Return the compact entry of the i-th star in this StarBlock
+     */
+    inline const CompactStar &entry(int i) const { return stars[i]; }
+#endif
+
     /**
      * @short Returns true if the StarBlock is full
      *
@@ -102,6 +160,7 @@ class StarBlock
      */
     inline int size() const { return stars.size(); }
 
+#ifdef KSTARS_LITE
     /**
      * @short  Return the i-th star in this StarBlock
      *
@@ -117,6 +176,18 @@ class StarBlock
      */
 
     inline QVector<StarBlockEntry> &contents() { return stars; }
+#else
+    /**
+     * @short  Return the i-th star in this StarBlock
+     *
+     * The StarObject is built from the compact entry of the star on the first call, and kept until
+     * the StarBlock is reset() for reuse, which deletes it.
+     *
+     * @param  i Index of StarBlock to return
+     * @return A pointer to the i-th StarObject
+     */
+    StarObject *star(int i);
+#endif
 
     // These methods are there because we might want to make faintMag and brightMag private at some point
     /**
@@ -159,4 +230,22 @@ class StarBlock
     int nStars { 0 };
     /** Array of stars. */
     QVector<StarBlockEntry> stars;
+#ifndef KSTARS_LITE
+    /// Copies the coordinates of the i-th entry to its StarObject
+    void syncObject(int i);
+
+    /// Catalog records of shallow star catalogs, empty for deep star catalogs
+    QVector<StarData> records;
+    /// StarObjects built by star(), by index
+    std::vector<std::unique_ptr<StarObject>> objects;
+    /// The first nUpdated stars are up to date for updateID
+    quint64 updateID { 0 };
+    int nUpdated { 0 };
+    /// The first nNumUpdated stars are up to date for updateNumID
+    quint64 updateNumID { 0 };
+    int nNumUpdated { 0 };
+    /// The first nPrecessed stars were precessed to lastPrecessJD
+    double lastPrecessJD { J2000 };
+    int nPrecessed { 0 };
+#endif
 };
@@ -29,6 +29,8 @@
 
 #include <QDebug>
 
+#include <cstring>
+
 StarBlockList::StarBlockList(const Trixel &tr, DeepStarComponent *parent)
 {
     trixel       = tr;
@@ -56,6 +58,7 @@ int StarBlockList::releaseBlock(StarBlock *block)
 #endif
         blocks.removeLast();
         nBlocks--;
+        readAhead.clear();
         nStars -= block->getStarCount();
 
         readOffset -= parent->getStarReader()->guessRecordSize() * block->getStarCount();
@@ -70,18 +73,69 @@ int StarBlockList::releaseBlock(StarBlock *block)
     return 0;
 }
 
+bool StarBlockList::addRecord(const char *record)
+{
+    StarBlockFactory *SBFactory = StarBlockFactory::Instance();
+    BinFileHelper *dSReader     = parent->getStarReader();
+
+    if (nBlocks == 0 || blocks[nBlocks - 1]->isFull())
+    {
+        std::shared_ptr<StarBlock> newBlock = SBFactory->getBlock();
+
+        if (!newBlock.get())
+        {
+            qWarning() << "ERROR: Could not get a new block from StarBlockFactory::getBlock() in trixel " << trixel
+                       << ", while trying to create block #" << nBlocks + 1;
+            return false;
+        }
+        blocks.append(newBlock);
+        blocks[nBlocks]->parent = this;
+        if (nBlocks == 0)
+            SBFactory->markFirst(blocks[0]);
+        else if (!SBFactory->markNext(blocks[nBlocks - 1], blocks[nBlocks]))
+            qWarning() << "ERROR: markNext() failed on block #" << nBlocks + 1 << "in trixel" << trixel;
+
+        ++nBlocks;
+    }
+    // TODO: Make this more general
+    if (dSReader->guessRecordSize() == 32)
+    {
+        StarData stardata;
+        memcpy(&stardata, record, sizeof(StarData));
+        if (dSReader->getByteSwap())
+            DeepStarComponent::byteSwap(&stardata);
+        readOffset += sizeof(StarData);
+        blocks[nBlocks - 1]->addStar(stardata);
+    }
+    else
+    {
+        DeepStarData deepstardata;
+        memcpy(&deepstardata, record, sizeof(DeepStarData));
+        if (dSReader->getByteSwap())
+            DeepStarComponent::byteSwap(&deepstardata);
+        readOffset += sizeof(DeepStarData);
+        blocks[nBlocks - 1]->addStar(deepstardata);
+    }
+
+    /*
+      if( faintMag > -5.0 && fabs(faintMag - blocks[nBlocks - 1]->getFaintMag()) > 0.2 ) {
+      qDebug() << "Encountered a jump from mag" << faintMag << "to mag"
+      << blocks[nBlocks - 1]->getFaintMag() << "in trixel" << trixel;
+      }
+    */
+    faintMag = blocks[nBlocks - 1]->getFaintMag();
+    nStars++;
+    return true;
+}
+
 bool StarBlockList::fillToMag(float maglim)
 {
     // TODO: Remove staticity of BinFileHelper
     BinFileHelper *dSReader;
-    StarBlockFactory *SBFactory;
-    StarData stardata;
-    DeepStarData deepstardata;
     FILE *dataFile;
 
     dSReader  = parent->getStarReader();
     dataFile  = dSReader->getFileHandle();
-    SBFactory = StarBlockFactory::Instance();
 
     if (staticStars)
         return false;
@@ -103,6 +157,10 @@ bool StarBlockList::fillToMag(float maglim)
 
     Q_ASSERT(nBlocks == (unsigned int)blocks.size());
 
+    // Use whatever was read ahead first
+    if (fillFromReadAhead(maglim))
+        return ((maglim < faintMag) ? true : false);
+
     BinFileHelper::unsigned_KDE_fseek(dataFile, readOffset, SEEK_SET);
 
     /*
@@ -111,58 +169,67 @@ bool StarBlockList::fillToMag(float maglim)
              << "to maglim =" << maglim << "with current faintMag =" << faintMag;
     */
 
+    const int recordSize = dSReader->guessRecordSize() == 32 ? sizeof(StarData) : sizeof(DeepStarData);
+    char record[sizeof(StarData)];
     while (maglim >= faintMag && nStars < dSReader->getRecordCount(trixelId))
     {
-        int ret = 0;
+        if (fread(record, recordSize, 1, dataFile) != 1)
+            qDebug() << "Could not read star record #" << nStars << "in trixel" << trixel;
 
-        if (nBlocks == 0 || blocks[nBlocks - 1]->isFull())
-        {
-            std::shared_ptr<StarBlock> newBlock = SBFactory->getBlock();
+        if (!addRecord(record))
+            return false;
+    }
 
-            if (!newBlock.get())
-            {
-                qWarning() << "ERROR: Could not get a new block from StarBlockFactory::getBlock() in trixel " << trixel
-                           << ", while trying to create block #" << nBlocks + 1;
-                return false;
-            }
-            blocks.append(newBlock);
-            blocks[nBlocks]->parent = this;
-            if (nBlocks == 0)
-                SBFactory->markFirst(blocks[0]);
-            else if (!SBFactory->markNext(blocks[nBlocks - 1], blocks[nBlocks]))
-                qWarning() << "ERROR: markNext() failed on block #" << nBlocks + 1 << "in trixel" << trixel;
-
-            ++nBlocks;
-        }
-        // TODO: Make this more general
-        if (dSReader->guessRecordSize() == 32)
-        {
-            ret = fread(&stardata, sizeof(StarData), 1, dataFile);
-            if (dSReader->getByteSwap())
-                DeepStarComponent::byteSwap(&stardata);
-            readOffset += sizeof(StarData);
-            blocks[nBlocks - 1]->addStar(stardata);
-        }
-        else
-        {
-            ret = fread(&deepstardata, sizeof(DeepStarData), 1, dataFile);
-            if (dSReader->getByteSwap())
-                DeepStarComponent::byteSwap(&deepstardata);
-            readOffset += sizeof(DeepStarData);
-            blocks[nBlocks - 1]->addStar(deepstardata);
-        }
+    return ((maglim < faintMag) ? true : false);
+}
 
-        /*
-          if( faintMag > -5.0 && fabs(faintMag - blocks[nBlocks - 1]->getFaintMag()) > 0.2 ) {
-          qDebug() << "Encountered a jump from mag" << faintMag << "to mag"
-          << blocks[nBlocks - 1]->getFaintMag() << "in trixel" << trixel;
-          }
-        */
-        faintMag = blocks[nBlocks - 1]->getFaintMag();
-        nStars++;
+bool StarBlockList::fillFromReadAhead(float maglim)
+{
+    if (staticStars || faintMag >= maglim)
+        return true;
+
+    BinFileHelper *dSReader = parent->getStarReader();
+    const int recordSize = dSReader->guessRecordSize() == 32 ? sizeof(StarData) : sizeof(DeepStarData);
+    char record[sizeof(StarData)];
+    int used = 0;
+
+    nextReadOffset();
+    while (maglim >= faintMag && nStars < dSReader->getRecordCount(trixel))
+    {
+        // Getting a new block may release a block of this list, which drops the read ahead records
+        if (used + recordSize > readAhead.size())
+            break;
+
+        memcpy(record, readAhead.constData() + used, recordSize);
+        if (!addRecord(record))
+            break;
+        used += recordSize;
     }
+    readAhead.remove(0, used);
 
-    return ((maglim < faintMag) ? true : false);
+    return (maglim < faintMag || nStars >= dSReader->getRecordCount(trixel));
+}
+
+bool StarBlockList::setReadAhead(long offset, const QByteArray &records)
+{
+    if (offset != nextReadOffset() || records.isEmpty())
+        return false;
+
+    readAhead = records;
+    return true;
+}
+
+long StarBlockList::nextReadOffset()
+{
+    if (readOffset <= 0)
+        readOffset = parent->getStarReader()->getOffset(trixel);
+
+    return readOffset;
+}
+
+quint64 StarBlockList::remainingRecords() const
+{
+    return parent->getStarReader()->getRecordCount(trixel) - nStars;
 }
 
 void StarBlockList::setStaticBlock(std::shared_ptr<StarBlock> &block)
@@ -19,6 +19,8 @@
 
 #include "typedef.h"
 
+#include <QByteArray>
+
 class DeepStarComponent;
 class StarBlock;
 
@@ -48,6 +50,37 @@ class StarBlockList
      */
     bool fillToMag(float maglim);
 
+    /**
+     * @short Fills the list to the given magnitude limit with the records read ahead, without any disk access
+     *
+     * @param maglim Magnitude limit to load stars upto
+     * @return true if the list reaches maglim or holds all the stars of the trixel, false if
+     * more records must be read from nextReadOffset() first
+     */
+    bool fillFromReadAhead(float maglim);
+
+    /**
+     * @short Sets records read from the data file, starting at the given offset, to be used by fillFromReadAhead()
+     *
+     * The records are dropped if the list no longer continues at that offset, e.g. because blocks
+     * were released while they were read.
+     *
+     * @param offset Offset in the data file of the first record
+     * @param records Raw records, as stored in the data file
+     * @return true if the records were kept
+     */
+    bool setReadAhead(long offset, const QByteArray &records);
+
+    /**
+     * @return Offset in the data file of the next record to load
+     */
+    long nextReadOffset();
+
+    /**
+     * @return Number of records of the trixel that are not loaded yet
+     */
+    quint64 remainingRecords() const;
+
     /**
      * @short Sets the first StarBlock in the list to point to the given StarBlock
      *
@@ -104,6 +137,12 @@ class StarBlockList
     inline Trixel getTrixel() const { return trixel; }
 
   private:
+    /**
+     * @short Appends one raw record to the last block, adding a block if needed
+     * @return false if no block could be added
+     */
+    bool addRecord(const char *record);
+
     Trixel trixel;
     unsigned long nStars { 0 };
     long readOffset { 0 };
@@ -112,4 +151,6 @@ class StarBlockList
     unsigned int nBlocks { 0 };
     bool staticStars { false };
     DeepStarComponent *parent { nullptr };
+    /// Records read ahead from the data file, starting at readOffset
+    QByteArray readAhead;
 };
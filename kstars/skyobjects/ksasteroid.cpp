@@ -151,7 +151,7 @@ bool KSAsteroid::findGeocentricPosition(const KSNumbers *num, const KSPlanetBase
     // So we have to precess as well
     setRA0(ra());
     setDec0(dec());
-    apparentCoord(J2000, lastPrecessJD);
+    findApparentPosition(num);
     //nutate(num);
     //aberrate(num);
 
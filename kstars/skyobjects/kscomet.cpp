@@ -295,7 +295,7 @@ bool KSComet::findGeocentricPosition(const KSNumbers *num, const KSPlanetBase *E
     // So we have to precess as well
     setRA0(ra());
     setDec0(dec());
-    apparentCoord(J2000, lastPrecessJD);
+    findApparentPosition(num);
 
     //nutate(num);
     //aberrate(num);
@@ -334,7 +334,7 @@ bool KSPlanet::findGeocentricPosition(const KSNumbers *num, const KSPlanetBase *
 
         setRA0(ra());
         setDec0(dec());
-        apparentCoord(J2000, lastPrecessJD);
+        findApparentPosition(num);
 
         //nutate(num);
         //aberrate(num);
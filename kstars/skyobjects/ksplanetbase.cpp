@@ -152,6 +152,22 @@ void KSPlanetBase::findPosition(const KSNumbers *num, const CachingDms *lat, con
     }
 }
 
+void KSPlanetBase::findApparentPosition(const KSNumbers *num)
+{
+    // Building a KSNumbers is expensive, and apparentCoord() builds two of them
+    if (num->julianDay() != lastPrecessJD)
+    {
+        apparentCoord(J2000, lastPrecessJD);
+        return;
+    }
+
+    precess(num);
+    nutate(num);
+    if (Options::useRelativistic() && checkBendLight())
+        bendlight();
+    aberrate(num);
+}
+
 bool KSPlanetBase::isMajorPlanet() const
 {
     if (name() == i18n("Mercury") || name() == i18n("Venus") || name() == i18n("Mars") || name() == i18n("Jupiter") ||
@@ -211,13 +227,17 @@ void KSPlanetBase::setRearth(const KSPlanetBase *Earth)
     double cosL, cosB, cosL0, cosB0;
     double x, y, z;
 
+    // Translated once, this is called for every solar system body on each update
+    static const QString moonName  = i18n("Moon");
+    static const QString earthName = i18n("Earth");
+
     //The Moon's Rearth is set in its findGeocentricPosition()...
-    if (name() == i18n("Moon"))
+    if (name() == moonName)
     {
         return;
     }
 
-    if (name() == i18n("Earth"))
+    if (name() == earthName)
     {
         Rearth = 0.0;
         return;
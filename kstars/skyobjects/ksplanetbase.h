@@ -244,6 +244,14 @@ class KSPlanetBase : public TrailObject
      */
     virtual bool findGeocentricPosition(const KSNumbers *num, const KSPlanetBase *Earth = nullptr) = 0;
 
+    /**
+     * @short Precess, nutate and aberrate the J2000 coordinates (RA0, Dec0) to lastPrecessJD.
+     * When num is already for lastPrecessJD it is reused, otherwise this falls back to
+     * apparentCoord(), which builds its own KSNumbers.
+     * @param num pointer to current KSNumbers object
+     */
+    void findApparentPosition(const KSNumbers *num);
+
     /**
      * @short Computes the visual magnitude for the major planets.
      * @param num pointer to a ksnumbers object. Needed for the saturn rings contribution to
@@ -714,16 +714,71 @@ void Satellite::init()
     }
 }
 
-int Satellite::updatePos()
+Satellite::Observer Satellite::currentObserver()
 {
     KStarsData *data = KStarsData::Instance();
-    return sgp4((data->clock()->utc().djd() - m_tle_jd) * MINPD);
+    Observer observer;
+
+    observer.jd  = data->clock()->utc().djd();
+    observer.lat = data->geo()->lat();
+    observer.lst = data->lst();
+
+    double jul_utc = observer.jd;
+
+    // Observer ECI position
+    observer.sinlat   = sin(observer.lat->radians());
+    observer.coslat   = cos(observer.lat->radians());
+    double thetageo   = data->geo()->LMST(jul_utc);
+    observer.sintheta = sin(thetageo);
+    observer.costheta = cos(thetageo);
+    double c          = 1.0 / sqrt(1.0 + F * (F - 2.0) * observer.sinlat * observer.sinlat);
+    double sq         = (1.0 - F) * (1.0 - F) * c;
+    double achcp      = (RADIUSEARTHKM * c + MEANALT) * observer.coslat;
+    observer.posx     = achcp * observer.costheta;
+    observer.posy     = achcp * observer.sintheta;
+    observer.posz     = (RADIUSEARTHKM * sq + MEANALT) * observer.sinlat;
+
+    // Find ECI coordinates of the sun
+    double mjd, year, T, M, L, e, C, O, Lsa, nu, R, eps;
+
+    mjd  = jul_utc - 2415020.0;
+    year = 1900.0 + mjd / 365.25;
+    T    = (mjd + deltaET(year) / (MINPD * 60.0)) / 36525.0;
+    M    = DEG2RAD * (Modulus(358.47583 + Modulus(35999.04975 * T, 360.0) - (0.000150 + 0.0000033 * T) * T * T, 360.0));
+    L    = DEG2RAD * (Modulus(279.69668 + Modulus(36000.76892 * T, 360.0) + 0.0003025 * T * T, 360.0));
+    e    = 0.01675104 - (0.0000418 + 0.000000126 * T) * T;
+    C    = DEG2RAD * ((1.919460 - (0.004789 + 0.000014 * T) * T) * sin(M) + (0.020094 - 0.000100 * T) * sin(2 * M) +
+                      0.000293 * sin(3 * M));
+    O    = DEG2RAD * (Modulus(259.18 - 1934.142 * T, 360.0));
+    Lsa  = Modulus(L + C - DEG2RAD * (0.00569 - 0.00479 * sin(O)), TWOPI);
+    nu   = Modulus(M + C, TWOPI);
+    R    = 1.0000002 * (1.0 - e * e) / (1.0 + e * cos(nu));
+    eps  = DEG2RAD * (23.452294 - (0.0130125 + (0.00000164 - 0.000000503 * T) * T) * T + 0.00256 * cos(O));
+    R    = AU * R;
+
+    observer.sun_posx = R * cos(Lsa);
+    observer.sun_posy = R * sin(Lsa) * cos(eps);
+    observer.sun_posz = R * sin(Lsa) * sin(eps);
+    observer.sun_posw = R;
+
+    KSSun *sun       = dynamic_cast<KSSun *>(data->skyComposite()->findByName(i18n("Sun")));
+    observer.sun_alt = sun->alt().Degrees();
+
+    return observer;
 }
 
-int Satellite::sgp4(double tsince)
+int Satellite::updatePos()
 {
-    KStarsData *data = KStarsData::Instance();
+    return updatePos(currentObserver());
+}
+
+int Satellite::updatePos(const Observer &observer)
+{
+    return sgp4((observer.jd - m_tle_jd) * MINPD, observer);
+}
 
+int Satellite::sgp4(double tsince, const Observer &observer)
+{
     int ktr;
     double am, axnl, aynl, betal, cosim, cnod, cos2u, coseo1 = 0, cosi, cosip, cosisq, cossu, cosu, delm, delomg, em,
                                                       ecose, el2, eo1, ep, esine, argpm, argpp, argpdf, pl,
@@ -731,13 +786,11 @@ int Satellite::sgp4(double tsince)
                                                       t3, t4, tem5, temp, temp1, temp2, tempa, tempe, templ, u, ux, uy, uz, vx, vy, vz, inclm, mm, nm, nodem, xinc,
                                                       xincp, xl, xlm, mp, xmdf, xmx, xmy, nodedf, xnode, nodep, tc, sat_posx, sat_posy, sat_posz, sat_posw, sat_velx,
                                                       sat_vely, sat_velz, sinlat, obs_posx, obs_posy, obs_posz, obs_posw, /*obs_velx, obs_vely, obs_velz,*/
-                                                      coslat, thetageo, sintheta, costheta, c, sq, achcp, vkmpersec;
+                                                      coslat, sintheta, costheta, vkmpersec;
     //    double emsq;
 
     const double temp4 = 1.5e-12;
 
-    double jul_utc = data->clock()->utc().djd();
-
     vkmpersec = RADIUSEARTHKM * XKE / 60.0;
 
     // Update for secular gravity and atmospheric drag
@@ -1147,17 +1200,13 @@ int Satellite::sgp4(double tsince)
     }
 
     // Observer ECI position and velocity
-    sinlat   = sin(data->geo()->lat()->radians());
-    coslat   = cos(data->geo()->lat()->radians());
-    thetageo = data->geo()->LMST(jul_utc);
-    sintheta = sin(thetageo);
-    costheta = cos(thetageo);
-    c        = 1.0 / sqrt(1.0 + F * (F - 2.0) * sinlat * sinlat);
-    sq       = (1.0 - F) * (1.0 - F) * c;
-    achcp    = (RADIUSEARTHKM * c + MEANALT) * coslat;
-    obs_posx = achcp * costheta;
-    obs_posy = achcp * sintheta;
-    obs_posz = (RADIUSEARTHKM * sq + MEANALT) * sinlat;
+    sinlat   = observer.sinlat;
+    coslat   = observer.coslat;
+    sintheta = observer.sintheta;
+    costheta = observer.costheta;
+    obs_posx = observer.posx;
+    obs_posy = observer.posy;
+    obs_posz = observer.posz;
     obs_posw = sqrt(obs_posx * obs_posx + obs_posy * sat_posy + obs_posz * obs_posz);
     /*obs_velx = -MFACTOR * obs_posy;
     obs_vely = MFACTOR * obs_posx;
@@ -1190,31 +1239,13 @@ int Satellite::sgp4(double tsince)
 
     setAz(azimuth / DEG2RAD);
     setAlt(elevation / DEG2RAD);
-    HorizontalToEquatorial(data->lst(), data->geo()->lat());
+    HorizontalToEquatorial(observer.lst, observer.lat);
 
     // is the satellite visible ?
-    // Find ECI coordinates of the sun
-    double mjd, year, T, M, L, e, C, O, Lsa, nu, R, eps;
-
-    mjd  = jul_utc - 2415020.0;
-    year = 1900.0 + mjd / 365.25;
-    T    = (mjd + deltaET(year) / (MINPD * 60.0)) / 36525.0;
-    M    = DEG2RAD * (Modulus(358.47583 + Modulus(35999.04975 * T, 360.0) - (0.000150 + 0.0000033 * T) * T * T, 360.0));
-    L    = DEG2RAD * (Modulus(279.69668 + Modulus(36000.76892 * T, 360.0) + 0.0003025 * T * T, 360.0));
-    e    = 0.01675104 - (0.0000418 + 0.000000126 * T) * T;
-    C    = DEG2RAD * ((1.919460 - (0.004789 + 0.000014 * T) * T) * sin(M) + (0.020094 - 0.000100 * T) * sin(2 * M) +
-                      0.000293 * sin(3 * M));
-    O    = DEG2RAD * (Modulus(259.18 - 1934.142 * T, 360.0));
-    Lsa  = Modulus(L + C - DEG2RAD * (0.00569 - 0.00479 * sin(O)), TWOPI);
-    nu   = Modulus(M + C, TWOPI);
-    R    = 1.0000002 * (1.0 - e * e) / (1.0 + e * cos(nu));
-    eps  = DEG2RAD * (23.452294 - (0.0130125 + (0.00000164 - 0.000000503 * T) * T) * T + 0.00256 * cos(O));
-    R    = AU * R;
-
-    double sun_posx = R * cos(Lsa);
-    double sun_posy = R * sin(Lsa) * cos(eps);
-    double sun_posz = R * sin(Lsa) * sin(eps);
-    double sun_posw = R;
+    double sun_posx = observer.sun_posx;
+    double sun_posy = observer.sun_posy;
+    double sun_posz = observer.sun_posz;
+    double sun_posw = observer.sun_posw;
 
     // Calculates satellite's eclipse status and depth
     double sd_sun, sd_earth, delta, depth;
@@ -1232,10 +1263,9 @@ int Satellite::sgp4(double tsince)
     double earth_w = sat_posw;
     delta      = PIO2 - arcSin((sun_posx * earth_x + sun_posy * earth_y + sun_posz * earth_z) / (sun_posw * earth_w));
     depth      = sd_earth - sd_sun - delta;
-    KSSun *sun = dynamic_cast<KSSun *>(data->skyComposite()->findByName(i18n("Sun")));
 
     m_is_eclipsed = sd_earth >= sd_sun && depth >= 0;
-    m_is_visible  = !m_is_eclipsed && sun->alt().Degrees() <= -12.0 && elevation >= 0.0;
+    m_is_visible  = !m_is_eclipsed && observer.sun_alt <= -12.0 && elevation >= 0.0;
 
     return (0);
 }
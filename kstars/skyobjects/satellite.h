@@ -45,9 +45,41 @@ class Satellite : public SkyObject
         /** @short Destructor */
         virtual ~Satellite() override = default;
 
+        /**
+         * @struct Observer
+         * Observer and Sun geometry at the current clock time. It does not depend on the satellite,
+         * so it is computed once with currentObserver() and shared when propagating many satellites.
+         */
+        struct Observer
+        {
+            /// Current UTC as julian day
+            long double jd { 0 };
+            /// Observer latitude and local sidereal time
+            const CachingDms *lat { nullptr };
+            const CachingDms *lst { nullptr };
+            double sinlat { 0 }, coslat { 0 };
+            double sintheta { 0 }, costheta { 0 };
+            /// Observer ECI position (km)
+            double posx { 0 }, posy { 0 }, posz { 0 };
+            /// Sun ECI position (km)
+            double sun_posx { 0 }, sun_posy { 0 }, sun_posz { 0 }, sun_posw { 0 };
+            /// Sun altitude in degrees
+            double sun_alt { 0 };
+        };
+
+        /** @return the observer and Sun geometry at the current clock time */
+        static Observer currentObserver();
+
         /** @short Update satellite position */
         int updatePos();
 
+        /**
+         * @short Update satellite position for a precomputed observer
+         * @param observer geometry as returned by currentObserver()
+         * @return 0 on success, else an sgp4 error code
+         */
+        int updatePos(const Observer &observer);
+
         /**
          * @return True if the satellite is visible (above horizon, in the sunlight and sun at least 12° under horizon)
          */
@@ -88,7 +120,7 @@ class Satellite : public SkyObject
         void init();
 
         /** @short Compute satellite position */
-        int sgp4(double tsince);
+        int sgp4(double tsince, const Observer &observer);
 
         /** @return Arcsine of the argument */
         double arcSin(double arg);
@@ -99,10 +131,10 @@ class Satellite : public SkyObject
          * This function is based on a least squares fit of data from 1950
          * to 1991 and will need to be updated periodically.
          */
-        double deltaET(double year);
+        static double deltaET(double year);
 
         /** @return arg1 mod arg2 */
-        double Modulus(double arg1, double arg2);
+        static double Modulus(double arg1, double arg2);
 
         // TLE
         /// Satellite Number
@@ -22,6 +22,7 @@
 #include "skyobjects/satellite.h"
 
 #include <QTextStream>
+#include <QtConcurrent>
 
 SatelliteGroup::SatelliteGroup(const QString& name, const QString& tle_filename, const QUrl& update_url)
 {
@@ -62,19 +63,53 @@ void SatelliteGroup::readTLE()
 
 void SatelliteGroup::updateSatellitesPos()
 {
-    QMutableListIterator<Satellite *> sats(*this);
+    // Observer and Sun geometry are the same for every satellite
+    const Satellite::Observer observer = Satellite::currentObserver();
 
-    while (sats.hasNext())
+    QVector<Satellite *> sats;
+    for (Satellite *sat : *this)
     {
-        Satellite *sat = sats.next();
-
         if (sat->selected())
+            sats.append(sat);
+    }
+
+    if (sats.isEmpty())
+        return;
+
+    QVector<int> rcs(sats.size(), 0);
+
+    // Large groups (e.g. Starlink) are propagated on all cores, each satellite only writes its own state
+    const int nThreads = sats.size() < MIN_PARALLEL_SATELLITES ? 1 : QThread::idealThreadCount();
+    const int tStride  = sats.size() / nThreads;
+    const int fStride  = sats.size() - tStride * (nThreads - 1);
+
+    auto propagate = [&sats, &rcs, &observer](int cStart, int cEnd)
+    {
+        for (int i = cStart; i < cEnd; i++)
+            rcs[i] = sats[i]->updatePos(observer);
+    };
+
+    if (nThreads == 1)
+        propagate(0, sats.size());
+    else
+    {
+        QList<QFuture<void>> futures;
+        for (int i = 0; i < nThreads; i++)
         {
-            int rc = sat->updatePos();
-            // If position cannot be calculated, remove it from list
-            if (rc != 0)
-                sats.remove();
+            const int cStart = i * tStride;
+            const int cEnd   = cStart + ((i == (nThreads - 1)) ? fStride : tStride);
+            futures.append(QtConcurrent::run(propagate, cStart, cEnd));
         }
+
+        for (QFuture<void> &future : futures)
+            future.waitForFinished();
+    }
+
+    // If position cannot be calculated, remove it from list
+    for (int i = 0; i < sats.size(); i++)
+    {
+        if (rcs[i] != 0)
+            removeOne(sats[i]);
     }
 }
 
@@ -45,6 +45,8 @@ class SatelliteGroup : public QList<Satellite *>
 
     /**
      * Compute current position of the each satellites in the group.
+     * Large groups are propagated in parallel, satellites whose position cannot be
+     * computed are removed from the group.
      */
     void updateSatellitesPos();
 
@@ -64,6 +66,9 @@ class SatelliteGroup : public QList<Satellite *>
     QString name();
 
   private:
+    /// Groups with fewer selected satellites are propagated serially
+    static constexpr int MIN_PARALLEL_SATELLITES { 256 };
+
     /// Group name
     QString m_name;
     /// TLE filename
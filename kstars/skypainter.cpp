@@ -41,6 +41,17 @@ void SkyPainter::setSizeMagLimit(float sizeMagLim)
     m_sizeMagLim = sizeMagLim;
 }
 
+int SkyPainter::drawPointSources(const SkyPoint *const *locs, const float *mags, const char *sps, int count)
+{
+    int drawn = 0;
+    for (int i = 0; i < count; ++i)
+    {
+        if (drawPointSource(locs[i], mags[i], sps[i]))
+            ++drawn;
+    }
+    return drawn;
+}
+
 float SkyPainter::starWidth(float mag) const
 {
     //adjust maglimit for ZoomLevel
@@ -130,6 +130,16 @@ class SkyPainter
          */
     virtual bool drawPointSource(const SkyPoint *loc, float mag, char sp = 'A') = 0;
 
+        /**
+         * @short Draw many point sources at once, as drawPointSource() would draw each of them.
+         * @param locs array of count pointers to the locations of the sources in the sky
+         * @param mags array of count magnitudes of the sources
+         * @param sps array of count spectral classes of the sources
+         * @param count number of sources
+         * @return number of sources drawn
+         */
+        virtual int drawPointSources(const SkyPoint *const *locs, const float *mags, const char *sps, int count);
+
         /**
      * @short Draw a deep sky object (loaded from the new implementation)
      * @param obj the object to draw
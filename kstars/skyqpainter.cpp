@@ -598,6 +598,42 @@ bool SkyQPainter::drawPointSource(const SkyPoint *loc, float mag, char sp)
     }
 }
 
+int SkyQPainter::drawPointSources(const SkyPoint *const *locs, const float *mags, const char *sps, int count)
+{
+    // Same as drawPointSource() for each source, with the sources that may be visible projected together
+    m_sourceIndexes.clear();
+    m_sourcePoints.clear();
+    for (int i = 0; i < count; ++i)
+    {
+        if (m_proj->checkVisibility(locs[i]))
+        {
+            m_sourceIndexes.append(i);
+            m_sourcePoints.append(locs[i]);
+        }
+    }
+
+    const int n = m_sourcePoints.size();
+    m_sourceScreen.resize(n);
+    m_sourceVisible.fill(false, n);
+    m_proj->toScreenVecs(m_sourcePoints.constData(), n, m_sourceScreen.data(), true, m_sourceVisible.data());
+
+    int drawn = 0;
+    for (int j = 0; j < n; ++j)
+    {
+        if (!m_sourceVisible.at(j))
+            continue;
+
+        QPointF pos = KSUtils::vecToPoint(m_sourceScreen.at(j));
+        if (m_proj->onScreen(pos))
+        {
+            const int i = m_sourceIndexes.at(j);
+            drawPointSource(pos, starWidth(mags[i]), sps[i]);
+            ++drawn;
+        }
+    }
+    return drawn;
+}
+
 void SkyQPainter::drawPointSource(const QPointF &pos, float size, char sp)
 {
     int isize = qMin(static_cast<int>(size), 14);
@@ -21,6 +21,8 @@
 
 #include "skypainter.h"
 
+#include <Eigen/Core>
+
 #include <QColor>
 #include <QMap>
 
@@ -88,6 +90,7 @@ class SkyQPainter : public SkyPainter, public QPainter
                          LineListLabel *label = nullptr) override;
     void drawSkyPolygon(LineList *list, bool forceClip = true) override;
     bool drawPointSource(const SkyPoint *loc, float mag, char sp = 'A') override;
+    int drawPointSources(const SkyPoint *const *locs, const float *mags, const char *sps, int count) override;
     bool drawCatalogObject(const CatalogObject &obj) override;
     void drawCatalogObjectImage(const QPointF &pos, const CatalogObject &obj,
                                 float positionAngle);
@@ -115,6 +118,11 @@ class SkyQPainter : public SkyPainter, public QPainter
     HIPSRenderer *m_hipsRender{ nullptr };
     TerrainRenderer *m_terrainRender{ nullptr };
     QSize m_size;
+    // Buffers of drawPointSources(), kept to avoid allocations in each call
+    QVector<int> m_sourceIndexes;
+    QVector<const SkyPoint *> m_sourcePoints;
+    QVector<Eigen::Vector2f> m_sourceScreen;
+    QVector<bool> m_sourceVisible;
     static int starColorMode;
     static QColor m_starColor;
     static QMap<char, QColor> ColorMap;
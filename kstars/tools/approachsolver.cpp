@@ -57,7 +57,7 @@ QMap<long double, dms> ApproachSolver::findClosestApproach(long double startJD,
     long double jd = startJD;
     prevDist       = updateAndFindDistance(jd);
     jd += step;
-    while (jd <= stopJD)
+    while (jd <= stopJD && !isAborted())
     {
         int progress = int(100.0 * (jd - startJD) / (stopJD - startJD));
         emit solverMadeProgress(progress);
@@ -22,6 +22,7 @@
 
 #include <QObject>
 #include <QMap>
+#include <atomic>
 #include <memory>
 
 /**
@@ -75,6 +76,12 @@ public:
     void setMaxSeparation(double sep) { m_maxSeparation = sep; }
     void setMaxSeparation(dms sep) { m_maxSeparation = sep.radians(); }
 
+    /**
+     * @brief setAbortFlag
+     * @param flag - once raised, possibly from another thread, findClosestApproach returns the approaches found so far
+     */
+    void setAbortFlag(const std::atomic<bool> *flag) { m_abortFlag = flag; }
+
 signals:
     /**
      * @brief solverMadeProgress
@@ -156,6 +163,12 @@ private:
      */
     int sgn(dms a);
 
+    /**
+     * @return true if the abort flag is set and raised
+     */
+    bool isAborted() const { return m_abortFlag != nullptr && *m_abortFlag; }
+
     GeoLocation * m_geoPlace { nullptr };
     double m_maxSeparation;
+    const std::atomic<bool> *m_abortFlag { nullptr };
 };
@@ -38,7 +38,6 @@
 #include "ksplanetbase.h"
 
 #include <QFileDialog>
-#include <QProgressDialog>
 #include <QStandardItemModel>
 #include <QtConcurrent>
 
@@ -86,9 +85,11 @@ ConjunctionsTool::ConjunctionsTool(QWidget *parentSplit) : QFrame(parentSplit)
     connect(ModeSelector, static_cast<void (QComboBox::*)(int)>(&QComboBox::currentIndexChanged), this, &ConjunctionsTool::setMode);
 
     //connect(ComputeButton, SIGNAL(clicked()), this, SLOT(slotCompute()));
-    connect(ComputeButton, &QPushButton::clicked, [this]()
+    connect(ComputeButton, &QPushButton::clicked, this, &ConjunctionsTool::slotCompute);
+    connect(&m_ComputeWatcher, &QFutureWatcherBase::finished, this, &ConjunctionsTool::slotComputeFinished);
+    connect(AbortButton, &QPushButton::clicked, [this]()
     {
-        QtConcurrent::run(this, &ConjunctionsTool::slotCompute);
+        m_Abort = true;
     });
     connect(FilterTypeComboBox, SIGNAL(currentIndexChanged(int)), SLOT(slotFilterType(int)));
     connect(ClearButton, SIGNAL(clicked()), this, SLOT(slotClear()));
@@ -141,6 +142,12 @@ ConjunctionsTool::ConjunctionsTool(QWidget *parentSplit) : QFrame(parentSplit)
     show();
 }
 
+ConjunctionsTool::~ConjunctionsTool()
+{
+    m_Abort = true;
+    m_ComputeWatcher.waitForFinished();
+}
+
 void ConjunctionsTool::slotGoto()
 {
     int index      = m_SortModel->mapToSource(OutputList->currentIndex()).row(); // Get the number of the line
@@ -245,6 +252,9 @@ void ConjunctionsTool::slotFilterReg(const QString &filter)
 
 void ConjunctionsTool::slotCompute(void)
 {
+    if (m_ComputeWatcher.isRunning())
+        return;
+
     KStarsDateTime dtStart(startDate->dateTime()); // Start date
     KStarsDateTime dtStop(stopDate->dateTime());  // Stop date
     long double startJD    = dtStart.djd();         // Start julian day
@@ -254,7 +264,7 @@ void ConjunctionsTool::slotCompute(void)
         opposition = true;
     QStringList objects; // List of sky object used as Object1
     KStarsData *data = KStarsData::Instance();
-    int progress     = 0;
+    int const planet = Obj2ComboBox->currentIndex();
 
     // Check if we have a valid angle in maxSeparationBox
     dms maxSeparation(0.0);
@@ -274,7 +284,7 @@ void ConjunctionsTool::slotCompute(void)
         KSNotification::sorry(i18n("Please select an object to check conjunctions with, by clicking on the \'Find Object\' button."));
         return;
     }
-    Object2.reset(KSPlanetBase::createPlanet(Obj2ComboBox->currentIndex()));
+    Object2.reset(KSPlanetBase::createPlanet(planet));
     if (FilterTypeComboBox->currentIndex() == 0 && Object1->name() == Object2->name())
     {
         // FIXME: Must free the created Objects
@@ -282,11 +292,6 @@ void ConjunctionsTool::slotCompute(void)
         return;
     }
 
-    // Init KSConjunct object
-    KSConjunct ksc;
-    connect(&ksc, SIGNAL(madeProgress(int)), this, SLOT(showProgress(int)));
-    ksc.setGeoLocation(geoPlace);
-
     switch (FilterTypeComboBox->currentIndex())
     {
         case 1: // All object types
@@ -353,54 +358,146 @@ void ConjunctionsTool::slotCompute(void)
         objects.removeAll("Iapetus");
     }
 
-    ksc.setMaxSeparation(maxSeparation);
-    ksc.setObject2(Object2);
-    ksc.setOpposition(opposition);
+    m_Abort = false;
+
+    // Change cursor while we search for conjunction
+    QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
+
+    ComputeStack->setCurrentIndex(1);
 
+    // Clone the candidates beforehand, the sky composite is not searched from several threads
+    QStringList names;
+    QList<SkyObject_s> candidates;
     if (FilterTypeComboBox->currentIndex() != 0)
     {
-        // Show a progress dialog while processing
-        QProgressDialog progressDlg(i18n("Compute conjunction..."), i18n("Abort"), 0, objects.count(), this);
-        progressDlg.setWindowTitle(i18n("Conjunction"));
-        progressDlg.setWindowModality(Qt::WindowModal);
-        progressDlg.setValue(0);
+        showProgress(0);
 
         for (auto &object : objects)
         {
-            // If the user click on the 'cancel' button
-            if (progressDlg.wasCanceled())
-                break;
-
-            // Update progress dialog
-            ++progress;
-            progressDlg.setValue(progress);
-            progressDlg.setLabelText(i18n("Compute conjunction between %1 and %2", Object2->name(), object));
-
-            // Compute conjuction
-            Object1 = std::shared_ptr<SkyObject>(data->skyComposite()->findByName(object)->clone());
-            ksc.setObject1(Object1);
-            showConjunctions(ksc.findClosestApproach(startJD, stopJD),
-                             object, Object2->name());
+            SkyObject *found = data->skyComposite()->findByName(object);
+            if (found == nullptr)
+                continue;
+            names.append(object);
+            candidates.append(SkyObject_s(found->clone()));
         }
-
-        progressDlg.setValue(objects.count());
     }
     else
     {
-        // Change cursor while we search for conjunction
-        QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
+        names.append(Object1->name());
+        candidates.append(Object1);
+    }
+
+    // The search runs in the background, results are shown by slotComputeFinished() in the GUI thread
+    KSPlanetBase_s object2 = Object2;
+    GeoLocation *geo = geoPlace;
+    bool const singleObject = FilterTypeComboBox->currentIndex() == 0;
+    m_ComputeWatcher.setFuture(QtConcurrent::run([ = ]()
+    {
+        return findConjunctions(names, candidates, singleObject, object2, planet, geo, maxSeparation, opposition,
+                                startJD, stopJD);
+    }));
+}
+
+QVector<ConjunctionsTool::Conjunctions> ConjunctionsTool::findConjunctions(const QStringList &names,
+        const QList<SkyObject_s> &candidates, bool singleObject, const KSPlanetBase_s &object2, int planet,
+        GeoLocation *geo, const dms &maxSeparation, bool opposition, long double startJD, long double stopJD)
+{
+    // Init KSConjunct object
+    KSPlanetBase_s planet2 = object2;
+    KSConjunct ksc;
+    ksc.setGeoLocation(geo);
+    ksc.setMaxSeparation(maxSeparation);
+    ksc.setObject2(planet2);
+    ksc.setOpposition(opposition);
+    ksc.setAbortFlag(&m_Abort);
+
+    int const count = candidates.size();
+    QVector<Conjunctions> results(count);
+    Conjunctions *resultsData = results.data();
+    for (int i = 0; i < count; i++)
+        resultsData[i].object1 = names.at(i);
+
+    if (singleObject)
+    {
+        connect(&ksc, &KSConjunct::madeProgress, this, &ConjunctionsTool::showProgress);
+
+        SkyObject_s object1 = candidates.first();
+        ksc.setObject1(object1);
+        resultsData[0].approaches = ksc.findClosestApproach(startJD, stopJD);
+        return results;
+    }
+
+    QAtomicInt next(0), done(0);
+
+    // Each thread searches with its own solver and planet, and picks the next candidate when done with one
+    auto searchCandidates = [&](KSConjunct &solver)
+    {
+        for (int i = next.fetchAndAddOrdered(1); i < count && !m_Abort; i = next.fetchAndAddOrdered(1))
+        {
+            SkyObject_s object1 = candidates.at(i);
+            solver.setObject1(object1);
+            resultsData[i].approaches = solver.findClosestApproach(startJD, stopJD);
+
+            int const progress = 100 * (done.fetchAndAddOrdered(1) + 1) / count;
+            QMetaObject::invokeMethod(this, "showProgress", Qt::QueuedConnection, Q_ARG(int, progress));
+        }
+    };
 
-        ComputeStack->setCurrentIndex(1);
+    // Search the first candidate alone, this loads the orbital data that the threads then share
+    if (0 < count)
+    {
+        SkyObject_s object1 = candidates.first();
+        ksc.setObject1(object1);
+        resultsData[0].approaches = ksc.findClosestApproach(startJD, stopJD);
+        next = 1;
+        done = 1;
+    }
 
-        ksc.setObject1(Object1);
-        showConjunctions(ksc.findClosestApproach(startJD, stopJD),
-                         Object1->name(), Object2->name());
-        ComputeStack->setCurrentIndex(0);
+    // Solvers and planets are set up here, this thread is one of the search threads
+    int const nThreads = std::max(1, QThread::idealThreadCount());
+    std::vector<std::unique_ptr<KSConjunct>> solvers;
+    QList<KSPlanetBase_s> planets;
+    for (int i = 1; i < nThreads; i++)
+    {
+        planets.append(KSPlanetBase_s(KSPlanetBase::createPlanet(planet)));
+
+        solvers.emplace_back(new KSConjunct());
+        solvers.back()->setGeoLocation(geo);
+        solvers.back()->setMaxSeparation(maxSeparation);
+        solvers.back()->setObject2(planets.last());
+        solvers.back()->setOpposition(opposition);
+        solvers.back()->setAbortFlag(&m_Abort);
+    }
 
-        // Restore cursor
-        QApplication::restoreOverrideCursor();
+    QList<QFuture<void>> futures;
+    for (auto &solver : solvers)
+    {
+        KSConjunct *threadSolver = solver.get();
+        futures.append(QtConcurrent::run([&searchCandidates, threadSolver]()
+        {
+            searchCandidates(*threadSolver);
+        }));
     }
 
+    searchCandidates(ksc);
+
+    for (auto &future : futures)
+        future.waitForFinished();
+
+    return results;
+}
+
+void ConjunctionsTool::slotComputeFinished()
+{
+    // Show the results in the order of the candidates, whatever the thread which found them
+    for (const auto &conjunctions : m_ComputeWatcher.result())
+        showConjunctions(conjunctions.approaches, conjunctions.object1, Object2->name());
+
+    ComputeStack->setCurrentIndex(0);
+
+    // Restore cursor
+    QApplication::restoreOverrideCursor();
+
     Object2.reset();
 }
 
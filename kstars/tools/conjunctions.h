@@ -28,9 +28,12 @@
 #include "ui_conjunctions.h"
 
 #include <QFrame>
+#include <QFutureWatcher>
 #include <QMap>
 #include <QString>
+#include <QVector>
 #include "skycomponents/typedef.h"
+#include <atomic>
 #include <memory>
 
 class QSortFilterProxyModel;
@@ -51,7 +54,7 @@ class ConjunctionsTool : public QFrame, public Ui::ConjunctionsDlg
 
   public:
     explicit ConjunctionsTool(QWidget *p);
-    virtual ~ConjunctionsTool() override = default;
+    virtual ~ConjunctionsTool() override;
 
   public slots:
 
@@ -66,7 +69,28 @@ class ConjunctionsTool : public QFrame, public Ui::ConjunctionsDlg
     void slotExport();
     void slotFilterReg(const QString &);
 
+  private slots:
+    /** Show the results of the search started by slotCompute() */
+    void slotComputeFinished();
+
   private:
+    /// Closest approaches found between one candidate and the planet
+    struct Conjunctions
+    {
+        QString object1;
+        QMap<long double, dms> approaches;
+    };
+
+    /**
+     * @short Search the closest approaches of each candidate to the planet, in the background.
+     * Only the single object search reports its progress through its solver, searches against
+     * several candidates run on all cores.
+     */
+    QVector<Conjunctions> findConjunctions(const QStringList &names, const QList<SkyObject_s> &candidates,
+                                           bool singleObject, const KSPlanetBase_s &object2, int planet,
+                                           GeoLocation *geo, const dms &maxSeparation, bool opposition,
+                                           long double startJD, long double stopJD);
+
     void showConjunctions(const QMap<long double, dms> &conjunctionlist, const QString &object1,
                           const QString &object2);
 
@@ -96,4 +120,8 @@ class ConjunctionsTool : public QFrame, public Ui::ConjunctionsDlg
     QStandardItemModel *m_Model { nullptr };
     QSortFilterProxyModel *m_SortModel { nullptr };
     int m_index { 0 };
+    /// Raised by the abort button to stop the search in progress
+    std::atomic<bool> m_Abort { false };
+    /// Watches the search started by slotCompute()
+    QFutureWatcher<QVector<Conjunctions>> m_ComputeWatcher;
 };
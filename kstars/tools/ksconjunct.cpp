@@ -31,7 +31,7 @@ KSConjunct::KSConjunct() : ApproachSolver ()
 
 dms KSConjunct::findDistance()
 {
-    dms dist = findSkyPointDistance(m_object1.get(), m_object2.get());
+    dms dist = findSkyPointDistance(m_object1.get(), &m_object2Position);
     if (m_opposition)
     {
         dist.setD(180 - dist.Degrees());
@@ -42,19 +42,40 @@ dms KSConjunct::findDistance()
 
 void KSConjunct::updatePositions(long double jd)
 {
-    KStarsDateTime t(jd);
-    KSNumbers num(jd);
+    // Earth and the second object are the same whatever the first object, and searches against many
+    // objects probe the same dates, so keep their positions from one search to the next.
+    if (m_ephemeridesGeo != getGeoLocation())
+    {
+        m_ephemerides.clear();
+        m_ephemeridesGeo = getGeoLocation();
+    }
+
+    std::shared_ptr<const Ephemeris> ephemeris = m_ephemerides.value(jd);
+    if (!ephemeris)
+    {
+        KStarsDateTime t(jd);
+        auto update = std::make_shared<Ephemeris>(jd, m_Earth);
+
+        update->earth.findPosition(&update->num);
+        update->LST = getGeoLocation()->GSTtoLST(t.gst());
 
-    m_Earth.findPosition(&num);
-    CachingDms LST(getGeoLocation()->GSTtoLST(t.gst()));
+        m_object2->findPosition(&update->num, getGeoLocation()->lat(), &update->LST, &update->earth);
+        update->object2 = SkyPoint(m_object2->ra(), m_object2->dec());
+
+        if (m_ephemerides.size() >= MAX_EPHEMERIDES)
+            m_ephemerides.clear();
+        m_ephemerides.insert(jd, update);
+        ephemeris = update;
+    }
+
+    m_Earth = ephemeris->earth;
+    m_object2Position = ephemeris->object2;
 
     KSPlanetBase *p = dynamic_cast<KSPlanetBase*>(m_object1.get());
     if (p)
-        p->findPosition(&num, getGeoLocation()->lat(), &LST, &m_Earth);
+        p->findPosition(&ephemeris->num, getGeoLocation()->lat(), &ephemeris->LST, &m_Earth);
     else
-        m_object1->updateCoordsNow(&num);
-
-    m_object2->findPosition(&num, getGeoLocation()->lat(), &LST, &m_Earth);
+        m_object1->updateCoordsNow(&ephemeris->num);
 }
 
 double KSConjunct::findInitialStep(long double startJD, long double stopJD)
@@ -17,6 +17,10 @@
 
 #pragma once
 #include "approachsolver.h"
+#include "ksnumbers.h"
+
+#include <QMap>
+#include <memory>
 
 class GeoLocation;
 class KSPlanetBase;
@@ -40,7 +44,7 @@ public:
     KSConjunct();
 
     void setObject1(SkyObject_s &obj) { m_object1 = obj; }
-    void setObject2(KSPlanetBase_s &obj) { m_object2 = obj; }
+    void setObject2(KSPlanetBase_s &obj) { m_object2 = obj; m_ephemerides.clear(); }
     void setOpposition(bool opposition) { m_opposition = opposition; }
 
 signals:
@@ -53,9 +57,29 @@ protected:
 private:
     dms findDistance() override;
 
+    /**
+     * @short Positions that do not depend on the first object, shared by the searches of all first objects
+     * at a given date.
+     */
+    struct Ephemeris
+    {
+        Ephemeris(long double jd, const KSPlanet &earth) : num(jd), earth(earth) {}
+
+        KSNumbers num;
+        CachingDms LST;
+        KSPlanet earth;
+        SkyPoint object2;
+    };
+
+    /// Maximum number of dates kept in m_ephemerides
+    static constexpr int MAX_EPHEMERIDES { 4096 };
 
     SkyObject_s m_object1;
     KSPlanetBase_s m_object2;
+    SkyPoint m_object2Position;
     bool m_opposition { false };
+
+    QMap<long double, std::shared_ptr<const Ephemeris>> m_ephemerides;
+    GeoLocation *m_ephemeridesGeo { nullptr };
 };
 